@@ -15,6 +15,7 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "ch.h"
 #include "hal.h"
@@ -48,20 +49,42 @@ static void cmd_mem(BaseSequentialStream *chp, int argc, char *argv[]) {
 
 static void cmd_threads(BaseSequentialStream *chp, int argc, char *argv[]) {
   static const char *states[] = {THD_STATE_NAMES};
+  bool_t verbose = FALSE;
   Thread *tp;
 
   (void)argv;
-  if (argc > 0) {
+#if CH_DBG_THREADS_ACCOUNTING
+  verbose = (argc == 1) && (strcmp(argv[0], "-v") == 0);
+#endif
+  if ((argc > 0) && !verbose) {
+#if CH_DBG_THREADS_ACCOUNTING
+    chprintf(chp, "Usage: threads [-v]\r\n");
+#else
     chprintf(chp, "Usage: threads\r\n");
+#endif
     return;
   }
-  chprintf(chp, "    addr    stack prio refs     state time\r\n");
+  chprintf(chp, "    addr    stack prio refs     state time");
+  chprintf(chp, verbose ? "     runtime(s)    load\r\n" : "\r\n");
   tp = chRegFirstThread();
   do {
-    chprintf(chp, "%.8lx %.8lx %4lu %4lu %9s %lu\r\n",
-            (uint32_t)tp, (uint32_t)tp->p_ctx.esp,
-            (uint32_t)tp->p_prio, (uint32_t)(tp->p_refs - 1),
-            states[tp->p_state], (uint32_t)tp->p_time);
+    chprintf(chp, "%.8lx %.8lx %4lu %4lu %9s %lu",
+            (unsigned long)tp, (unsigned long)port_thread_sp(tp),
+            (unsigned long)tp->p_prio, (unsigned long)(tp->p_refs - 1),
+            states[tp->p_state], (unsigned long)tp->p_time);
+#if CH_DBG_THREADS_ACCOUNTING
+    if (verbose) {
+      uint32_t f = chDbgGetRunTimeFrequency();
+      uint64_t rt = chRegGetThreadRunTime(tp);
+      uint16_t load = chRegGetThreadLoad(tp);
+
+      chprintf(chp, " %7lu.%06lu %3u.%02u%%",
+               (unsigned long)(rt / f),
+               (unsigned long)(((rt % f) * 1000000) / f),
+               load / 100, load % 100);
+    }
+#endif
+    chprintf(chp, "\r\n");
     tp = chRegNextThread(tp);
   } while (tp != NULL);
 }
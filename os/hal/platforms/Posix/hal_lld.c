@@ -22,13 +22,25 @@
  * @{
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
+#include <time.h>
 
 #include "ch.h"
 #include "hal.h"
 
+#if defined(__linux__)
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#elif CH_TIMEDELTA > 0
+#error "tick-less mode requires a Linux host"
+#endif
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -37,40 +49,436 @@
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
 
+#if !defined(__linux__)
 static struct timeval nextcnt;
 static struct timeval tick = {0, 1000000 / CH_FREQUENCY};
+#else
+/**
+ * @brief   Host time corresponding to the system time zero.
+ */
+static struct timespec basetime;
+
+/**
+ * @brief   Timer file descriptor used as alarm source.
+ */
+static int alarmfd = -1;
+
+/**
+ * @brief   Event sources the idle thread blocks on.
+ */
+static int epollfd = -1;
+
+/**
+ * @brief   Virtual time mode enabled.
+ */
+static bool_t virtualtime;
+
+/**
+ * @brief   Nanoseconds skipped by the virtual time mode.
+ * @details The simulated time is the host time plus this offset.
+ */
+static uint64_t skipped;
+
+#if CH_TIMEDELTA == 0
+/**
+ * @brief   Number of ticks already processed.
+ */
+static uint64_t lastticks;
+#else
+/**
+ * @brief   Alarm armed flag.
+ */
+static bool_t alarmarmed;
+
+/**
+ * @brief   Alarm time, valid if @p alarmarmed is @p TRUE.
+ */
+static systime_t alarmtime;
+#endif
+
+/**
+ * @brief   Events file being recorded or @p NULL.
+ */
+static FILE *recordfp;
+
+/**
+ * @brief   Events file being replayed or @p NULL.
+ */
+static FILE *replayfp;
+
+/**
+ * @brief   Simulated time in ticks while recording or replaying.
+ * @details The time only changes at the start of a poll, the events are
+ *          keyed to the tick they happened in.
+ */
+static uint64_t curticks;
+
+/**
+ * @brief   Tick of the last event recorded or fetched.
+ */
+static uint64_t evtick;
+
+/**
+ * @brief   Number of events recorded or fetched in @p evtick.
+ */
+static unsigned evcount;
+
+/**
+ * @brief   Next event to be replayed.
+ */
+static struct {
+  bool_t        valid;
+  uint64_t      tick;
+  unsigned      ordinal;
+  unsigned      type;
+  unsigned      chan;
+  ssize_t       result;
+  size_t        size;
+  uint8_t       data[SIM_EVENT_DATA_SIZE];
+} nextev;
+#endif
 
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
-/*===========================================================================*/
-/* Driver interrupt handlers.                                                */
-/*===========================================================================*/
+#if defined(__linux__)
+/**
+ * @brief   Returns the host nanoseconds elapsed since @p basetime.
+ * @note    The time skipped by the virtual time mode is included.
+ */
+static uint64_t host_ns(void) {
+  struct timespec ts;
 
-/*===========================================================================*/
-/* Driver exported functions.                                                */
-/*===========================================================================*/
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)((int64_t)(ts.tv_sec - basetime.tv_sec) * 1000000000LL +
+                    (ts.tv_nsec - basetime.tv_nsec)) + skipped;
+}
 
 /**
- * @brief Low level HAL driver initialization.
+ * @brief   Returns the host ticks elapsed since @p basetime.
+ * @note    The returned value is not truncated to the @p systime_t range.
  */
-void hal_lld_init(void) {
+static uint64_t host_ticks(void) {
+  uint64_t ns = host_ns();
 
-#if defined(__APPLE__)
-  puts("ChibiOS/RT simulator (OS X)\n");
+  return (ns / 1000000000ULL) * CH_FREQUENCY +
+         ((ns % 1000000000ULL) * CH_FREQUENCY) / 1000000000ULL;
+}
+
+/**
+ * @brief   Returns the first simulated nanosecond of a tick.
+ *
+ * @param[in] t         the tick number
+ */
+static uint64_t tick_to_ns(uint64_t t) {
+
+  return (t / CH_FREQUENCY) * 1000000000ULL +
+         ((t % CH_FREQUENCY) * 1000000000ULL + CH_FREQUENCY - 1) /
+         CH_FREQUENCY;
+}
+
+/**
+ * @brief   Returns the simulated nanoseconds elapsed since @p basetime.
+ * @note    While recording or replaying the simulated time has a tick
+ *          resolution.
+ */
+static uint64_t get_ns(void) {
+
+  if ((recordfp != NULL) || (replayfp != NULL))
+    return tick_to_ns(curticks);
+  return host_ns();
+}
+
+/**
+ * @brief   Returns the number of ticks elapsed since @p basetime.
+ * @note    The returned value is not truncated to the @p systime_t range.
+ */
+static uint64_t get_ticks(void) {
+
+  if ((recordfp != NULL) || (replayfp != NULL))
+    return curticks;
+  return host_ticks();
+}
+
+/**
+ * @brief   Returns the tick number of the next occurrence of a system time.
+ * @details System times in the recent past are considered already reached
+ *          and return the current tick number.
+ *
+ * @param[in] time      the system time
+ */
+static uint64_t next_tick(systime_t time) {
+  uint64_t now;
+  systime_t delta;
+
+  now = get_ticks();
+  delta = (systime_t)(time - (systime_t)now);
+  /* Deadlines in the recent past wrap to very large deltas.*/
+  if (delta > (systime_t)-1 / 2)
+    delta = 0;
+  return now + delta;
+}
+
+/**
+ * @brief   Arms the alarm on an absolute time.
+ * @details The time is converted in the first host time whose tick count
+ *          is equal or greater than the specified system time, if the time
+ *          has already passed then the alarm expires immediately.
+ *
+ * @param[in] time      the alarm time
+ */
+static void arm_alarm(systime_t time) {
+  struct itimerspec its;
+  uint64_t ns;
+
+  ns = tick_to_ns(next_tick(time));
+  ns = ns > skipped ? ns - skipped : 0;
+  its.it_interval.tv_sec  = 0;
+  its.it_interval.tv_nsec = 0;
+  its.it_value.tv_sec     = basetime.tv_sec + (time_t)(ns / 1000000000ULL);
+  its.it_value.tv_nsec    = basetime.tv_nsec + (long)(ns % 1000000000ULL);
+  if (its.it_value.tv_nsec >= 1000000000L) {
+    its.it_value.tv_sec++;
+    its.it_value.tv_nsec -= 1000000000L;
+  }
+  timerfd_settime(alarmfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+/**
+ * @brief   Advances the simulated time to the start of a tick.
+ * @details Used by the virtual time mode, the time is never moved back.
+ *
+ * @param[in] t         the tick number
+ */
+static void skip_to(uint64_t t) {
+  uint64_t ns = tick_to_ns(t), now = host_ns();
+
+  if (ns > now)
+    skipped += ns - now;
+}
+
+/**
+ * @brief   Writes a variable length unsigned integer.
+ */
+static void put_varint(FILE *fp, uint64_t v) {
+
+  while (v >= 0x80) {
+    fputc((int)(v & 0x7F) | 0x80, fp);
+    v >>= 7;
+  }
+  fputc((int)v, fp);
+}
+
+/**
+ * @brief   Reads a variable length unsigned integer.
+ *
+ * @return              The operation status.
+ * @retval FALSE        if the file ended or the value is malformed.
+ */
+static bool_t get_varint(FILE *fp, uint64_t *vp) {
+  unsigned shift = 0;
+  uint64_t v = 0;
+  int c;
+
+  do {
+    if (((c = fgetc(fp)) == EOF) || (shift > 63))
+      return FALSE;
+    v |= (uint64_t)(c & 0x7F) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  *vp = v;
+  return TRUE;
+}
+
+/**
+ * @brief   Appends an event to the events file.
+ * @details The record is the number of ticks since the previous event, the
+ *          ordinal of the event within its tick, a byte containing the
+ *          type and the channel, the result and the received data, if any.
+ */
+static void record_event(unsigned type, unsigned chan, ssize_t result,
+                         const void *data) {
+
+  put_varint(recordfp, curticks - evtick);
+  if (curticks != evtick) {
+    evtick = curticks;
+    evcount = 0;
+  }
+  put_varint(recordfp, evcount++);
+  fputc((int)(type | (chan << 4)), recordfp);
+  put_varint(recordfp, (uint64_t)(result + 1));
+  if ((type == SIM_EVENT_RECV) && (result > 0))
+    fwrite(data, 1, (size_t)result, recordfp);
+}
+
+/**
+ * @brief   Closes the events file on exit.
+ */
+static void record_end(void) {
+
+  record_event(SIM_EVENT_END, 0, 0, NULL);
+  fclose(recordfp);
+  recordfp = NULL;
+}
+
+/**
+ * @brief   Fetches the next event to be replayed.
+ * @details An event with an unexpected ordinal is considered malformed and
+ *          ends the replay.
+ */
+static void replay_fetch(void) {
+  uint64_t delta, ordinal, result;
+  int c;
+
+  nextev.valid = FALSE;
+  if (!get_varint(replayfp, &delta) || !get_varint(replayfp, &ordinal) ||
+      ((c = fgetc(replayfp)) == EOF) || !get_varint(replayfp, &result))
+    return;
+  if (delta > 0)
+    evcount = 0;
+  if (ordinal != evcount++)
+    return;
+  nextev.tick    = evtick += delta;
+  nextev.ordinal = (unsigned)ordinal;
+  nextev.type    = (unsigned)c & 15;
+  nextev.chan    = (unsigned)c >> 4;
+  nextev.result  = (ssize_t)result - 1;
+  nextev.size    = 0;
+  if ((nextev.type == SIM_EVENT_RECV) && (nextev.result > 0)) {
+    nextev.size = (size_t)nextev.result;
+    if ((nextev.size > sizeof nextev.data) ||
+        (fread(nextev.data, 1, nextev.size, replayfp) != nextev.size))
+      return;
+  }
+  nextev.valid = TRUE;
+}
+
+/**
+ * @brief   Starts an interrupt sources poll.
+ * @details While recording or replaying the simulated time is sampled
+ *          once per poll, the recorded events become due for injection
+ *          when the sampled time reaches their tick.
+ */
+static void poll_start(void) {
+
+  if ((recordfp != NULL) || (replayfp != NULL)) {
+    uint64_t t = host_ticks();
+
+    if (t > curticks)
+      curticks = t;
+  }
+}
+
+/**
+ * @brief   Returns the tick of the next virtual timer or alarm expiration.
+ *
+ * @param[out] tp       the tick of the next expiration
+ * @return              The expiration state.
+ * @retval FALSE        if there is no virtual timer or alarm armed.
+ * @retval TRUE         if an expiration is pending.
+ */
+static bool_t next_expiration(uint64_t *tp) {
+#if CH_TIMEDELTA == 0
+  systime_t delta;
+  bool_t armed;
+
+  chSysLock();
+  armed = chVTGetNextDeltaI(&delta);
+  chSysUnlock();
+  if (armed)
+    *tp = lastticks + delta;
+  return armed;
 #else
-  puts("ChibiOS/RT simulator (Linux)\n");
+  if (alarmarmed)
+    *tp = next_tick(alarmtime);
+  return alarmarmed;
 #endif
-  gettimeofday(&nextcnt, NULL);
-  timeradd(&nextcnt, &tick, &nextcnt);
 }
 
 /**
- * @brief Interrupt simulation.
+ * @brief   Advances the replay while the system is idle.
+ * @details The replay is completed when the end of the recording is
+ *          reached. A due event the idle system has not requested is
+ *          dropped because the system took a different path than in the
+ *          recording. Otherwise the simulated time skips to the next event
+ *          or to the next expiration, whichever comes first.
  */
-void ChkIntSources(void) {
+static void replay_idle(void) {
+  uint64_t t;
+
+  if (!nextev.valid ||
+      ((nextev.type == SIM_EVENT_END) && (nextev.tick <= curticks))) {
+    puts("Replay completed");
+    exit(0);
+  }
+  if (nextev.tick <= curticks) {
+    fprintf(stderr, "Replay: event %llu.%u not requested, dropped\n",
+            (unsigned long long)nextev.tick, nextev.ordinal);
+    replay_fetch();
+    return;
+  }
+  if (!next_expiration(&t) || (t > nextev.tick))
+    t = nextev.tick;
+  skip_to(t);
+}
+
+/**
+ * @brief   Opens the events file for recording or replay.
+ */
+static void events_init(void) {
+  const char *fn;
+  uint8_t hdr[10] = {'C', 'H', 'S', 'E', SIM_EVENTS_VERSION,
+                     CH_TIMEDELTA > 0,
+                     (uint8_t)(CH_FREQUENCY),
+                     (uint8_t)(CH_FREQUENCY >> 8),
+                     (uint8_t)(CH_FREQUENCY >> 16),
+                     (uint8_t)(CH_FREQUENCY >> 24)};
+
+  if ((fn = getenv(SIM_REPLAY_ENV)) != NULL) {
+    uint8_t fhdr[sizeof hdr];
+
+    if ((replayfp = fopen(fn, "rb")) == NULL) {
+      perror(fn);
+      exit(1);
+    }
+    if ((fread(fhdr, 1, sizeof fhdr, replayfp) != sizeof fhdr) ||
+        (memcmp(fhdr, hdr, sizeof hdr) != 0)) {
+      fprintf(stderr, "%s: not an events file for this configuration\n", fn);
+      exit(1);
+    }
+    replay_fetch();
+    printf("Replaying events from %s\n\n", fn);
+  }
+  else if ((fn = getenv(SIM_RECORD_ENV)) != NULL) {
+    if ((recordfp = fopen(fn, "wb")) == NULL) {
+      perror(fn);
+      exit(1);
+    }
+    fwrite(hdr, 1, sizeof hdr, recordfp);
+    atexit(record_end);
+    printf("Recording events to %s\n\n", fn);
+  }
+}
+#endif /* defined(__linux__) */
+
+/**
+ * @brief   Processes the pending interrupt sources.
+ *
+ * @return              The interrupt sources state.
+ * @retval FALSE        if there was nothing to process.
+ * @retval TRUE         if at least one interrupt source has been served.
+ */
+static bool_t process_sources(void) {
+#if !defined(__linux__)
   struct timeval tv;
+#elif CH_TIMEDELTA == 0
+  uint64_t now;
+#endif
+
+#if defined(__linux__)
+  poll_start();
+#endif
 
 #if HAL_USE_SERIAL
   if (sd_lld_interrupt_pending()) {
@@ -78,18 +486,39 @@ void ChkIntSources(void) {
     if (chSchIsPreemptionRequired())
       chSchDoReschedule();
     dbg_check_unlock();
-    return;
+    return TRUE;
   }
 #endif
 
+#if !defined(__linux__)
   gettimeofday(&tv, NULL);
   if (timercmp(&tv, &nextcnt, >=)) {
     timeradd(&nextcnt, &tick, &nextcnt);
+#elif CH_TIMEDELTA == 0
+  now = get_ticks();
+  if (now > lastticks) {
+#else
+  /* The alarm expiration is checked against the simulated time, the
+     timerfd is only used for waking up the idle thread.*/
+  if (alarmarmed &&
+      ((systime_t)((systime_t)get_ticks() - alarmtime) <=
+       (systime_t)-1 / 2)) {
+    alarmarmed = FALSE;
+#endif
 
     CH_IRQ_PROLOGUE();
 
     chSysLockFromIsr();
+#if defined(__linux__) && (CH_TIMEDELTA == 0)
+    /* Ticks missed while the host was busy are all served now, the system
+       time never drifts from the host time.*/
+    while (lastticks < now) {
+      lastticks++;
+      chSysTimerHandlerI();
+    }
+#else
     chSysTimerHandlerI();
+#endif
     chSysUnlockFromIsr();
 
     CH_IRQ_EPILOGUE();
@@ -98,7 +527,350 @@ void ChkIntSources(void) {
     if (chSchIsPreemptionRequired())
       chSchDoReschedule();
     dbg_check_unlock();
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/*===========================================================================*/
+/* Driver interrupt handlers.                                                */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief Low level HAL driver initialization.
+ */
+void hal_lld_init(void) {
+
+#if defined(__APPLE__)
+  puts("ChibiOS/RT simulator (OS X)\n");
+#else
+  puts("ChibiOS/RT simulator (Linux)\n");
+#endif
+#if defined(__linux__)
+  {
+    const char *mode = getenv(SIM_TIME_MODE_ENV);
+
+    if ((mode != NULL) && (strcmp(mode, "virtual") == 0)) {
+      virtualtime = TRUE;
+      puts("Virtual time mode\n");
+    }
+  }
+  events_init();
+#endif
+#if !defined(__linux__)
+  gettimeofday(&nextcnt, NULL);
+  timeradd(&nextcnt, &tick, &nextcnt);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &basetime);
+  alarmfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (alarmfd < 0) {
+    perror("timerfd_create");
+    exit(1);
+  }
+  epollfd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollfd < 0) {
+    perror("epoll_create1");
+    exit(1);
+  }
+  hal_lld_watch_fd(alarmfd);
+#endif
+}
+
+/**
+ * @brief   Adds a file descriptor to the idle event sources.
+ * @details The idle thread wakes up when the descriptor becomes readable or
+ *          writable. Notifications are edge triggered so the descriptor
+ *          owner must use non blocking calls and consider the descriptor
+ *          idle only after a call failed with @p EWOULDBLOCK. Closed
+ *          descriptors are removed from the event sources automatically.
+ * @note    On non-Linux hosts this function does nothing and the idle
+ *          thread polls the interrupt sources.
+ *
+ * @param[in] fd        the file descriptor
+ */
+void hal_lld_watch_fd(int fd) {
+#if defined(__linux__)
+  struct epoll_event ev;
+
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+  ev.data.fd = fd;
+  if (epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    perror("epoll_ctl");
+    exit(1);
+  }
+#else
+  (void)fd;
+#endif
+}
+
+/**
+ * @brief   Returns @p TRUE if the simulator is recording an events file.
+ * @details While recording the data received by a single host call must
+ *          not exceed @p SIM_EVENT_DATA_SIZE bytes.
+ */
+bool_t hal_lld_is_recording(void) {
+
+#if defined(__linux__)
+  return recordfp != NULL;
+#else
+  return FALSE;
+#endif
+}
+
+/**
+ * @brief   Returns @p TRUE if the simulator is replaying an events file.
+ * @details While replaying the drivers must not access the host, the
+ *          results of the host calls are obtained from
+ *          @p hal_lld_replay_event().
+ */
+bool_t hal_lld_is_replaying(void) {
+
+#if defined(__linux__)
+  return replayfp != NULL;
+#else
+  return FALSE;
+#endif
+}
+
+/**
+ * @brief   Records the result of a host call.
+ * @details Drivers invoke this function after each host call whose result
+ *          is not @p EWOULDBLOCK, the call is not recorded if the events
+ *          recording is not active.
+ *
+ * @param[in] type      the event type
+ * @param[in] chan      the driver channel, from 0 to 15
+ * @param[in] result    the host call result
+ * @param[in] data      the received data, used by @p SIM_EVENT_RECV events
+ *                      with a positive result
+ */
+void hal_lld_record_event(unsigned type, unsigned chan, ssize_t result,
+                          const void *data) {
+
+#if defined(__linux__)
+  if (recordfp != NULL) {
+    if ((type == SIM_EVENT_RECV) && (result > SIM_EVENT_DATA_SIZE)) {
+      fprintf(stderr, "Events recording: data block too large\n");
+      exit(1);
+    }
+    record_event(type, chan, result, data);
+  }
+#else
+  (void)type;
+  (void)chan;
+  (void)result;
+  (void)data;
+#endif
+}
+
+/**
+ * @brief   Replays the result of a host call.
+ * @details If the next recorded event is due, its tick has been reached,
+ *          and matches the type and channel then it is consumed and its
+ *          result is returned, else the host call is considered failed
+ *          with @p EWOULDBLOCK. The events are consumed in the recorded
+ *          order.
+ * @note    Received data larger than the buffer is returned in multiple
+ *          calls, the result of a send is limited to the data size.
+ *
+ * @param[in] type      the event type
+ * @param[in] chan      the driver channel, from 0 to 15
+ * @param[out] data     buffer for the received data
+ * @param[in] size      size of the buffer or of the data to be sent
+ * @return              The recorded host call result, in case of negative
+ *                      result @p errno is set.
+ */
+ssize_t hal_lld_replay_event(unsigned type, unsigned chan, void *data,
+                             size_t size) {
+
+#if defined(__linux__)
+  if (nextev.valid && (nextev.tick <= curticks) && (nextev.type == type) &&
+      (nextev.chan == chan)) {
+    ssize_t result = nextev.result;
+
+    if ((type == SIM_EVENT_RECV) && (nextev.size > size)) {
+      memcpy(data, nextev.data, size);
+      memmove(nextev.data, nextev.data + size, nextev.size - size);
+      nextev.size -= size;
+      nextev.result -= (ssize_t)size;
+      return (ssize_t)size;
+    }
+    if ((type == SIM_EVENT_SEND) && (result > (ssize_t)size))
+      result = (ssize_t)size;
+    if (nextev.size > 0)
+      memcpy(data, nextev.data, nextev.size);
+    replay_fetch();
+    if (result < 0)
+      errno = ECONNRESET;
+    return result;
+  }
+#else
+  (void)type;
+  (void)chan;
+  (void)data;
+  (void)size;
+#endif
+  errno = EWOULDBLOCK;
+  return -1;
+}
+
+#if (CH_TIMEDELTA > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the current system time.
+ * @note    The system time is derived from the host monotonic clock.
+ *
+ * @return              The current system time.
+ */
+systime_t port_timer_get_time(void) {
+
+  return (systime_t)get_ticks();
+}
+
+/**
+ * @brief   Starts the alarm.
+ *
+ * @param[in] time      the time of the first alarm
+ */
+void port_timer_start_alarm(systime_t time) {
+
+  alarmtime = time;
+  alarmarmed = TRUE;
+  arm_alarm(time);
+}
+
+/**
+ * @brief   Stops the alarm.
+ */
+void port_timer_stop_alarm(void) {
+  struct itimerspec its = {{0, 0}, {0, 0}};
+
+  alarmarmed = FALSE;
+  timerfd_settime(alarmfd, 0, &its, NULL);
+}
+
+/**
+ * @brief   Changes the time of an already running alarm.
+ *
+ * @param[in] time      the new alarm time
+ */
+void port_timer_set_alarm(systime_t time) {
+
+  alarmtime = time;
+  alarmarmed = TRUE;
+  arm_alarm(time);
+}
+#endif /* CH_TIMEDELTA > 0 */
+
+/**
+ * @brief   Returns the current value of the realtime counter.
+ * @note    In virtual time mode the counter includes the skipped time.
+ *
+ * @return              The host monotonic time in nanoseconds, truncated to
+ *                      the @p halrtcnt_t range.
+ *
+ * @notapi
+ */
+halrtcnt_t hal_lld_get_counter(void) {
+#if defined(__linux__)
+
+  return (halrtcnt_t)get_ns();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (halrtcnt_t)((halrtcnt_t)ts.tv_sec * 1000000000U +
+                      (halrtcnt_t)ts.tv_nsec);
+#endif
+}
+
+/**
+ * @brief   Returns the current value of the port realtime counter.
+ * @details The port realtime counter is the HAL realtime counter with a
+ *          microseconds resolution, a nanoseconds counter would wrap every
+ *          4.29 seconds and the threads accounting would be wrong across
+ *          longer tick-less idle periods.
+ * @note    The counter wraps every 71.6 minutes, the accounting of a
+ *          single interval longer than that is still wrong.
+ *
+ * @return              The realtime counter value.
+ */
+uint32_t port_rt_get_counter_value(void) {
+
+#if defined(__linux__)
+  return (uint32_t)(get_ns() / 1000U);
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint32_t)ts.tv_sec * 1000000U +
+                    (uint32_t)(ts.tv_nsec / 1000));
+#endif
+}
+
+/**
+ * @brief   Returns the frequency of the port realtime counter.
+ *
+ * @return              The realtime counter frequency.
+ */
+uint32_t port_rt_get_counter_frequency(void) {
+
+  return 1000000U;
+}
+
+/**
+ * @brief Interrupt simulation.
+ */
+void ChkIntSources(void) {
+
+  (void)process_sources();
+}
+
+/**
+ * @brief   Interrupt simulation from the idle thread.
+ * @details If no interrupt source is pending then the host thread blocks
+ *          until the next system tick, the alarm expiration or a serial
+ *          event, the host CPU is not used while the system is idle.
+ *          In virtual time mode the simulated time is instead advanced
+ *          to the next virtual timer or alarm expiration, the host thread
+ *          blocks only if there is no timer or alarm armed.
+ */
+void WaitIntSources(void) {
+#if defined(__linux__)
+  struct epoll_event ev[4];
+
+  while (!process_sources()) {
+    uint64_t t;
+
+    /* The replay never waits for the host.*/
+    if (replayfp != NULL) {
+      replay_idle();
+      continue;
+    }
+    if (virtualtime && next_expiration(&t)) {
+      skip_to(t);
+      continue;
+    }
+#if CH_TIMEDELTA == 0
+    if (!virtualtime)
+      arm_alarm((systime_t)(lastticks + 1));
+#endif
+    /* The events recorded so far are saved before blocking, the simulator
+       is usually terminated while idle.*/
+    if (recordfp != NULL)
+      fflush(recordfp);
+    if ((epoll_wait(epollfd, ev, sizeof ev / sizeof ev[0], -1) < 0) &&
+        (errno != EINTR)) {
+      perror("epoll_wait");
+      exit(1);
+    }
   }
+#else
+  ChkIntSources();
+#endif
 }
 
 /** @} */
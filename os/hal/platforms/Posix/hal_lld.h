@@ -36,7 +36,7 @@
 /**
  * @brief   Defines the support for realtime counters in the HAL.
  */
-#define HAL_IMPLEMENTS_COUNTERS FALSE
+#define HAL_IMPLEMENTS_COUNTERS TRUE
 
 /**
  * @brief   Platform name.
@@ -46,10 +46,65 @@
 #define SOCKET int
 #define INVALID_SOCKET -1
 
+/**
+ * @brief   Events file format version.
+ */
+#define SIM_EVENTS_VERSION          2
+
+/**
+ * @brief   Maximum data size of a recorded event.
+ */
+#define SIM_EVENT_DATA_SIZE         4096
+
+/**
+ * @name    Recorded events types
+ * @{
+ */
+#define SIM_EVENT_END               0   /**< @brief End of recording.       */
+#define SIM_EVENT_ACCEPT            1   /**< @brief Connection accepted.    */
+#define SIM_EVENT_RECV              2   /**< @brief Data received.          */
+#define SIM_EVENT_SEND              3   /**< @brief Data sent.              */
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Environment variable selecting the simulated time mode.
+ * @details If the variable is set to @p "virtual" when the simulator starts
+ *          then the simulated time skips forward to the next system tick or
+ *          alarm whenever the system is idle, otherwise the simulated time
+ *          follows the host time.
+ * @note    The virtual time mode is supported on Linux hosts only.
+ */
+#if !defined(SIM_TIME_MODE_ENV) || defined(__DOXYGEN__)
+#define SIM_TIME_MODE_ENV           "CHIBIOS_SIM_TIME"
+#endif
+
+/**
+ * @brief   Environment variable naming the events file to be recorded.
+ * @details The simulated interrupt events are recorded with the simulated
+ *          tick they happened in, and their order within the tick, in order
+ *          to be replayed later.
+ * @note    The events recording is supported on Linux hosts only.
+ */
+#if !defined(SIM_RECORD_ENV) || defined(__DOXYGEN__)
+#define SIM_RECORD_ENV              "CHIBIOS_SIM_RECORD"
+#endif
+
+/**
+ * @brief   Environment variable naming the events file to be replayed.
+ * @details The simulated interrupt events are injected from the file
+ *          instead of the host when the simulated time reaches their tick,
+ *          the simulated time skips forward whenever the system is idle.
+ *          This variable has precedence over @p SIM_RECORD_ENV.
+ * @note    The events replay is supported on Linux hosts only.
+ */
+#if !defined(SIM_REPLAY_ENV) || defined(__DOXYGEN__)
+#define SIM_REPLAY_ENV              "CHIBIOS_SIM_REPLAY"
+#endif
+
 /*===========================================================================*/
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
@@ -58,10 +113,41 @@
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
 
+/**
+ * @brief   Type representing a system clock frequency.
+ */
+typedef uint32_t halclock_t;
+
+/**
+ * @brief   Type of the realtime free counter value.
+ */
+typedef uint32_t halrtcnt_t;
+
 /*===========================================================================*/
 /* Driver macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Returns the current value of the system free running counter.
+ * @note    The counter is derived from the host monotonic clock and has a
+ *          nanoseconds resolution.
+ *
+ * @return              The value of the system free running counter of
+ *                      type halrtcnt_t.
+ *
+ * @notapi
+ */
+#define hal_lld_get_counter_value()         hal_lld_get_counter()
+
+/**
+ * @brief   Realtime counter frequency.
+ *
+ * @return              The realtime counter frequency of type halclock_t.
+ *
+ * @notapi
+ */
+#define hal_lld_get_counter_frequency()     1000000000U
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -70,7 +156,16 @@
 extern "C" {
 #endif
   void hal_lld_init(void);
+  void hal_lld_watch_fd(int fd);
+  bool_t hal_lld_is_recording(void);
+  bool_t hal_lld_is_replaying(void);
+  void hal_lld_record_event(unsigned type, unsigned chan, ssize_t result,
+                            const void *data);
+  ssize_t hal_lld_replay_event(unsigned type, unsigned chan, void *data,
+                               size_t size);
   void ChkIntSources(void);
+  void WaitIntSources(void);
+  halrtcnt_t hal_lld_get_counter(void);
 #ifdef __cplusplus
 }
 #endif
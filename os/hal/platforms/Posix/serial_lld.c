@@ -22,6 +22,7 @@
  * @{
  */
 
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,6 +33,14 @@
 #include "ch.h"
 #include "hal.h"
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#endif
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL    0
+#endif
+
 #if HAL_USE_SERIAL || defined(__DOXYGEN__)
 
 /*===========================================================================*/
@@ -57,19 +66,156 @@ static const SerialConfig default_config = {
 
 static u_long nb = 1;
 
+/**
+ * @brief   Data socket placeholder used while replaying.
+ */
+#define REPLAY_SOCKET   0x7FFFFFFF
+
+/**
+ * @brief   Readiness mask bit of the listen socket.
+ */
+#define READY_LISTEN    1U
+
+/**
+ * @brief   Readiness mask bit of a client socket.
+ */
+#define READY_CLIENT(i) (2U << (i))
+
+/**
+ * @brief   Simulated serial drivers.
+ */
+static SerialDriver * const drivers[] = {
+#if USE_SIM_SERIAL1
+  &SD1,
+#endif
+#if USE_SIM_SERIAL2
+  &SD2,
+#endif
+};
+
+#define NUM_DRIVERS     (sizeof drivers / sizeof drivers[0])
+
+/**
+ * @name    Socket watch operations
+ * @{
+ */
+#define WATCH_ADD       0   /**< @brief Adds a socket, input events.    */
+#define WATCH_INPUT     1   /**< @brief Input events only.              */
+#define WATCH_OUTPUT    2   /**< @brief Input and output events.        */
+/** @} */
+
+#if defined(__linux__)
+/**
+ * @brief   Event sources of all the simulated channels.
+ */
+static int sdepollfd = -1;
+#endif
+
 /*===========================================================================*/
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+/**
+ * @brief   Returns the events channel of a client.
+ */
+static unsigned chan(SerialDriver *sdp, unsigned i) {
+
+  return sdp->com_id * SIM_SERIAL_MAX_CLIENTS + i;
+}
+
+/**
+ * @brief   Changes the events watched on a socket.
+ * @note    Sockets are never watched while replaying.
+ */
+static void watch(SOCKET s, unsigned op) {
+#if defined(__linux__)
+  struct epoll_event ev;
+
+  if (hal_lld_is_replaying())
+    return;
+  ev.events = op == WATCH_OUTPUT ? EPOLLIN | EPOLLOUT : EPOLLIN;
+  ev.data.fd = s;
+  if (epoll_ctl(sdepollfd, op == WATCH_ADD ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                s, &ev) != 0) {
+    perror("epoll_ctl");
+    exit(1);
+  }
+#else
+  (void)s;
+  (void)op;
+#endif
+}
+
+/**
+ * @brief   Accepts a connection, the result is recorded or replayed.
+ */
+static SOCKET sim_accept(SerialDriver *sdp) {
+  struct sockaddr addr;
+  socklen_t addrlen = sizeof(addr);
+  SOCKET s;
+
+  if (hal_lld_is_replaying())
+    return hal_lld_replay_event(SIM_EVENT_ACCEPT, chan(sdp, 0), NULL, 0) < 0 ?
+           INVALID_SOCKET : REPLAY_SOCKET;
+  if ((s = accept(sdp->com_listen, &addr, &addrlen)) != INVALID_SOCKET)
+    hal_lld_record_event(SIM_EVENT_ACCEPT, chan(sdp, 0), 0, NULL);
+  return s;
+}
+
+/**
+ * @brief   Receives data, the result is recorded or replayed.
+ */
+static ssize_t sim_recv(SerialDriver *sdp, unsigned i, uint8_t *bp,
+                        size_t n) {
+  ssize_t r;
+
+  if (hal_lld_is_replaying())
+    return hal_lld_replay_event(SIM_EVENT_RECV, chan(sdp, i), bp, n);
+  r = recv(sdp->com_clients[i], bp, n, 0);
+  if ((r >= 0) || (errno != EWOULDBLOCK))
+    hal_lld_record_event(SIM_EVENT_RECV, chan(sdp, i), r, bp);
+  return r;
+}
+
+/**
+ * @brief   Sends data, the result is recorded or replayed.
+ */
+static ssize_t sim_send(SerialDriver *sdp, unsigned i, const uint8_t *bp,
+                        size_t n) {
+  ssize_t r;
+
+  if (hal_lld_is_replaying())
+    return hal_lld_replay_event(SIM_EVENT_SEND, chan(sdp, i), NULL, n);
+  r = send(sdp->com_clients[i], bp, n, MSG_NOSIGNAL);
+  if ((r >= 0) || (errno != EWOULDBLOCK))
+    hal_lld_record_event(SIM_EVENT_SEND, chan(sdp, i), r, NULL);
+  return r;
+}
+
+/**
+ * @brief   Closes a socket.
+ */
+static void sim_close(SOCKET s) {
+
+  if (!hal_lld_is_replaying())
+    close(s);
+}
+
 static void init(SerialDriver *sdp, uint16_t port) {
   struct sockaddr_in sad;
   struct protoent *prtp;
   int sockval = 1;
   socklen_t socklen = sizeof(sockval);
 
+  if (hal_lld_is_replaying()) {
+    sdp->com_listen = REPLAY_SOCKET;
+    printf("Full Duplex Channel %s replaying port %d\n", sdp->com_name, port);
+    return;
+  }
 
   if ((prtp = getprotobyname("tcp")) == NULL) {
-    printf("%s: Error mapping protocol name to protocol number\n", sdp->com_name);
+    printf("%s: Error mapping protocol name to protocol number\n",
+           sdp->com_name);
     goto abort;
   }
 
@@ -96,10 +242,11 @@ static void init(SerialDriver *sdp, uint16_t port) {
     goto abort;
   }
 
-  if (listen(sdp->com_listen, 1) != 0) {
+  if (listen(sdp->com_listen, SIM_SERIAL_MAX_CLIENTS) != 0) {
     printf("%s: Error listening socket\n", sdp->com_name);
     goto abort;
   }
+  watch(sdp->com_listen, WATCH_ADD);
   printf("Full Duplex Channel %s listening on port %d\n", sdp->com_name, port);
   return;
 
@@ -109,102 +256,257 @@ abort:
   exit(1);
 }
 
-static bool_t connint(SerialDriver *sdp) {
-
-  if (sdp->com_data == INVALID_SOCKET) {
-    struct sockaddr addr;
-    socklen_t addrlen = sizeof(addr);
-
-    if ((sdp->com_data = accept(sdp->com_listen, &addr, &addrlen)) == INVALID_SOCKET)
-      return FALSE;
-
-    if (ioctl(sdp->com_data, FIONBIO, &nb) != 0) {
-      printf("%s: Unable to setup non blocking mode on data socket\n", sdp->com_name);
-      goto abort;
-    }
+/**
+ * @brief   Removes a client.
+ * @details The channel is disconnected when the last client is removed,
+ *          if the primary client is removed then the client in the lowest
+ *          slot in use becomes the primary.
+ */
+static void disconnect(SerialDriver *sdp, unsigned i) {
+  unsigned j;
+
+  sim_close(sdp->com_clients[i]);
+  sdp->com_clients[i] = INVALID_SOCKET;
+  sdp->com_wrblocked &= ~(1U << i);
+  sdp->com_rdblocked &= ~(1U << i);
+  sdp->com_rdretry &= ~(1U << i);
+  if (--sdp->com_nclients == 0) {
     chSysLockFromIsr();
-    chnAddFlagsI(sdp, CHN_CONNECTED);
+    chnAddFlagsI(sdp, CHN_DISCONNECTED);
     chSysUnlockFromIsr();
-    return TRUE;
+    return;
+  }
+  if (sdp->com_primary == i) {
+    for (j = 0; sdp->com_clients[j] == INVALID_SOCKET; j++)
+      ;
+    sdp->com_primary = j;
   }
-  return FALSE;
+}
+
+static bool_t connint(SerialDriver *sdp) {
+  bool_t b = FALSE;
+  SOCKET s;
+  unsigned i;
+
+  while ((s = sim_accept(sdp)) != INVALID_SOCKET) {
+    for (i = 0; i < SIM_SERIAL_MAX_CLIENTS; i++)
+      if (sdp->com_clients[i] == INVALID_SOCKET)
+        break;
+    if (i >= SIM_SERIAL_MAX_CLIENTS) {
+      printf("%s: Too many clients, connection refused\n", sdp->com_name);
+      sim_close(s);
+      continue;
+    }
+    if (!hal_lld_is_replaying()) {
+      if (ioctl(s, FIONBIO, &nb) != 0) {
+        printf("%s: Unable to setup non blocking mode on data socket\n",
+               sdp->com_name);
+        goto abort;
+      }
+      watch(s, WATCH_ADD);
+    }
+    sdp->com_clients[i] = s;
+    if (sdp->com_nclients++ == 0) {
+      sdp->com_primary = i;
+      chSysLockFromIsr();
+      chnAddFlagsI(sdp, CHN_CONNECTED);
+      chSysUnlockFromIsr();
+    }
+    b = TRUE;
+  }
+  return b;
 abort:
   if (sdp->com_listen != INVALID_SOCKET)
     close(sdp->com_listen);
-  if (sdp->com_data != INVALID_SOCKET)
-    close(sdp->com_data);
+  close(s);
   exit(1);
 }
 
-static bool_t inint(SerialDriver *sdp) {
+/**
+ * @brief   Moves the data received by a client into the input queue.
+ * @details The data is received in place into the free space of the
+ *          input queue, if the queue is full the data is left in the
+ *          socket and the client is served again after the queue has
+ *          been read, see @p inotify().
+ */
+static bool_t inint(SerialDriver *sdp, unsigned i) {
+  bool_t b = FALSE;
 
-  if (sdp->com_data != INVALID_SOCKET) {
-    int i;
-    uint8_t data[32];
+  while (TRUE) {
+    QueueSpan span;
+    bool_t empty;
+    size_t n;
+    ssize_t r;
 
-    /*
-     * Input.
-     */
-    int n = recv(sdp->com_data, data, sizeof(data), 0);
-    switch (n) {
-    case 0:
-      close(sdp->com_data);
-      sdp->com_data = INVALID_SOCKET;
-      chSysLockFromIsr();
-      chnAddFlagsI(sdp, CHN_DISCONNECTED);
-      chSysUnlockFromIsr();
-      return FALSE;
-    case INVALID_SOCKET:
-      if (errno == EWOULDBLOCK)
-        return FALSE;
-      close(sdp->com_data);
-      sdp->com_data = INVALID_SOCKET;
+    chSysLockFromIsr();
+    empty = chIQIsEmptyI(&sdp->iqueue);
+    n = chIQGetWriteSpanI(&sdp->iqueue, &span) > 0 ? span.qs_size[0] : 0;
+    if (n == 0)
+      sdp->com_rdblocked |= 1U << i;
+    chSysUnlockFromIsr();
+    if (n == 0)
+      return b;
+    /* A recorded event cannot carry more data.*/
+    if (hal_lld_is_recording() && (n > SIM_EVENT_DATA_SIZE))
+      n = SIM_EVENT_DATA_SIZE;
+
+    r = sim_recv(sdp, i, span.qs_ptr[0], n);
+    if (r <= 0) {
+      if ((r < 0) && (errno == EWOULDBLOCK))
+        return b;
+      disconnect(sdp, i);
       return FALSE;
     }
-    for (i = 0; i < n; i++) {
-      chSysLockFromIsr();
-      sdIncomingDataI(sdp, data[i]);
-      chSysUnlockFromIsr();
-    }
-    return TRUE;
+
+    chSysLockFromIsr();
+    if (empty)
+      chnAddFlagsI(sdp, CHN_INPUT_AVAILABLE);
+    chIQCommitWriteI(&sdp->iqueue, (size_t)r);
+    chSysUnlockFromIsr();
+    b = TRUE;
+
+    /* A short read means the socket has been drained.*/
+    if ((size_t)r < n)
+      return b;
   }
-  return FALSE;
 }
 
+/**
+ * @brief   Sends the output queue content to the clients.
+ * @details The data is sent in place from the output queue, it is removed
+ *          from the queue as it is accepted by the primary client. The
+ *          other clients receive a copy of the same data, a client unable
+ *          to keep up loses data instead of slowing down the channel.
+ */
 static bool_t outint(SerialDriver *sdp) {
+  bool_t b = FALSE;
+  unsigned i;
+
+  while (sdp->com_nclients > 0) {
+    QueueSpan span;
+    size_t n;
+    ssize_t r;
 
-  if (sdp->com_data != INVALID_SOCKET) {
-    int n;
-    uint8_t data[1];
+    if (sdp->com_wrblocked & (1U << sdp->com_primary))
+      return b;
 
-    /*
-     * Input.
-     */
     chSysLockFromIsr();
-    n = sdRequestDataI(sdp);
+    n = chOQGetReadSpanI(&sdp->oqueue, &span) > 0 ? span.qs_size[0] : 0;
     chSysUnlockFromIsr();
-    if (n < 0)
-      return FALSE;
-    data[0] = (uint8_t)n;
-    n = send(sdp->com_data, data, sizeof(data), 0);
-    switch (n) {
-    case 0:
-      close(sdp->com_data);
-      sdp->com_data = INVALID_SOCKET;
+    if (n == 0)
+      return b;
+
+    i = sdp->com_primary;
+    r = sim_send(sdp, i, span.qs_ptr[0], n);
+    if (r <= 0) {
+      if ((r < 0) && (errno == EWOULDBLOCK)) {
+        sdp->com_wrblocked |= 1U << i;
+        watch(sdp->com_clients[i], WATCH_OUTPUT);
+        return b;
+      }
+      disconnect(sdp, i);
+      continue;
+    }
+
+    for (i = 0; i < SIM_SERIAL_MAX_CLIENTS; i++) {
+      if ((i != sdp->com_primary) && (sdp->com_clients[i] != INVALID_SOCKET)) {
+        ssize_t tr = sim_send(sdp, i, span.qs_ptr[0], (size_t)r);
+
+        if ((tr == 0) || ((tr < 0) && (errno != EWOULDBLOCK)))
+          disconnect(sdp, i);
+      }
+    }
+
+    chSysLockFromIsr();
+    chOQCommitReadI(&sdp->oqueue, (size_t)r);
+    if (chOQIsEmptyI(&sdp->oqueue))
+      chnAddFlagsI(sdp, CHN_OUTPUT_EMPTY);
+    chSysUnlockFromIsr();
+    b = TRUE;
+
+    /* A short write means the socket buffer is full.*/
+    if ((size_t)r < n) {
+      sdp->com_wrblocked |= 1U << sdp->com_primary;
+      watch(sdp->com_clients[sdp->com_primary], WATCH_OUTPUT);
+      return b;
+    }
+  }
+  return b;
+}
+
+/**
+ * @brief   Input queue notification.
+ * @details The data left in the sockets by a full input queue does not
+ *          raise new events, the blocked clients are served again on the
+ *          next poll after the application read from the queue.
+ *
+ * @param[in] qp        the input queue
+ */
+static void inotify(GenericQueue *qp) {
+  SerialDriver *sdp = chQGetLink(qp);
+
+  sdp->com_rdretry |= sdp->com_rdblocked;
+  sdp->com_rdblocked = 0;
+}
+
+/**
+ * @brief   Collects the readiness of the simulated channels sockets.
+ * @details A single non blocking @p epoll_wait() call returns the ready
+ *          sockets of all the channels, the clients blocked by a full
+ *          input queue are added after the queue has been read. While
+ *          replaying, or on non-Linux hosts, all the sockets are
+ *          considered ready.
+ *
+ * @param[out] masks    readiness masks, one for each driver
+ */
+static void get_ready(unsigned masks[]) {
+  unsigned d;
+#if defined(__linux__)
+  struct epoll_event evs[NUM_DRIVERS * (SIM_SERIAL_MAX_CLIENTS + 1)];
+  int n, k;
+  unsigned i;
+
+  if (!hal_lld_is_replaying()) {
+    for (d = 0; d < NUM_DRIVERS; d++) {
       chSysLockFromIsr();
-      chnAddFlagsI(sdp, CHN_DISCONNECTED);
+      /* Same bits layout of READY_CLIENT().*/
+      masks[d] = drivers[d]->com_rdretry << 1;
+      drivers[d]->com_rdretry = 0;
       chSysUnlockFromIsr();
-      return FALSE;
-    case INVALID_SOCKET:
-      if (errno == EWOULDBLOCK)
-        return FALSE;
-      close(sdp->com_data);
-      sdp->com_data = INVALID_SOCKET;
-      return FALSE;
     }
-    return TRUE;
+    n = epoll_wait(sdepollfd, evs, sizeof evs / sizeof evs[0], 0);
+    for (k = 0; k < n; k++) {
+      for (d = 0; d < NUM_DRIVERS; d++) {
+        SerialDriver *sdp = drivers[d];
+
+        if (evs[k].data.fd == sdp->com_listen) {
+          masks[d] |= READY_LISTEN;
+          break;
+        }
+        for (i = 0; i < SIM_SERIAL_MAX_CLIENTS; i++)
+          if (evs[k].data.fd == sdp->com_clients[i])
+            break;
+        if (i < SIM_SERIAL_MAX_CLIENTS) {
+          if (evs[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            masks[d] |= READY_CLIENT(i);
+          if ((evs[k].events & EPOLLOUT) &&
+              (sdp->com_wrblocked & (1U << i))) {
+            sdp->com_wrblocked &= ~(1U << i);
+            watch(sdp->com_clients[i], WATCH_INPUT);
+          }
+          break;
+        }
+      }
+    }
+    return;
+  }
+#endif
+  for (d = 0; d < NUM_DRIVERS; d++) {
+    masks[d] = ~0U;
+    drivers[d]->com_wrblocked = 0;
+    drivers[d]->com_rdblocked = 0;
+    drivers[d]->com_rdretry = 0;
   }
-  return FALSE;
 }
 
 /*===========================================================================*/
@@ -219,20 +521,38 @@ static bool_t outint(SerialDriver *sdp) {
  * @brief   Low level serial driver initialization.
  */
 void sd_lld_init(void) {
+  unsigned d, i;
 
 #if USE_SIM_SERIAL1
-  sdObjectInit(&SD1, NULL, NULL);
-  SD1.com_listen = INVALID_SOCKET;
-  SD1.com_data = INVALID_SOCKET;
+  sdObjectInit(&SD1, inotify, NULL);
   SD1.com_name = "SD1";
 #endif
 
 #if USE_SIM_SERIAL2
-  sdObjectInit(&SD2, NULL, NULL);
-  SD2.com_listen = INVALID_SOCKET;
-  SD2.com_data = INVALID_SOCKET;
+  sdObjectInit(&SD2, inotify, NULL);
   SD2.com_name = "SD2";
 #endif
+
+  for (d = 0; d < NUM_DRIVERS; d++) {
+    drivers[d]->com_id = d;
+    drivers[d]->com_listen = INVALID_SOCKET;
+    for (i = 0; i < SIM_SERIAL_MAX_CLIENTS; i++)
+      drivers[d]->com_clients[i] = INVALID_SOCKET;
+    drivers[d]->com_nclients = 0;
+    drivers[d]->com_primary = 0;
+    drivers[d]->com_wrblocked = 0;
+    drivers[d]->com_rdblocked = 0;
+    drivers[d]->com_rdretry = 0;
+  }
+
+#if defined(__linux__)
+  sdepollfd = epoll_create1(EPOLL_CLOEXEC);
+  if (sdepollfd < 0) {
+    perror("epoll_create1");
+    exit(1);
+  }
+  hal_lld_watch_fd(sdepollfd);
+#endif
 }
 
 /**
@@ -268,14 +588,33 @@ void sd_lld_stop(SerialDriver *sdp) {
   (void)sdp;
 }
 
+/**
+ * @brief   Serves the simulated channels.
+ * @details Accepts the new clients, moves the received data into the input
+ *          queues and sends the output queues content.
+ *
+ * @return              The channels state.
+ * @retval FALSE        if there was nothing to serve.
+ * @retval TRUE         if at least one channel has been served.
+ */
 bool_t sd_lld_interrupt_pending(void) {
-  bool_t b;
+  unsigned masks[NUM_DRIVERS], d, i;
+  bool_t b = FALSE;
 
   CH_IRQ_PROLOGUE();
 
-  b =  connint(&SD1) || connint(&SD2) ||
-       inint(&SD1)   || inint(&SD2)   ||
-       outint(&SD1)  || outint(&SD2);
+  get_ready(masks);
+  for (d = 0; d < NUM_DRIVERS; d++) {
+    SerialDriver *sdp = drivers[d];
+
+    if ((masks[d] & READY_LISTEN) && (sdp->com_listen != INVALID_SOCKET))
+      b = connint(sdp) || b;
+    for (i = 0; i < SIM_SERIAL_MAX_CLIENTS; i++)
+      if ((masks[d] & READY_CLIENT(i)) &&
+          (sdp->com_clients[i] != INVALID_SOCKET))
+        b = inint(sdp, i) || b;
+    b = outint(sdp) || b;
+  }
 
   CH_IRQ_EPILOGUE();
 
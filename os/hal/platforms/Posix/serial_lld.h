@@ -62,6 +62,17 @@
 #define USE_SIM_SERIAL2             TRUE
 #endif
 
+/**
+ * @brief   Maximum number of clients connected to a simulated port.
+ * @details The first connected client is the primary client, its output
+ *          flow control is applied to the channel. The other clients act
+ *          as monitors, they receive a copy of the output and their input
+ *          is merged in the input queue.
+ */
+#if !defined(SIM_SERIAL_MAX_CLIENTS) || defined(__DOXYGEN__)
+#define SIM_SERIAL_MAX_CLIENTS      4
+#endif
+
 /**
  * @brief   Listen port for SD1.
  */
@@ -80,6 +91,10 @@
 /* Derived constants and error checks.                                       */
 /*===========================================================================*/
 
+#if (SIM_SERIAL_MAX_CLIENTS < 1) || (SIM_SERIAL_MAX_CLIENTS * 2 > 16)
+#error "SIM_SERIAL_MAX_CLIENTS must be between 1 and 8"
+#endif
+
 /*===========================================================================*/
 /* Driver data structures and types.                                         */
 /*===========================================================================*/
@@ -113,10 +128,22 @@ typedef struct {
   /* End of the mandatory fields.*/                                         \
   /* Listen socket for simulated serial port.*/                             \
   SOCKET                    com_listen;                                     \
-  /* Data socket for simulated serial port.*/                               \
-  SOCKET                    com_data;                                       \
+  /* Data sockets of the connected clients.*/                               \
+  SOCKET                    com_clients[SIM_SERIAL_MAX_CLIENTS];            \
+  /* Number of connected clients.*/                                         \
+  unsigned                  com_nclients;                                   \
+  /* Slot of the primary client.*/                                          \
+  unsigned                  com_primary;                                    \
+  /* Clients waiting for space in their socket buffer, one bit each.*/      \
+  unsigned                  com_wrblocked;                                  \
+  /* Clients with data left in their socket by a full input queue.*/        \
+  unsigned                  com_rdblocked;                                  \
+  /* Blocked clients to be served again after an input queue read.*/        \
+  unsigned                  com_rdretry;                                    \
   /* Port readable name.*/                                                  \
-  const char                *com_name;
+  const char                *com_name;                                      \
+  /* Channel identifier for the events recording.*/                         \
+  unsigned                  com_id;
 
 /*===========================================================================*/
 /* Driver macros.                                                            */
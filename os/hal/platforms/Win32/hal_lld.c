@@ -24,6 +24,10 @@
 #include "ch.h"
 #include "hal.h"
 
+#if CH_TIMEDELTA > 0
+#error "tick-less mode not supported by the Win32 simulator"
+#endif
+
 /*===========================================================================*/
 /* Driver exported variables.                                                */
 /*===========================================================================*/
@@ -71,6 +75,31 @@ void hal_lld_init(void) {
   fflush(stdout);
 }
 
+/**
+ * @brief   Returns the current value of the port realtime counter.
+ * @note    The counter is the host performance counter.
+ *
+ * @return              The realtime counter value.
+ */
+uint32_t port_rt_get_counter_value(void) {
+  LARGE_INTEGER n;
+
+  QueryPerformanceCounter(&n);
+  return (uint32_t)n.QuadPart;
+}
+
+/**
+ * @brief   Returns the frequency of the port realtime counter.
+ *
+ * @return              The realtime counter frequency.
+ */
+uint32_t port_rt_get_counter_frequency(void) {
+  LARGE_INTEGER f;
+
+  QueryPerformanceFrequency(&f);
+  return (uint32_t)f.QuadPart;
+}
+
 /**
  * @brief Interrupt simulation.
  */
@@ -107,4 +136,13 @@ void ChkIntSources(void) {
   }
 }
 
+/**
+ * @brief   Interrupt simulation from the idle thread.
+ * @note    The Win32 simulator polls the interrupt sources.
+ */
+void WaitIntSources(void) {
+
+  ChkIntSources();
+}
+
 /** @} */
@@ -114,13 +114,16 @@
 #include "chsys.h"
 #include "chvt.h"
 #include "chschd.h"
+#include "chedf.h"
 #include "chsem.h"
 #include "chbsem.h"
 #include "chmtx.h"
 #include "chcond.h"
+#include "chrwlock.h"
 #include "chevents.h"
 #include "chmsg.h"
 #include "chmboxes.h"
+#include "chworkq.h"
 #include "chmemcore.h"
 #include "chheap.h"
 #include "chmempools.h"
@@ -135,12 +138,18 @@
 
 #if !defined(__DOXYGEN__)
 extern WORKING_AREA(_idle_thread_wa, PORT_IDLE_THREAD_STACK_SIZE);
+#if CH_USE_VT_DEFERRED
+extern WORKING_AREA(_vt_service_wa, CH_VT_SERVICE_STACK_SIZE);
+#endif
 #endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
   void _idle_thread(void *p);
+#if CH_USE_VT_DEFERRED
+  msg_t _vt_service_thread(void *p);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -54,11 +54,45 @@
 
 /**
  * @brief   Trace buffer entries.
+ * @note    Must be a power of two.
  */
 #ifndef CH_TRACE_BUFFER_SIZE
 #define CH_TRACE_BUFFER_SIZE        64
 #endif
 
+/**
+ * @brief   Trace timestamps source.
+ * @details By default the port realtime counter is used if supported by
+ *          the port, else the system time.
+ */
+#ifndef CH_TRACE_TIMESTAMP
+#if PORT_SUPPORTS_RT || defined(__DOXYGEN__)
+#define CH_TRACE_TIMESTAMP()        port_rt_get_counter_value()
+#else
+#define CH_TRACE_TIMESTAMP()        ((uint32_t)chTimeNow())
+#endif
+#endif
+
+/**
+ * @brief   Trace timestamps frequency.
+ */
+#ifndef CH_TRACE_FREQUENCY
+#if PORT_SUPPORTS_RT || defined(__DOXYGEN__)
+#define CH_TRACE_FREQUENCY()        port_rt_get_counter_frequency()
+#else
+#define CH_TRACE_FREQUENCY()        ((uint32_t)CH_FREQUENCY)
+#endif
+#endif
+
+/**
+ * @brief   Threads load measurement window in milliseconds.
+ * @note    The window length in realtime counter cycles must not exceed
+ *          the 32 bits range.
+ */
+#ifndef CH_ACCOUNTING_WINDOW
+#define CH_ACCOUNTING_WINDOW        1000
+#endif
+
 /**
  * @brief   Fill value for thread stack area in debug mode.
  */
@@ -107,24 +141,78 @@
 /*===========================================================================*/
 
 #if CH_DBG_ENABLE_TRACE || defined(__DOXYGEN__)
+#if (CH_TRACE_BUFFER_SIZE & (CH_TRACE_BUFFER_SIZE - 1)) != 0
+#error "CH_TRACE_BUFFER_SIZE must be a power of two"
+#endif
+
+/**
+ * @name    Trace event types
+ * @{
+ */
+#define CH_TRACE_TYPE_SWITCH        1   /**< @brief Context switch.         */
+#define CH_TRACE_TYPE_READY         2   /**< @brief Thread made ready.      */
+#define CH_TRACE_TYPE_ISR_ENTER     3   /**< @brief ISR enter.              */
+#define CH_TRACE_TYPE_ISR_LEAVE     4   /**< @brief ISR leave.              */
+#define CH_TRACE_TYPE_VT_FIRE       5   /**< @brief Virtual timer fired.    */
+#define CH_TRACE_TYPE_SEM_WAIT      6   /**< @brief Semaphore wait.         */
+#define CH_TRACE_TYPE_SEM_SIGNAL    7   /**< @brief Semaphore signal.       */
+#define CH_TRACE_TYPE_MTX_LOCK      8   /**< @brief Mutex lock.             */
+#define CH_TRACE_TYPE_MTX_UNLOCK    9   /**< @brief Mutex unlock.           */
+#define CH_TRACE_TYPE_MTX_BOOST     10  /**< @brief Priority inheritance.   */
+#define CH_TRACE_TYPE_MB_POST       11  /**< @brief Mailbox post.           */
+#define CH_TRACE_TYPE_MB_FETCH      12  /**< @brief Mailbox fetch.          */
+/** @} */
+
+/**
+ * @name    Trace stream records
+ * @{
+ */
+#define CH_TRACE_STREAM_NAME        0x80 /**< @brief Thread name record.    */
+#define CH_TRACE_STREAM_LOST        0x81 /**< @brief Lost events record.    */
+#define CH_TRACE_STREAM_VERSION     1    /**< @brief Stream format version. */
+/** @} */
+
 /**
  * @brief   Trace buffer record.
  */
 typedef struct {
-  systime_t             se_time;    /**< @brief Time of the switch event.   */
-  Thread                *se_tp;     /**< @brief Switched in thread.         */
-  void                  *se_wtobjp; /**< @brief Object where going to sleep.*/
-  uint8_t               se_state;   /**< @brief Switched out thread state.  */
-} ch_swc_event_t;
+  uint32_t              te_time;    /**< @brief Timestamp of the event.     */
+  Thread                *te_tp;     /**< @brief Thread involved, for a
+                                                context switch the switched
+                                                in thread.                  */
+  void                  *te_obj;    /**< @brief Object involved, for a
+                                                context switch the switched
+                                                out thread.                 */
+  uint8_t               te_type;    /**< @brief Event type.                 */
+  uint8_t               te_state;   /**< @brief Thread state, for a context
+                                                switch the state of the
+                                                switched out thread.        */
+  uint8_t               te_prio;    /**< @brief Thread priority.            */
+} ch_trace_event_t;
 
 /**
  * @brief   Trace buffer header.
+ * @details The buffer is written only from within the kernel critical zone
+ *          so there is a single writer at time, the reader does not lock
+ *          the kernel and detects the records overwritten while reading.
  */
 typedef struct {
   unsigned              tb_size;    /**< @brief Trace buffer size (entries).*/
-  ch_swc_event_t        *tb_ptr;    /**< @brief Pointer to the buffer front.*/
+  /**
+   * @brief Number of records written, the buffer front is
+   *        <tt>tb_head % tb_size</tt>.
+   */
+  volatile unsigned     tb_head;
+  /**
+   * @brief Number of records read by @p chDbgTraceDrain().
+   */
+  unsigned              tb_tail;
+  /**
+   * @brief Timestamp of the last record written into the stream.
+   */
+  uint32_t              tb_last;
   /** @brief Ring buffer.*/
-  ch_swc_event_t        tb_buffer[CH_TRACE_BUFFER_SIZE];
+  ch_trace_event_t      tb_buffer[CH_TRACE_BUFFER_SIZE];
 } ch_trace_buffer_t;
 
 #if !defined(__DOXYGEN__)
@@ -134,9 +222,122 @@ extern ch_trace_buffer_t dbg_trace_buffer;
 #endif /* CH_DBG_ENABLE_TRACE */
 
 #if !CH_DBG_ENABLE_TRACE
-/* When the trace feature is disabled this function is replaced by an empty
-   macro.*/
+/* When the trace feature is disabled these functions are replaced by empty
+   macros.*/
 #define dbg_trace(otp)
+#define dbg_trace_event(type, tp, obj)
+#define dbg_trace_isr_enter()
+#define dbg_trace_isr_leave()
+#endif
+
+/*===========================================================================*/
+/* Threads accounting related structures and macros.                        */
+/*===========================================================================*/
+
+#if CH_DBG_THREADS_ACCOUNTING || defined(__DOXYGEN__)
+#if !PORT_SUPPORTS_RT
+#error "CH_DBG_THREADS_ACCOUNTING requires a port realtime counter"
+#endif
+#if !CH_USE_REGISTRY
+#error "CH_DBG_THREADS_ACCOUNTING requires CH_USE_REGISTRY"
+#endif
+
+/**
+ * @brief   Threads accounting state.
+ * @details The time between two consecutive accounting events, context
+ *          switches and ISRs enter and leave, is charged to the thread
+ *          being switched out or interrupted, or to the ISRs account.
+ * @note    A thread load is only updated when the thread is charged or
+ *          its load is read, a thread not running since the window end
+ *          did not accumulate time after it so the update is exact.
+ */
+typedef struct {
+  /**
+   * @brief Counter value at the last accounting event.
+   */
+  uint32_t              acc_last;
+  /**
+   * @brief Counter value at the current load window start.
+   */
+  uint32_t              acc_window;
+  /**
+   * @brief Load window length in counter cycles.
+   */
+  uint32_t              acc_period;
+  /**
+   * @brief Serial number of the current load window.
+   */
+  uint32_t              acc_serial;
+  /**
+   * @brief Length of the last closed load window in counter cycles.
+   */
+  uint32_t              acc_elapsed;
+  /**
+   * @brief ISRs nesting level.
+   */
+  cnt_t                 acc_nesting;
+  /**
+   * @brief Number of ISRs served.
+   */
+  uint32_t              acc_isr_count;
+  /**
+   * @brief ISRs load in the last window, in hundredths of percent.
+   */
+  uint16_t              acc_isr_load;
+  /**
+   * @brief Counter cycles spent in ISRs.
+   */
+  uint64_t              acc_isr_time;
+  /**
+   * @brief ISRs time at the current load window start.
+   */
+  uint64_t              acc_isr_mark;
+} ch_accounting_t;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the frequency of the accounting counter.
+ *
+ * @return              The counter frequency in Hz.
+ *
+ * @special
+ */
+#define chDbgGetRunTimeFrequency() port_rt_get_counter_frequency()
+
+/**
+ * @brief   Returns the number of ISRs served.
+ * @note    This counter can overflow.
+ *
+ * @special
+ */
+#define chDbgGetIsrCount() (dbg_accounting.acc_isr_count)
+
+/**
+ * @brief   Returns the ISRs load in the last measurement window.
+ *
+ * @return              The load in hundredths of percent.
+ *
+ * @special
+ */
+#define chDbgGetIsrLoad() (dbg_accounting.acc_isr_load)
+/** @} */
+
+#if !defined(__DOXYGEN__)
+extern ch_accounting_t dbg_accounting;
+#endif
+
+#endif /* CH_DBG_THREADS_ACCOUNTING */
+
+#if !CH_DBG_THREADS_ACCOUNTING
+/* When the accounting feature is disabled these functions are replaced by
+   empty macros.*/
+#define dbg_acc_switch(otp)
+#define dbg_acc_isr_enter()
+#define dbg_acc_isr_leave()
+#define dbg_acc_tick()
 #endif
 
 /*===========================================================================*/
@@ -240,6 +441,20 @@ extern "C" {
 #if CH_DBG_ENABLE_TRACE || defined(__DOXYGEN__)
   void _trace_init(void);
   void dbg_trace(Thread *otp);
+  void dbg_trace_event(uint8_t type, Thread *tp, void *obj);
+  void dbg_trace_isr_enter(void);
+  void dbg_trace_isr_leave(void);
+  void chDbgTraceStart(BaseSequentialStream *chp);
+  unsigned chDbgTraceDrain(BaseSequentialStream *chp);
+#endif
+#if CH_DBG_THREADS_ACCOUNTING || defined(__DOXYGEN__)
+  void _acc_init(void);
+  void dbg_acc_roll(Thread *tp);
+  void dbg_acc_switch(Thread *otp);
+  void dbg_acc_isr_enter(void);
+  void dbg_acc_isr_leave(void);
+  void dbg_acc_tick(void);
+  uint64_t chDbgGetIsrRunTime(void);
 #endif
 #if CH_DBG_ENABLED
   extern const char *dbg_panic_msg;
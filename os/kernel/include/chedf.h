@@ -0,0 +1,125 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    chedf.h
+ * @brief   EDF scheduling class macros and structures.
+ *
+ * @addtogroup edf
+ * @{
+ */
+
+#ifndef _CHEDF_H_
+#define _CHEDF_H_
+
+#if CH_USE_EDF || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if (CH_EDF_PRIORITY <= LOWPRIO) || (CH_EDF_PRIORITY > HIGHPRIO)
+#error "invalid CH_EDF_PRIORITY value"
+#endif
+
+#if CH_USE_VT_DEFERRED && (CH_EDF_PRIORITY == CH_VT_SERVICE_PRIORITY)
+#error "CH_EDF_PRIORITY and CH_VT_SERVICE_PRIORITY must be different"
+#endif
+
+/**
+ * @brief   EDF state of a thread.
+ */
+typedef struct {
+  systime_t             ed_period;  /**< @brief Activation period, zero if
+                                                the thread is not an EDF
+                                                thread.                     */
+  systime_t             ed_reldl;   /**< @brief Relative deadline.          */
+  systime_t             ed_release; /**< @brief Current job release time.   */
+  systime_t             ed_deadline;/**< @brief Current job absolute
+                                                deadline.                   */
+  VirtualTimer          ed_timer;   /**< @brief Deadline miss detection
+                                                timer.                      */
+  uint32_t              ed_jobs;    /**< @brief Completed jobs counter.     */
+  uint32_t              ed_misses;  /**< @brief Missed deadlines counter.   */
+} EdfState;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns @p TRUE if the specified thread is an EDF thread.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @special
+ */
+#define chEdfIsEdfThread(tp) ((tp)->p_edf.ed_period != 0)
+
+/**
+ * @brief   Returns the absolute deadline of the current job.
+ *
+ * @param[in] tp        pointer to an EDF thread
+ *
+ * @special
+ */
+#define chEdfGetDeadline(tp) ((tp)->p_edf.ed_deadline)
+
+/**
+ * @brief   Returns the number of completed jobs.
+ *
+ * @param[in] tp        pointer to an EDF thread
+ *
+ * @special
+ */
+#define chEdfGetJobs(tp) ((tp)->p_edf.ed_jobs)
+
+/**
+ * @brief   Returns the number of missed deadlines.
+ * @details A deadline is missed when the job is not completed, by calling
+ *          @p chEdfWaitNextPeriod(), before its absolute deadline.
+ *
+ * @param[in] tp        pointer to an EDF thread
+ *
+ * @special
+ */
+#define chEdfGetMisses(tp) ((tp)->p_edf.ed_misses)
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chEdfEnter(systime_t period, systime_t deadline);
+  bool_t chEdfWaitNextPeriod(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CH_USE_EDF */
+
+#endif /* _CHEDF_H_ */
+
+/** @} */
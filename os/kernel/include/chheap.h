@@ -49,8 +49,111 @@
 #error "CH_USE_HEAP requires CH_USE_MUTEXES and/or CH_USE_SEMAPHORES"
 #endif
 
+/**
+ * @brief   TLSF heap allocator.
+ * @details If enabled the heap allocator uses a two-level segregated fit
+ *          algorithm instead of the first-fit one, both the allocation and
+ *          the release are constant time operations.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_HEAP_TLSF) || defined(__DOXYGEN__)
+#define CH_USE_HEAP_TLSF                FALSE
+#endif
+
+/**
+ * @brief   Number of TLSF first level classes.
+ * @details The first level class @p n, for @p n greater than zero, holds
+ *          the free blocks whose size is between <tt>S * 2^(n-1)</tt> and
+ *          <tt>S * 2^n</tt> where @p S is the number of second level classes
+ *          multiplied by the alignment size. Bigger blocks are kept in the
+ *          last class.
+ */
+#if !defined(CH_HEAP_TLSF_FL_COUNT) || defined(__DOXYGEN__)
+#define CH_HEAP_TLSF_FL_COUNT           16
+#endif
+
+/**
+ * @brief   Base two logarithm of the number of TLSF second level classes.
+ * @details Each first level class is split in <tt>2^CH_HEAP_TLSF_SL_LOG2</tt>
+ *          linear second level classes, more classes reduce the internal
+ *          fragmentation at the cost of a bigger heap descriptor.
+ */
+#if !defined(CH_HEAP_TLSF_SL_LOG2) || defined(__DOXYGEN__)
+#define CH_HEAP_TLSF_SL_LOG2            4
+#endif
+
+/**
+ * @brief   Heap magazines cache.
+ * @details If enabled then the threads can attach a private cache of
+ *          recently released small blocks, the cache serves the
+ *          allocations without locking the heap.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_HEAP_CACHE) || defined(__DOXYGEN__)
+#define CH_USE_HEAP_CACHE               FALSE
+#endif
+
+/**
+ * @brief   Number of size classes in a heap cache.
+ * @details The class @p n holds blocks of <tt>CH_HEAP_CACHE_MIN_SIZE * 2^n</tt>
+ *          bytes, bigger requests bypass the cache.
+ */
+#if !defined(CH_HEAP_CACHE_CLASSES) || defined(__DOXYGEN__)
+#define CH_HEAP_CACHE_CLASSES           4
+#endif
+
+/**
+ * @brief   Size of the smallest heap cache class.
+ * @note    Must be a multiple of the @p stkalign_t type size.
+ */
+#if !defined(CH_HEAP_CACHE_MIN_SIZE) || defined(__DOXYGEN__)
+#define CH_HEAP_CACHE_MIN_SIZE          16
+#endif
+
+/**
+ * @brief   Number of blocks in each heap cache magazine.
+ */
+#if !defined(CH_HEAP_CACHE_DEPTH) || defined(__DOXYGEN__)
+#define CH_HEAP_CACHE_DEPTH             8
+#endif
+
+#if CH_USE_HEAP_CACHE && CH_USE_MALLOC_HEAP
+#error "CH_USE_HEAP_CACHE is not compatible with CH_USE_MALLOC_HEAP"
+#endif
+
+#if CH_USE_HEAP_TLSF && CH_USE_MALLOC_HEAP
+#error "CH_USE_HEAP_TLSF and CH_USE_MALLOC_HEAP are mutually exclusive"
+#endif
+
+#if (CH_HEAP_TLSF_FL_COUNT < 2) || (CH_HEAP_TLSF_FL_COUNT > 31)
+#error "CH_HEAP_TLSF_FL_COUNT must be in the 2..31 range"
+#endif
+
+#if (CH_HEAP_TLSF_SL_LOG2 < 1) || (CH_HEAP_TLSF_SL_LOG2 > 5)
+#error "CH_HEAP_TLSF_SL_LOG2 must be in the 1..5 range"
+#endif
+
 typedef struct memory_heap MemoryHeap;
 
+#if CH_USE_HEAP_TLSF || defined(__DOXYGEN__)
+/**
+ * @brief   Memory heap block header, TLSF allocator.
+ * @details The free blocks store the free list links at the start of their
+ *          payload.
+ */
+union heap_tlsf_header {
+  stkalign_t align;
+  struct {
+    union heap_tlsf_header *prev;   /**< @brief Previous physical block or
+                                                @p NULL.                    */
+    size_t              size;       /**< @brief Size of the memory block,
+                                                the bit zero is set if the
+                                                block is free.              */
+    MemoryHeap          *heap;      /**< @brief Block owner heap.           */
+  } h;
+};
+#endif /* CH_USE_HEAP_TLSF */
+
 /**
  * @brief   Memory heap block header.
  */
@@ -71,7 +174,18 @@ union heap_header {
 struct memory_heap {
   memgetfunc_t          h_provider; /**< @brief Memory blocks provider for
                                                 this heap.                  */
+#if CH_USE_HEAP_TLSF || defined(__DOXYGEN__)
+  uint32_t              h_fl_map;   /**< @brief First level classes
+                                                bitmap.                     */
+  uint32_t              h_sl_map[CH_HEAP_TLSF_FL_COUNT];
+                                    /**< @brief Second level classes
+                                                bitmaps.                    */
+  union heap_tlsf_header *h_blocks[CH_HEAP_TLSF_FL_COUNT]
+                                  [1 << CH_HEAP_TLSF_SL_LOG2];
+                                    /**< @brief Free blocks lists.          */
+#else
   union heap_header     h_free;     /**< @brief Free blocks list header.    */
+#endif
 #if CH_USE_MUTEXES
   Mutex                 h_mtx;      /**< @brief Heap access mutex.          */
 #else
@@ -79,6 +193,52 @@ struct memory_heap {
 #endif
 };
 
+#if CH_USE_HEAP_CACHE || defined(__DOXYGEN__)
+/**
+ * @brief   Structure describing a heap cache.
+ * @details A heap cache holds a magazine of released blocks for each size
+ *          class, it is attached to a single thread and is only accessed by
+ *          that thread so no locking is required.
+ */
+typedef struct {
+  MemoryHeap            *hc_heap;   /**< @brief Cached heap.                */
+  uint32_t              hc_hits;    /**< @brief Allocations served by the
+                                                cache.                      */
+  uint32_t              hc_misses;  /**< @brief Allocations forwarded to the
+                                                heap.                       */
+  cnt_t                 hc_count[CH_HEAP_CACHE_CLASSES];
+                                    /**< @brief Blocks in each magazine.    */
+  void                  *hc_blocks[CH_HEAP_CACHE_CLASSES]
+                                  [CH_HEAP_CACHE_DEPTH];
+                                    /**< @brief Magazines.                  */
+} HeapCache;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the number of allocations served by a heap cache.
+ *
+ * @param[in] hcp       pointer to a @p HeapCache structure
+ * @return              The hits counter.
+ *
+ * @special
+ */
+#define chHeapCacheGetHits(hcp) ((hcp)->hc_hits)
+
+/**
+ * @brief   Returns the number of allocations forwarded to the heap.
+ *
+ * @param[in] hcp       pointer to a @p HeapCache structure
+ * @return              The misses counter.
+ *
+ * @special
+ */
+#define chHeapCacheGetMisses(hcp) ((hcp)->hc_misses)
+/** @} */
+#endif /* CH_USE_HEAP_CACHE */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -89,6 +249,12 @@ extern "C" {
   void *chHeapAlloc(MemoryHeap *heapp, size_t size);
   void chHeapFree(void *p);
   size_t chHeapStatus(MemoryHeap *heapp, size_t *sizep);
+#if CH_USE_HEAP_CACHE
+  void chHeapCacheInit(HeapCache *hcp, MemoryHeap *heapp);
+  void chHeapCacheAttach(HeapCache *hcp);
+  void chHeapCacheDetach(void);
+  void chHeapCacheFlush(HeapCache *hcp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -69,12 +69,18 @@ extern "C" {
   msg_t chMBPost(Mailbox *mbp, msg_t msg, systime_t timeout);
   msg_t chMBPostS(Mailbox *mbp, msg_t msg, systime_t timeout);
   msg_t chMBPostI(Mailbox *mbp, msg_t msg);
+  cnt_t chMBPostN(Mailbox *mbp, const msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBPostNS(Mailbox *mbp, const msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBPostNI(Mailbox *mbp, const msg_t *msgs, cnt_t n);
   msg_t chMBPostAhead(Mailbox *mbp, msg_t msg, systime_t timeout);
   msg_t chMBPostAheadS(Mailbox *mbp, msg_t msg, systime_t timeout);
   msg_t chMBPostAheadI(Mailbox *mbp, msg_t msg);
   msg_t chMBFetch(Mailbox *mbp, msg_t *msgp, systime_t timeout);
   msg_t chMBFetchS(Mailbox *mbp, msg_t *msgp, systime_t timeout);
   msg_t chMBFetchI(Mailbox *mbp, msg_t *msgp);
+  cnt_t chMBFetchN(Mailbox *mbp, msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBFetchNS(Mailbox *mbp, msg_t *msgs, cnt_t n, systime_t time);
+  cnt_t chMBFetchNI(Mailbox *mbp, msg_t *msgs, cnt_t n);
 #ifdef __cplusplus
 }
 #endif
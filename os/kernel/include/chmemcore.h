@@ -75,6 +75,95 @@ typedef void *(*memgetfunc_t)(size_t size);
 
 #if CH_USE_MEMCORE || defined(__DOXYGEN__)
 
+/**
+ * @brief   Core memory regions.
+ * @details If enabled the core allocator can manage multiple memory regions
+ *          with attributes, the default region is the one previously used
+ *          by the core allocator and more regions can be registered using
+ *          @p chCoreRegisterRegion().
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_MEMCORE_REGIONS) || defined(__DOXYGEN__)
+#define CH_USE_MEMCORE_REGIONS          FALSE
+#endif
+
+#if CH_USE_MEMCORE_REGIONS || defined(__DOXYGEN__)
+/**
+ * @name    Memory region attributes
+ * @{
+ */
+/**
+ * @brief   The region is reachable by the DMA controllers.
+ */
+#define MEM_ATTR_DMA        1
+
+/**
+ * @brief   The region is the fastest memory, for example a core coupled RAM.
+ */
+#define MEM_ATTR_FAST       2
+
+/**
+ * @brief   The region content is retained across resets and low power
+ *          states.
+ */
+#define MEM_ATTR_RETAINED   4
+/** @} */
+
+/**
+ * @brief   Attributes of the default region.
+ */
+#if !defined(CH_MEMCORE_ATTRIBUTES) || defined(__DOXYGEN__)
+#define CH_MEMCORE_ATTRIBUTES           MEM_ATTR_DMA
+#endif
+
+/**
+ * @brief   Alignment of the blocks returned by @p chCoreAllocDMA().
+ * @note    The default is a typical cache line size so that DMA buffers
+ *          never share cache lines with other data.
+ */
+#if !defined(CH_MEMCORE_DMA_ALIGN) || defined(__DOXYGEN__)
+#define CH_MEMCORE_DMA_ALIGN            32
+#endif
+
+/**
+ * @brief   Memory region attributes type.
+ */
+typedef uint8_t memattr_t;
+
+/**
+ * @brief   Structure representing a core memory region.
+ */
+typedef struct memory_region MemoryRegion;
+
+struct memory_region {
+  MemoryRegion          *mr_link;   /**< @brief Next registered region.     */
+  const char            *mr_name;   /**< @brief Region name.                */
+  uint8_t               *mr_next;   /**< @brief First free byte.            */
+  uint8_t               *mr_end;    /**< @brief Region end.                 */
+  memattr_t             mr_attr;    /**< @brief Region attributes.          */
+};
+
+/**
+ * @brief   Returns the name of a region.
+ *
+ * @param[in] mrp       pointer to a @p MemoryRegion structure
+ * @return              The region name.
+ *
+ * @special
+ */
+#define chCoreGetRegionName(mrp) ((mrp)->mr_name)
+
+/**
+ * @brief   Returns the attributes of a region.
+ *
+ * @param[in] mrp       pointer to a @p MemoryRegion structure
+ * @return              The region attributes.
+ *
+ * @special
+ */
+#define chCoreGetRegionAttributes(mrp) ((mrp)->mr_attr)
+#endif /* CH_USE_MEMCORE_REGIONS */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -82,6 +171,20 @@ extern "C" {
   void *chCoreAlloc(size_t size);
   void *chCoreAllocI(size_t size);
   size_t chCoreStatus(void);
+#if CH_USE_MEMCORE_REGIONS
+  void chCoreRegisterRegion(MemoryRegion *mrp, const char *name,
+                            void *base, size_t size, memattr_t attr);
+  MemoryRegion *chCoreGetRegion(const char *name);
+  MemoryRegion *chCoreNextRegion(MemoryRegion *mrp);
+  size_t chCoreRegionStatus(MemoryRegion *mrp);
+  void *chCoreAllocAlignedI(MemoryRegion *mrp, size_t size, size_t align);
+  void *chCoreAllocPlacedI(size_t size, size_t align,
+                           memattr_t required, memattr_t preferred);
+  void *chCoreAllocPlaced(size_t size, size_t align,
+                          memattr_t required, memattr_t preferred);
+  void *chCoreAllocDMA(size_t size);
+  void *chCoreAllocFast(size_t size);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -38,6 +38,20 @@
 
 #if CH_USE_MEMPOOLS || defined(__DOXYGEN__)
 
+/**
+ * @brief   Lock-free memory pools.
+ * @details If enabled the @p LockFreePool objects and APIs are included,
+ *          the objects are allocated and released without the kernel lock
+ *          using a compare-and-swap on a tagged list head.
+ * @note    Requires a port providing the @p port_dword_t type and the
+ *          @p port_atomic_cas() and @p port_atomic_cas2() compare-and-swap
+ *          primitives, signaled by @p PORT_SUPPORTS_ATOMIC_CAS.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_MEMPOOLS_LOCKFREE) || defined(__DOXYGEN__)
+#define CH_USE_MEMPOOLS_LOCKFREE        FALSE
+#endif
+
 /**
  * @brief   Memory pool free object header.
  */
@@ -121,6 +135,85 @@ typedef struct {
 #define chPoolAddI(mp, objp) chPoolFreeI(mp, objp)
 /** @} */
 
+#if CH_USE_MEMPOOLS_LOCKFREE || defined(__DOXYGEN__)
+/*
+ * Module dependencies check.
+ */
+#if !PORT_SUPPORTS_ATOMIC_CAS
+#error "CH_USE_MEMPOOLS_LOCKFREE requires a port compare-and-swap"
+#endif
+
+/**
+ * @brief   Lock-free pools race window hook.
+ * @details This hook is invoked between the read of the list head and the
+ *          compare-and-swap, it is empty by default. A test configuration
+ *          can define it in order to serve interrupts inside the window.
+ */
+#if !defined(CH_LFPOOL_CAS_HOOK) || defined(__DOXYGEN__)
+#define CH_LFPOOL_CAS_HOOK()
+#endif
+
+/**
+ * @brief   Tagged list head of a lock-free pool.
+ * @details The tag is incremented on each update so that a head that has
+ *          been removed and reinserted in the meanwhile is not mistaken
+ *          for the original one (ABA problem).
+ */
+typedef union {
+  struct {
+    struct pool_header  *ptr;           /**< @brief First free object.      */
+    uintptr_t           tag;            /**< @brief Modifications count.    */
+  } t;
+  port_dword_t          w;              /**< @brief Atomic access.          */
+} lfpool_head_t;
+
+/**
+ * @brief   Lock-free memory pool descriptor.
+ * @note    The pool cannot grow automatically, the objects are added using
+ *          @p chLFPoolLoadArray() or @p chLFPoolFree().
+ */
+typedef struct {
+  volatile lfpool_head_t lp_head;       /**< @brief Tagged list head.       */
+  size_t                lp_object_size; /**< @brief Objects size.           */
+  volatile cnt_t        lp_used;        /**< @brief Objects in use.         */
+  volatile cnt_t        lp_highwater;   /**< @brief Maximum objects in use. */
+  volatile uint32_t     lp_failures;    /**< @brief Failed allocations.     */
+} LockFreePool;
+
+/**
+ * @brief   Returns the number of objects currently in use.
+ *
+ * @param[in] lp        pointer to a @p LockFreePool structure
+ * @return              The objects count, it can be negative if objects
+ *                      not previously allocated have been added using
+ *                      @p chLFPoolFree().
+ *
+ * @special
+ */
+#define chLFPoolGetUsed(lp) ((lp)->lp_used)
+
+/**
+ * @brief   Returns the maximum number of objects in use at the same time.
+ *
+ * @param[in] lp        pointer to a @p LockFreePool structure
+ * @return              The high-water mark.
+ *
+ * @special
+ */
+#define chLFPoolGetHighWater(lp) ((lp)->lp_highwater)
+
+/**
+ * @brief   Returns the number of allocations failed because the pool was
+ *          empty.
+ *
+ * @param[in] lp        pointer to a @p LockFreePool structure
+ * @return              The failures count.
+ *
+ * @special
+ */
+#define chLFPoolGetFailures(lp) ((lp)->lp_failures)
+#endif /* CH_USE_MEMPOOLS_LOCKFREE */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -130,6 +223,12 @@ extern "C" {
   void *chPoolAlloc(MemoryPool *mp);
   void chPoolFreeI(MemoryPool *mp, void *objp);
   void chPoolFree(MemoryPool *mp, void *objp);
+#if CH_USE_MEMPOOLS_LOCKFREE
+  void chLFPoolInit(LockFreePool *lp, size_t size);
+  void chLFPoolLoadArray(LockFreePool *lp, void *p, size_t n);
+  void *chLFPoolAlloc(LockFreePool *lp);
+  void chLFPoolFree(LockFreePool *lp, void *objp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -75,12 +75,158 @@
 #define chMsgReleaseS(tp, msg) chSchWakeupS(tp, msg)
 /** @} */
 
+/**
+ * @brief   Asynchronous message ports APIs.
+ * @details If enabled then the asynchronous message ports are included in
+ *          the kernel.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_MESSAGES_ASYNC) || defined(__DOXYGEN__)
+#define CH_USE_MESSAGES_ASYNC           FALSE
+#endif
+
+#if CH_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @name    Future states
+ * @{
+ */
+#define MSG_FUTURE_PENDING  0       /**< @brief Posted, not yet completed.  */
+#define MSG_FUTURE_DONE     1       /**< @brief Completed, reply available. */
+/** @} */
+
+/**
+ * @brief   Type of a message future.
+ */
+typedef struct msg_future MsgFuture;
+
+/**
+ * @brief   Structure representing a message future.
+ * @details A future carries an asynchronous request to the server and its
+ *          reply back to the client, it is allocated by the client and must
+ *          not be reused until it has been completed.
+ */
+struct msg_future {
+  MsgFuture             *mf_next;   /**< @brief Next posted future.         */
+  msg_t                 mf_msg;     /**< @brief Request message.            */
+  msg_t                 mf_reply;   /**< @brief Reply message.              */
+  Thread                *mf_waiter; /**< @brief Thread waiting for the
+                                                reply or @p NULL.           */
+  volatile uint8_t      mf_state;   /**< @brief Future state.               */
+};
+
+/**
+ * @brief   Structure representing an asynchronous message port.
+ */
+typedef struct {
+  MsgFuture             *mp_head;   /**< @brief First posted future.        */
+  MsgFuture             *mp_tail;   /**< @brief Last posted future.         */
+  Thread                *mp_server; /**< @brief Thread waiting for requests
+                                                or @p NULL.                 */
+} MsgPort;
+
+/**
+ * @brief   Data part of a static message port initializer.
+ * @details This macro should be used when statically initializing a
+ *          message port that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the message port variable
+ */
+#define _MSGPORT_DATA(name) {NULL, NULL, NULL}
+
+/**
+ * @brief   Static message port initializer.
+ * @details Statically initialized message ports require no explicit
+ *          initialization using @p chMsgPortInit().
+ *
+ * @param[in] name      the name of the message port variable
+ */
+#define MSGPORT_DECL(name) MsgPort name = _MSGPORT_DATA(name)
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns @p TRUE if the future has been completed.
+ * @note    This macro can be used for polling without entering the kernel.
+ *
+ * @param[in] mfp       pointer to a @p MsgFuture structure
+ *
+ * @special
+ */
+#define chMsgFutureIsDone(mfp) ((mfp)->mf_state == MSG_FUTURE_DONE)
+
+/**
+ * @brief   Returns the reply of a completed future.
+ * @pre     The future must be completed.
+ *
+ * @param[in] mfp       pointer to a @p MsgFuture structure
+ * @return              The reply message.
+ *
+ * @special
+ */
+#define chMsgFutureGetReply(mfp) ((mfp)->mf_reply)
+
+/**
+ * @brief   Returns the request message carried by a future.
+ *
+ * @param[in] mfp       pointer to a @p MsgFuture structure
+ * @return              The request message.
+ *
+ * @special
+ */
+#define chMsgFutureGetMsg(mfp) ((mfp)->mf_msg)
+
+/**
+ * @brief   Returns the next future in a fetched batch.
+ * @note    The link must be read before completing the future because a
+ *          completed future can be immediately reused by the client.
+ *
+ * @param[in] mfp       pointer to a @p MsgFuture structure
+ * @return              The next future or @p NULL.
+ *
+ * @special
+ */
+#define chMsgFutureNext(mfp) ((mfp)->mf_next)
+
+/**
+ * @brief   Waits for the requests posted to a port.
+ *
+ * @param[in] mpp       pointer to a @p MsgPort structure
+ * @return              The list of the posted futures in FIFO order.
+ *
+ * @api
+ */
+#define chMsgPortFetch(mpp) chMsgPortFetchTimeout(mpp, TIME_INFINITE)
+
+/**
+ * @brief   Waits for the completion of a future.
+ *
+ * @param[in] mfp       pointer to a @p MsgFuture structure
+ * @return              The reply message.
+ *
+ * @api
+ */
+#define chMsgFutureWait(mfp) chMsgFutureWaitTimeout(mfp, TIME_INFINITE)
+/** @} */
+#endif /* CH_USE_MESSAGES_ASYNC */
+
 #ifdef __cplusplus
 extern "C" {
 #endif
   msg_t chMsgSend(Thread *tp, msg_t msg);
   Thread * chMsgWait(void);
   void chMsgRelease(Thread *tp, msg_t msg);
+#if CH_USE_MESSAGES_ASYNC
+  void chMsgPortInit(MsgPort *mpp);
+  void chMsgPostI(MsgPort *mpp, MsgFuture *mfp, msg_t msg);
+  void chMsgPost(MsgPort *mpp, MsgFuture *mfp, msg_t msg);
+  MsgFuture *chMsgPortFetchI(MsgPort *mpp);
+  MsgFuture *chMsgPortFetchTimeout(MsgPort *mpp, systime_t time);
+  void chMsgCompleteI(MsgFuture *mfp, msg_t reply);
+  void chMsgComplete(MsgFuture *mfp, msg_t reply);
+  msg_t chMsgFutureWaitTimeout(MsgFuture *mfp, systime_t time);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -38,6 +38,17 @@
 
 #if CH_USE_MUTEXES || defined(__DOXYGEN__)
 
+/**
+ * @brief   Priority ceiling mutexes.
+ * @details If enabled the mutexes can be initialized with a static priority
+ *          ceiling, a thread locking such a mutex is immediately raised to
+ *          the ceiling priority instead of relying on priority inheritance.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_MUTEXES_CEILING) || defined(__DOXYGEN__)
+#define CH_USE_MUTEXES_CEILING          FALSE
+#endif
+
 /**
  * @brief   Mutex structure.
  */
@@ -48,12 +59,23 @@ typedef struct Mutex {
                                                 @p NULL.                    */
   struct Mutex          *m_next;    /**< @brief Next @p Mutex into an
                                                 owner-list or @p NULL.      */
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+  tprio_t               m_ceiling;  /**< @brief Ceiling priority or zero
+                                                for priority inheritance.   */
+#endif
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+  AdaptiveWait          m_aw;       /**< @brief Adaptive wait settings and
+                                                counters.                   */
+#endif
 } Mutex;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
   void chMtxInit(Mutex *mp);
+#if CH_USE_MUTEXES_CEILING
+  void chMtxInitCeiling(Mutex *mp, tprio_t ceiling);
+#endif
   void chMtxLock(Mutex *mp);
   void chMtxLockS(Mutex *mp);
   bool_t chMtxTryLock(Mutex *mp);
@@ -61,6 +83,8 @@ extern "C" {
   Mutex *chMtxUnlock(void);
   Mutex *chMtxUnlockS(void);
   void chMtxUnlockAll(void);
+  void _mtx_prio_boost(Mutex *mp);
+  void _mtx_prio_restore(Thread *tp);
 #ifdef __cplusplus
 }
 #endif
@@ -72,7 +96,7 @@ extern "C" {
  *
  * @param[in] name      the name of the mutex variable
  */
-#define _MUTEX_DATA(name) {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL}
+#define _MUTEX_DATA(name) _MUTEX_CEILING_DATA(name, 0)
 
 /**
  * @brief   Static mutex initializer.
@@ -83,6 +107,43 @@ extern "C" {
  */
 #define MUTEX_DECL(name) Mutex name = _MUTEX_DATA(name)
 
+/**
+ * @brief   Data part of a static priority ceiling mutex initializer.
+ * @details This macro should be used when statically initializing a
+ *          priority ceiling mutex that is part of a bigger structure.
+ * @note    A zero ceiling specifies a priority inheritance mutex.
+ *
+ * @param[in] name      the name of the mutex variable
+ * @param[in] ceiling   the ceiling priority
+ */
+#if CH_USE_MUTEXES_CEILING && CH_USE_ADAPTIVE_WAIT
+#define _MUTEX_CEILING_DATA(name, ceiling)                                  \
+  {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL, ceiling, _ADAPTIVEWAIT_DATA}
+#elif CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+#define _MUTEX_CEILING_DATA(name, ceiling)                                  \
+  {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL, ceiling}
+#elif CH_USE_ADAPTIVE_WAIT
+#define _MUTEX_CEILING_DATA(name, ceiling)                                  \
+  {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL, _ADAPTIVEWAIT_DATA}
+#else
+#define _MUTEX_CEILING_DATA(name, ceiling)                                  \
+  {_THREADSQUEUE_DATA(name.m_queue), NULL, NULL}
+#endif
+
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+
+/**
+ * @brief   Static priority ceiling mutex initializer.
+ * @details Statically initialized mutexes require no explicit initialization
+ *          using @p chMtxInitCeiling().
+ *
+ * @param[in] name      the name of the mutex variable
+ * @param[in] ceiling   the ceiling priority
+ */
+#define MUTEX_CEILING_DECL(name, ceiling)                                   \
+  Mutex name = _MUTEX_CEILING_DATA(name, ceiling)
+#endif
+
 /**
  * @name    Macro Functions
  * @{
@@ -94,6 +155,37 @@ extern "C" {
  * @sclass
  */
 #define chMtxQueueNotEmptyS(mp) notempty(&(mp)->m_queue)
+
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+/**
+ * @brief   Sets the adaptive wait iterations limit.
+ * @details A thread locking an owned mutex yields to the other ready threads
+ *          with equal or higher priority for at most @p n iterations before
+ *          sleeping.
+ * @pre     This function is only available when the
+ *          @p CH_USE_ADAPTIVE_WAIT configuration option is enabled.
+ *
+ * @param[in] mp        pointer to a @p Mutex structure
+ * @param[in] n         the iterations limit, zero disables the adaptive wait
+ *
+ * @api
+ */
+#define chMtxSetAdaptive(mp, n) ((mp)->m_aw.aw_limit = (n))
+
+/**
+ * @brief   Returns the number of adaptive waits satisfied without sleeping.
+ *
+ * @api
+ */
+#define chMtxGetAdaptiveHits(mp) ((mp)->m_aw.aw_hits)
+
+/**
+ * @brief   Returns the number of adaptive waits ended sleeping.
+ *
+ * @api
+ */
+#define chMtxGetAdaptiveMisses(mp) ((mp)->m_aw.aw_misses)
+#endif /* CH_USE_ADAPTIVE_WAIT */
 /** @} */
 
 #endif /* CH_USE_MUTEXES */
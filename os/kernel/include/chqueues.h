@@ -78,6 +78,17 @@ struct GenericQueue {
   void                  *q_link;    /**< @brief Application defined field.  */
 };
 
+/**
+ * @brief   Type of a queue span.
+ * @details A span describes a queue area as up to two contiguous regions,
+ *          the second region is used only when the area wraps around the
+ *          end of the queue buffer, its size is zero otherwise.
+ */
+typedef struct {
+  uint8_t               *qs_ptr[2]; /**< @brief Regions start pointers.     */
+  size_t                qs_size[2]; /**< @brief Regions sizes.              */
+} QueueSpan;
+
 /**
  * @name    Macro Functions
  * @{
@@ -358,6 +369,11 @@ extern "C" {
   msg_t chIQGetTimeout(InputQueue *iqp, systime_t time);
   size_t chIQReadTimeout(InputQueue *iqp, uint8_t *bp,
                          size_t n, systime_t time);
+  size_t chIQGetWriteSpanI(InputQueue *iqp, QueueSpan *sp);
+  void chIQCommitWriteI(InputQueue *iqp, size_t n);
+  size_t chIQGetReadSpanTimeout(InputQueue *iqp, QueueSpan *sp,
+                                systime_t time);
+  void chIQCommitRead(InputQueue *iqp, size_t n);
 
   void chOQInit(OutputQueue *oqp, uint8_t *bp, size_t size, qnotify_t onfy,
                 void *link);
@@ -366,9 +382,339 @@ extern "C" {
   msg_t chOQGetI(OutputQueue *oqp);
   size_t chOQWriteTimeout(OutputQueue *oqp, const uint8_t *bp,
                           size_t n, systime_t time);
+  size_t chOQGetWriteSpanTimeout(OutputQueue *oqp, QueueSpan *sp,
+                                 systime_t time);
+  void chOQCommitWrite(OutputQueue *oqp, size_t n);
+  size_t chOQGetReadSpanI(OutputQueue *oqp, QueueSpan *sp);
+  void chOQCommitReadI(OutputQueue *oqp, size_t n);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief   Lock-free rings APIs.
+ * @details If enabled then the single producer, single consumer byte rings
+ *          are included in the kernel.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_QUEUES_RINGS) || defined(__DOXYGEN__)
+#define CH_USE_QUEUES_RINGS             FALSE
+#endif
+
+#if CH_USE_QUEUES_RINGS || defined(__DOXYGEN__)
+/**
+ * @brief   Size of the padding separating the ring indexes.
+ * @details The head and tail indexes of a ring are separated by this
+ *          amount of bytes so that the producer and the consumer never
+ *          write in the same cache line.
+ */
+#if !defined(CH_RING_LINE_SIZE) || defined(__DOXYGEN__)
+#define CH_RING_LINE_SIZE               32
+#endif
+
+/**
+ * @brief   Type of a generic byte ring structure.
+ */
+typedef struct ByteRing ByteRing;
+
+/** @brief Ring notification callback type.*/
+typedef void (*rnotify_t)(ByteRing *rp);
+
+/**
+ * @brief   Generic byte ring structure.
+ * @details This structure represents a single producer, single consumer
+ *          ring. The producer only writes the head index and the consumer
+ *          only writes the tail index, so the data is moved without
+ *          entering the kernel lock. The kernel lock is entered only in
+ *          order to put the thread side to sleep, to wake it up and to
+ *          invoke the notification callback.<br>
+ *          The indexes are free running, the ring is empty when they are
+ *          equal and full when their difference equals the ring size.
+ * @pre     The ring size must be a power of two.
+ * @pre     The @p size_t loads and stores must be atomic on the target
+ *          architecture.
+ */
+struct ByteRing {
+  volatile size_t       r_head;     /**< @brief Producer index.             */
+  uint8_t               r_pad1[CH_RING_LINE_SIZE - sizeof (size_t)];
+  volatile size_t       r_tail;     /**< @brief Consumer index.             */
+  uint8_t               r_pad2[CH_RING_LINE_SIZE - sizeof (size_t)];
+  ThreadsQueue          r_waiting;  /**< @brief Queue of waiting threads.   */
+  uint8_t               *r_buffer;  /**< @brief Pointer to the ring buffer. */
+  size_t                r_mask;     /**< @brief Ring size minus one.        */
+  rnotify_t             r_notify;   /**< @brief Data notification callback. */
+  void                  *r_link;    /**< @brief Application defined field.  */
+};
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the ring's buffer size.
+ *
+ * @param[in] rp        pointer to a @p ByteRing structure.
+ * @return              The buffer size.
+ *
+ * @iclass
+ */
+#define chRSizeI(rp) ((rp)->r_mask + 1)
+
+/**
+ * @brief   Returns the number of bytes in a ring.
+ *
+ * @param[in] rp        pointer to a @p ByteRing structure.
+ * @return              The number of full bytes in the ring.
+ *
+ * @iclass
+ */
+#define chRSpaceI(rp) ((size_t)((rp)->r_head - (rp)->r_tail))
+
+/**
+ * @brief   Returns the ring application-defined link.
+ * @note    This function can be called in any context.
+ *
+ * @param[in] rp        pointer to a @p ByteRing structure.
+ * @return              The application-defined link.
+ *
+ * @special
+ */
+#define chRGetLink(rp) ((rp)->r_link)
+/** @} */
+
+/**
+ * @extends ByteRing
+ *
+ * @brief   Type of an input ring structure.
+ * @details This structure represents a lock-free input ring, the
+ *          counterpart of an @p InputQueue. Writing to the ring is
+ *          non-blocking and is performed from interrupt handlers or from
+ *          within a kernel lock zone. Reading the ring can be a blocking
+ *          operation and is supposed to be performed by a single system
+ *          thread.
+ */
+typedef ByteRing InputRing;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the filled space into an input ring.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure
+ * @return              The number of full bytes in the ring.
+ * @retval 0            if the ring is empty.
+ *
+ * @iclass
+ */
+#define chIRGetFullI(irp) chRSpaceI(irp)
+
+/**
+ * @brief   Returns the empty space into an input ring.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure
+ * @return              The number of empty bytes in the ring.
+ * @retval 0            if the ring is full.
+ *
+ * @iclass
+ */
+#define chIRGetEmptyI(irp) (chRSizeI(irp) - chRSpaceI(irp))
+
+/**
+ * @brief   Evaluates to @p TRUE if the specified input ring is empty.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure.
+ * @return              The ring status.
+ * @retval FALSE        if the ring is not empty.
+ * @retval TRUE         if the ring is empty.
+ *
+ * @iclass
+ */
+#define chIRIsEmptyI(irp) ((bool_t)(chRSpaceI(irp) == 0))
+
+/**
+ * @brief   Evaluates to @p TRUE if the specified input ring is full.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure.
+ * @return              The ring status.
+ * @retval FALSE        if the ring is not full.
+ * @retval TRUE         if the ring is full.
+ *
+ * @iclass
+ */
+#define chIRIsFullI(irp) ((bool_t)(chRSpaceI(irp) >= chRSizeI(irp)))
+
+/**
+ * @brief   Input ring read.
+ * @details This function reads a byte value from an input ring. If the ring
+ *          is empty then the calling thread is suspended until a byte arrives
+ *          in the ring.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure
+ * @return              A byte value from the ring.
+ * @retval Q_RESET      if the ring has been reset.
+ *
+ * @api
+ */
+#define chIRGet(irp) chIRGetTimeout(irp, TIME_INFINITE)
+/** @} */
+
+/**
+ * @brief   Data part of a static ring initializer.
+ * @details This macro should be used when statically initializing a
+ *          ring that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the ring variable
+ * @param[in] buffer    pointer to the ring buffer area
+ * @param[in] size      size of the ring buffer area, must be a power of two
+ * @param[in] notify    notification callback pointer
+ * @param[in] link      application defined pointer
+ */
+#define _BYTERING_DATA(name, buffer, size, notify, link) {                  \
+  0,                                                                        \
+  {0},                                                                      \
+  0,                                                                        \
+  {0},                                                                      \
+  _THREADSQUEUE_DATA(name.r_waiting),                                       \
+  (uint8_t *)(buffer),                                                      \
+  (size_t)(size) - 1,                                                       \
+  (notify),                                                                 \
+  (link)                                                                    \
+}
+
+/**
+ * @brief   Static input ring initializer.
+ * @details Statically initialized input rings require no explicit
+ *          initialization using @p chIRInit().
+ *
+ * @param[in] name      the name of the input ring variable
+ * @param[in] buffer    pointer to the ring buffer area
+ * @param[in] size      size of the ring buffer area, must be a power of two
+ * @param[in] inotify   input notification callback pointer
+ * @param[in] link      application defined pointer
+ */
+#define INPUTRING_DECL(name, buffer, size, inotify, link)                   \
+  InputRing name = _BYTERING_DATA(name, buffer, size, inotify, link)
+
+/**
+ * @extends ByteRing
+ *
+ * @brief   Type of an output ring structure.
+ * @details This structure represents a lock-free output ring, the
+ *          counterpart of an @p OutputQueue. Reading from the ring is
+ *          non-blocking and is performed from interrupt handlers or from
+ *          within a kernel lock zone. Writing the ring can be a blocking
+ *          operation and is supposed to be performed by a single system
+ *          thread.
+ */
+typedef ByteRing OutputRing;
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns the filled space into an output ring.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure
+ * @return              The number of full bytes in the ring.
+ * @retval 0            if the ring is empty.
+ *
+ * @iclass
+ */
+#define chORGetFullI(orp) chRSpaceI(orp)
+
+/**
+ * @brief   Returns the empty space into an output ring.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure
+ * @return              The number of empty bytes in the ring.
+ * @retval 0            if the ring is full.
+ *
+ * @iclass
+ */
+#define chORGetEmptyI(orp) (chRSizeI(orp) - chRSpaceI(orp))
+
+/**
+ * @brief   Evaluates to @p TRUE if the specified output ring is empty.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure.
+ * @return              The ring status.
+ * @retval FALSE        if the ring is not empty.
+ * @retval TRUE         if the ring is empty.
+ *
+ * @iclass
+ */
+#define chORIsEmptyI(orp) ((bool_t)(chRSpaceI(orp) == 0))
+
+/**
+ * @brief   Evaluates to @p TRUE if the specified output ring is full.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure.
+ * @return              The ring status.
+ * @retval FALSE        if the ring is not full.
+ * @retval TRUE         if the ring is full.
+ *
+ * @iclass
+ */
+#define chORIsFullI(orp) ((bool_t)(chRSpaceI(orp) >= chRSizeI(orp)))
+
+/**
+ * @brief   Output ring write.
+ * @details This function writes a byte value to an output ring. If the ring
+ *          is full then the calling thread is suspended until there is space
+ *          in the ring.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure
+ * @param[in] b         the byte value to be written in the ring
+ * @return              The operation status.
+ * @retval Q_OK         if the operation succeeded.
+ * @retval Q_RESET      if the ring has been reset.
+ *
+ * @api
+ */
+#define chORPut(orp, b) chORPutTimeout(orp, b, TIME_INFINITE)
+/** @} */
+
+/**
+ * @brief   Static output ring initializer.
+ * @details Statically initialized output rings require no explicit
+ *          initialization using @p chORInit().
+ *
+ * @param[in] name      the name of the output ring variable
+ * @param[in] buffer    pointer to the ring buffer area
+ * @param[in] size      size of the ring buffer area, must be a power of two
+ * @param[in] onotify   output notification callback pointer
+ * @param[in] link      application defined pointer
+ */
+#define OUTPUTRING_DECL(name, buffer, size, onotify, link)                  \
+  OutputRing name = _BYTERING_DATA(name, buffer, size, onotify, link)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chIRInit(InputRing *irp, uint8_t *bp, size_t size, rnotify_t infy,
+                void *link);
+  void chIRResetI(InputRing *irp);
+  msg_t chIRPutI(InputRing *irp, uint8_t b);
+  size_t chIRWriteI(InputRing *irp, const uint8_t *bp, size_t n);
+  msg_t chIRGetTimeout(InputRing *irp, systime_t time);
+  size_t chIRReadTimeout(InputRing *irp, uint8_t *bp,
+                         size_t n, systime_t time);
+
+  void chORInit(OutputRing *orp, uint8_t *bp, size_t size, rnotify_t onfy,
+                void *link);
+  void chORResetI(OutputRing *orp);
+  msg_t chORPutTimeout(OutputRing *orp, uint8_t b, systime_t time);
+  size_t chORWriteTimeout(OutputRing *orp, const uint8_t *bp,
+                          size_t n, systime_t time);
+  msg_t chORGetI(OutputRing *orp);
+  size_t chORReadI(OutputRing *orp, uint8_t *bp, size_t n);
 #ifdef __cplusplus
 }
 #endif
+#endif /* CH_USE_QUEUES_RINGS */
 #endif /* CH_USE_QUEUES */
 
 #endif /* _CHQUEUES_H_ */
@@ -126,6 +126,10 @@ extern "C" {
   extern ROMCONST chdebug_t ch_debug;
   Thread *chRegFirstThread(void);
   Thread *chRegNextThread(Thread *tp);
+#if CH_DBG_THREADS_ACCOUNTING
+  uint64_t chRegGetThreadRunTime(Thread *tp);
+  uint16_t chRegGetThreadLoad(Thread *tp);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,159 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    chrwlock.h
+ * @brief   Readers-writer locks macros and structures.
+ *
+ * @addtogroup rwlocks
+ * @{
+ */
+
+#ifndef _CHRWLOCK_H_
+#define _CHRWLOCK_H_
+
+/**
+ * @brief   Readers-writer locks APIs.
+ * @details If enabled then the readers-writer locks APIs are included in
+ *          the kernel.
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MUTEXES.
+ */
+#if !defined(CH_USE_RWLOCKS) || defined(__DOXYGEN__)
+#define CH_USE_RWLOCKS                  FALSE
+#endif
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+
+/*
+ * Module dependencies check.
+ */
+#if !CH_USE_MUTEXES
+#error "CH_USE_RWLOCKS requires CH_USE_MUTEXES"
+#endif
+
+/**
+ * @brief   RWLock structure.
+ * @details The embedded mutex records the writer ownership, it is inserted
+ *          in the owned mutexes list of the writer so the priority
+ *          inheritance mechanism accounts for the threads waiting on the
+ *          lock. The mutex queue holds both the waiting readers and the
+ *          waiting writers in priority order.
+ */
+typedef struct {
+  Mutex                 rw_mtx;     /**< @brief Writer ownership and waiting
+                                                threads queue.              */
+  cnt_t                 rw_readers; /**< @brief Number of readers holding
+                                                the lock.                   */
+} RWLock;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chRWLockInit(RWLock *rwp);
+  msg_t chRWLockReadLockTimeout(RWLock *rwp, systime_t time);
+  msg_t chRWLockReadLockTimeoutS(RWLock *rwp, systime_t time);
+  void chRWLockReadUnlock(RWLock *rwp);
+  void chRWLockReadUnlockS(RWLock *rwp);
+  msg_t chRWLockWriteLockTimeout(RWLock *rwp, systime_t time);
+  msg_t chRWLockWriteLockTimeoutS(RWLock *rwp, systime_t time);
+  void chRWLockWriteUnlock(RWLock *rwp);
+  void chRWLockWriteUnlockS(RWLock *rwp);
+  void _rw_release(RWLock *rwp);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief   Data part of a static readers-writer lock initializer.
+ * @details This macro should be used when statically initializing a
+ *          readers-writer lock that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the readers-writer lock variable
+ */
+#define _RWLOCK_DATA(name) {_MUTEX_DATA(name.rw_mtx), 0}
+
+/**
+ * @brief   Static readers-writer lock initializer.
+ * @details Statically initialized readers-writer locks require no explicit
+ *          initialization using @p chRWLockInit().
+ *
+ * @param[in] name      the name of the readers-writer lock variable
+ */
+#define RWLOCK_DECL(name) RWLock name = _RWLOCK_DATA(name)
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Acquires the lock in shared mode.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @api
+ */
+#define chRWLockReadLock(rwp)                                               \
+  ((void)chRWLockReadLockTimeout(rwp, TIME_INFINITE))
+
+/**
+ * @brief   Acquires the lock in exclusive mode.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @api
+ */
+#define chRWLockWriteLock(rwp)                                              \
+  ((void)chRWLockWriteLockTimeout(rwp, TIME_INFINITE))
+
+/**
+ * @brief   Returns the number of readers holding the lock.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @iclass
+ */
+#define chRWLockGetReadersI(rwp) ((rwp)->rw_readers)
+
+/**
+ * @brief   Returns the writer owning the lock.
+ * @note    A writer owning the lock while readers still hold it is waiting
+ *          for the readers to release it.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @return              The writer thread pointer or @p NULL.
+ *
+ * @iclass
+ */
+#define chRWLockGetWriterI(rwp) ((rwp)->rw_mtx.m_owner)
+/** @} */
+
+#endif /* CH_USE_RWLOCKS */
+
+#endif /* _CHRWLOCK_H_ */
+
+/** @} */
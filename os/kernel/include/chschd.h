@@ -78,6 +78,42 @@
 #define TIME_INFINITE   ((systime_t)-1)
 /** @} */
 
+/**
+ * @brief   Bitmap indexed ready list.
+ * @details If enabled the ready list keeps, beside the priority ordered
+ *          threads queue, a bitmap of the occupied priority levels and a
+ *          pointer to the last thread of each level. Threads insertion
+ *          becomes a constant time operation regardless of the number of
+ *          ready threads.
+ * @note    The default is @p FALSE.
+ * @note    The option is only settable from @p chconf.h, ports have no
+ *          way to enable it by default.
+ */
+#if !defined(CH_USE_READYLIST_BITMAP) || defined(__DOXYGEN__)
+#define CH_USE_READYLIST_BITMAP         FALSE
+#endif
+
+/**
+ * @brief   Earliest deadline first scheduling class.
+ * @details If enabled the threads can enter the EDF scheduling class, the
+ *          EDF threads share a reserved priority level and are ordered by
+ *          absolute deadline within that level.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_EDF) || defined(__DOXYGEN__)
+#define CH_USE_EDF                      FALSE
+#endif
+
+/**
+ * @brief   Priority level reserved to the EDF threads.
+ * @details Threads with higher priority preempt the EDF threads, threads
+ *          with lower priority run when no EDF thread is ready.
+ * @note    The default is one level below the timer service thread.
+ */
+#if !defined(CH_EDF_PRIORITY) || defined(__DOXYGEN__)
+#define CH_EDF_PRIORITY                 (HIGHPRIO - 2)
+#endif
+
 /**
  * @brief   Returns the priority of the first thread on the given ready list.
  *
@@ -85,6 +121,91 @@
  */
 #define firstprio(rlp)  ((rlp)->p_next->p_prio)
 
+#if CH_USE_EDF || defined(__DOXYGEN__)
+/**
+ * @brief   EDF threads priority.
+ */
+#define EDFPRIO         CH_EDF_PRIORITY
+
+/**
+ * @brief   Returns @p TRUE if the thread @p tp has an earlier deadline than
+ *          the thread @p cp.
+ * @details Both threads are assumed to be at the @p EDFPRIO level. Threads
+ *          at that level not belonging to the EDF class, for example threads
+ *          boosted by the priority inheritance, are considered to have the
+ *          earliest deadline.
+ *
+ * @notapi
+ */
+#define edf_earlier(tp, cp)                                                 \
+  (((cp)->p_edf.ed_period != 0) &&                                          \
+   (((tp)->p_edf.ed_period == 0) ||                                         \
+    ((systime_t)((cp)->p_edf.ed_deadline - (tp)->p_edf.ed_deadline - 1) <   \
+     (systime_t)-1 / 2)))
+
+/**
+ * @brief   Returns @p TRUE if the thread @p ntp must run before the thread
+ *          @p otp.
+ *
+ * @notapi
+ */
+#define sch_precedes(ntp, otp)                                              \
+  (((ntp)->p_prio > (otp)->p_prio) ||                                       \
+   (((ntp)->p_prio == EDFPRIO) && ((otp)->p_prio == EDFPRIO) &&             \
+    edf_earlier(ntp, otp)))
+#endif /* CH_USE_EDF */
+
+#if CH_USE_READYLIST_BITMAP || defined(__DOXYGEN__)
+/**
+ * @brief   Number of priority levels indexed by the ready list bitmap.
+ */
+#define RL_LEVELS       (HIGHPRIO + 1)
+
+/**
+ * @brief   Number of 32 bits words composing the ready list bitmap.
+ */
+#define RL_WORDS        ((RL_LEVELS + 31) / 32)
+
+/* The bitmap ready list replaces the default scheduler functions through the
+   standard port capture mechanism.*/
+#define PORT_OPTIMIZED_READYLIST_STRUCT
+#define PORT_OPTIMIZED_READYI
+#define PORT_OPTIMIZED_REMOVEI
+#define PORT_OPTIMIZED_GOSLEEPS
+#define PORT_OPTIMIZED_DORESCHEDULEBEHIND
+#define PORT_OPTIMIZED_DORESCHEDULEAHEAD
+
+/**
+ * @extends ThreadsQueue
+ *
+ * @brief   Bitmap indexed ready list header.
+ * @details The threads queue is still kept ordered by priority so the
+ *          first thread is always the one with the highest priority, the
+ *          bitmap and the levels tails allow to find the insertion point
+ *          of a thread without scanning the queue.
+ */
+typedef struct {
+  ThreadsQueue          r_queue;    /**< @brief Threads queue.              */
+  tprio_t               r_prio;     /**< @brief This field must be
+                                                initialized to zero.        */
+  struct context        r_ctx;      /**< @brief Not used, present because
+                                                offsets.                    */
+#if CH_USE_REGISTRY || defined(__DOXYGEN__)
+  Thread                *r_newer;   /**< @brief Newer registry element.     */
+  Thread                *r_older;   /**< @brief Older registry element.     */
+#endif
+  /* End of the fields shared with the Thread structure.*/
+  Thread                *r_current; /**< @brief The currently running
+                                                thread.                     */
+  uint32_t              r_summary;  /**< @brief Non-empty bitmap words
+                                                mask.                       */
+  uint32_t              r_bitmap[RL_WORDS]; /**< @brief Occupied priority
+                                                levels.                     */
+  Thread                *r_tail[RL_LEVELS]; /**< @brief Last thread of each
+                                                occupied priority level.    */
+} ReadyList;
+#endif /* CH_USE_READYLIST_BITMAP */
+
 /**
  * @extends ThreadsQueue
  *
@@ -111,6 +232,37 @@ typedef struct {
 extern ReadyList rlist;
 #endif /* !defined(PORT_OPTIMIZED_RLIST_EXT) */
 
+/**
+ * @brief   Adaptive wait mode.
+ * @details If enabled the semaphores and mutexes can be configured to yield
+ *          or spin for a bounded number of iterations before putting the
+ *          waiting thread to sleep.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_ADAPTIVE_WAIT) || defined(__DOXYGEN__)
+#define CH_USE_ADAPTIVE_WAIT            FALSE
+#endif
+
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+/**
+ * @brief   Adaptive wait settings and counters of a synchronization object.
+ */
+typedef struct {
+  cnt_t                 aw_limit;   /**< @brief Maximum number of iterations
+                                                before sleeping, zero
+                                                disables the adaptive wait. */
+  uint32_t              aw_hits;    /**< @brief Adaptive waits satisfied
+                                                without sleeping.           */
+  uint32_t              aw_misses;  /**< @brief Adaptive waits ended
+                                                sleeping.                   */
+} AdaptiveWait;
+
+/**
+ * @brief   Data part of a static adaptive wait initializer.
+ */
+#define _ADAPTIVEWAIT_DATA {0, 0, 0}
+#endif /* CH_USE_ADAPTIVE_WAIT */
+
 /**
  * @brief   Current thread pointer access macro.
  * @note    This macro is not meant to be used in the application code but
@@ -140,10 +292,13 @@ extern ReadyList rlist;
 extern "C" {
 #endif
   void _scheduler_init(void);
-#if !defined(PORT_OPTIMIZED_READYI)
+#if !defined(PORT_OPTIMIZED_READYI) || CH_USE_READYLIST_BITMAP
   Thread *chSchReadyI(Thread *tp);
 #endif
-#if !defined(PORT_OPTIMIZED_GOSLEEPS)
+#if !defined(PORT_OPTIMIZED_REMOVEI) || CH_USE_READYLIST_BITMAP
+  Thread *chSchRemoveI(Thread *tp);
+#endif
+#if !defined(PORT_OPTIMIZED_GOSLEEPS) || CH_USE_READYLIST_BITMAP
   void chSchGoSleepS(tstate_t newstate);
 #endif
 #if !defined(PORT_OPTIMIZED_GOSLEEPTIMEOUTS)
@@ -158,15 +313,20 @@ extern "C" {
 #if !defined(PORT_OPTIMIZED_ISPREEMPTIONREQUIRED)
   bool_t chSchIsPreemptionRequired(void);
 #endif
-#if !defined(PORT_OPTIMIZED_DORESCHEDULEBEHIND) || defined(__DOXYGEN__)
+#if !defined(PORT_OPTIMIZED_DORESCHEDULEBEHIND) ||                         \
+    CH_USE_READYLIST_BITMAP || defined(__DOXYGEN__)
   void chSchDoRescheduleBehind(void);
 #endif
-#if !defined(PORT_OPTIMIZED_DORESCHEDULEAHEAD) || defined(__DOXYGEN__)
+#if !defined(PORT_OPTIMIZED_DORESCHEDULEAHEAD) ||                          \
+    CH_USE_READYLIST_BITMAP || defined(__DOXYGEN__)
   void chSchDoRescheduleAhead(void);
 #endif
 #if !defined(PORT_OPTIMIZED_DORESCHEDULE)
   void chSchDoReschedule(void);
 #endif
+#if CH_USE_ADAPTIVE_WAIT
+  bool_t chSchAdaptiveStepS(bool_t spin);
+#endif
 #ifdef __cplusplus
 }
 #endif
@@ -183,7 +343,11 @@ extern "C" {
  * @iclass
  */
 #if !defined(PORT_OPTIMIZED_ISRESCHREQUIREDI) || defined(__DOXYGEN__)
+#if !CH_USE_EDF || defined(__DOXYGEN__)
 #define chSchIsRescRequiredI() (firstprio(&rlist.r_queue) > currp->p_prio)
+#else
+#define chSchIsRescRequiredI() sch_precedes(rlist.r_queue.p_next, currp)
+#endif
 #endif /* !defined(PORT_OPTIMIZED_ISRESCHREQUIREDI) */
 
 /**
@@ -194,7 +358,11 @@ extern "C" {
  * @sclass
  */
 #if !defined(PORT_OPTIMIZED_CANYIELDS) || defined(__DOXYGEN__)
+#if !CH_USE_EDF || defined(__DOXYGEN__)
 #define chSchCanYieldS() (firstprio(&rlist.r_queue) >= currp->p_prio)
+#else
+#define chSchCanYieldS() (!sch_precedes(currp, rlist.r_queue.p_next))
+#endif
 #endif /* !defined(PORT_OPTIMIZED_CANYIELDS) */
 
 /**
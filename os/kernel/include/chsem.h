@@ -45,6 +45,10 @@ typedef struct Semaphore {
   ThreadsQueue          s_queue;    /**< @brief Queue of the threads sleeping
                                                 on this semaphore.          */
   cnt_t                 s_cnt;      /**< @brief The semaphore counter.      */
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+  AdaptiveWait          s_aw;       /**< @brief Adaptive wait settings and
+                                                counters.                   */
+#endif
 } Semaphore;
 
 #ifdef __cplusplus
@@ -76,7 +80,12 @@ extern "C" {
  * @param[in] n         the counter initial value, this value must be
  *                      non-negative
  */
+#if !CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
 #define _SEMAPHORE_DATA(name, n) {_THREADSQUEUE_DATA(name.s_queue), n}
+#else
+#define _SEMAPHORE_DATA(name, n)                                            \
+  {_THREADSQUEUE_DATA(name.s_queue), n, _ADAPTIVEWAIT_DATA}
+#endif
 
 /**
  * @brief   Static semaphore initializer.
@@ -116,6 +125,37 @@ extern "C" {
  * @iclass
  */
 #define chSemGetCounterI(sp)    ((sp)->s_cnt)
+
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+/**
+ * @brief   Sets the adaptive wait iterations limit.
+ * @details A thread waiting on a semaphore with a zero counter yields to the
+ *          other ready threads, or spins if there are none, for at most
+ *          @p n iterations before sleeping.
+ * @pre     This function is only available when the
+ *          @p CH_USE_ADAPTIVE_WAIT configuration option is enabled.
+ *
+ * @param[in] sp        pointer to a @p Semaphore structure
+ * @param[in] n         the iterations limit, zero disables the adaptive wait
+ *
+ * @api
+ */
+#define chSemSetAdaptive(sp, n) ((sp)->s_aw.aw_limit = (n))
+
+/**
+ * @brief   Returns the number of adaptive waits satisfied without sleeping.
+ *
+ * @api
+ */
+#define chSemGetAdaptiveHits(sp) ((sp)->s_aw.aw_hits)
+
+/**
+ * @brief   Returns the number of adaptive waits ended sleeping.
+ *
+ * @api
+ */
+#define chSemGetAdaptiveMisses(sp) ((sp)->s_aw.aw_misses)
+#endif /* CH_USE_ADAPTIVE_WAIT */
 /** @} */
 
 #endif /* CH_USE_SEMAPHORES */
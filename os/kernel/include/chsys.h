@@ -87,6 +87,7 @@
  */
 #define chSysSwitch(ntp, otp) {                                             \
   dbg_trace(otp);                                                           \
+  dbg_acc_switch(otp);                                                      \
   THREAD_CONTEXT_SWITCH_HOOK(ntp, otp);                                     \
   port_switch(ntp, otp);                                                    \
 }
@@ -202,7 +203,9 @@
  */
 #define CH_IRQ_PROLOGUE()                                                   \
   PORT_IRQ_PROLOGUE();                                                      \
-  dbg_check_enter_isr();
+  dbg_check_enter_isr();                                                    \
+  dbg_trace_isr_enter();                                                    \
+  dbg_acc_isr_enter();
 
 /**
  * @brief   IRQ handler exit code.
@@ -213,6 +216,8 @@
  * @special
  */
 #define CH_IRQ_EPILOGUE()                                                   \
+  dbg_acc_isr_leave();                                                      \
+  dbg_trace_isr_leave();                                                    \
   dbg_check_leave_isr();                                                    \
   PORT_IRQ_EPILOGUE();
 
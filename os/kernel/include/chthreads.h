@@ -58,6 +58,10 @@
 #define THD_STATE_WTMSG         12  /**< @brief Waiting for a message.      */
 #define THD_STATE_WTQUEUE       13  /**< @brief Waiting on an I/O queue.    */
 #define THD_STATE_FINAL         14  /**< @brief Thread terminated.          */
+#define THD_STATE_WTRDLOCK      15  /**< @brief Waiting on a readers-writer
+                                         lock as reader.                    */
+#define THD_STATE_WTWRLOCK      16  /**< @brief Waiting on a readers-writer
+                                         lock as writer.                    */
 
 /**
  * @brief   Thread states as array of strings.
@@ -67,7 +71,7 @@
 #define THD_STATE_NAMES                                                     \
   "READY", "CURRENT", "SUSPENDED", "WTSEM", "WTMTX", "WTCOND", "SLEEPING",  \
   "WTEXIT", "WTOREVT", "WTANDEVT", "SNDMSGQ", "SNDMSG", "WTMSG", "WTQUEUE", \
-  "FINAL"
+  "FINAL", "WTRDLOCK", "WTWRLOCK"
 /** @} */
 
 /**
@@ -141,6 +145,24 @@ struct Thread {
    * @note  This field can overflow.
    */
   volatile systime_t    p_time;
+#endif
+#if CH_DBG_THREADS_ACCOUNTING || defined(__DOXYGEN__)
+  /**
+   * @brief Thread consumed time in realtime counter cycles.
+   */
+  uint64_t              p_runtime;
+  /**
+   * @brief Thread consumed time at the current load window start.
+   */
+  uint64_t              p_runmark;
+  /**
+   * @brief Thread load in the last window, in hundredths of percent.
+   */
+  uint16_t              p_load;
+  /**
+   * @brief Serial number of the window started by @p p_runmark.
+   */
+  uint32_t              p_window;
 #endif
   /**
    * @brief State-specific fields.
@@ -217,6 +239,25 @@ struct Thread {
    */
   void                  *p_mpool;
 #endif
+#if CH_USE_EDF || defined(__DOXYGEN__)
+  /**
+   * @brief EDF scheduling class state.
+   */
+  EdfState              p_edf;
+#endif
+#if (CH_USE_HEAP && CH_USE_HEAP_CACHE) || defined(__DOXYGEN__)
+  /**
+   * @brief Heap cache attached to the thread or @p NULL.
+   */
+  HeapCache             *p_hcache;
+#endif
+#if CH_DBG_FILL_THREADS || defined(__DOXYGEN__)
+  /**
+   * @brief End of the working area or @p NULL if the stack has not been
+   *        filled.
+   */
+  uint8_t               *p_wend;
+#endif
 #if defined(THREAD_EXT_FIELDS)
   /* Extra fields defined in chconf.h.*/
   THREAD_EXT_FIELDS
@@ -362,6 +403,8 @@ extern "C" {
   Thread *_thread_init(Thread *tp, tprio_t prio);
 #if CH_DBG_FILL_THREADS
   void _thread_memfill(uint8_t *startp, uint8_t *endp, uint8_t v);
+  size_t chThdGetStackSize(Thread *tp);
+  size_t chThdGetStackUnused(Thread *tp);
 #endif
   Thread *chThdCreateI(void *wsp, size_t size,
                        tprio_t prio, tfunc_t pf, void *arg);
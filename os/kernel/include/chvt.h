@@ -36,6 +36,111 @@
 #ifndef _CHVT_H_
 #define _CHVT_H_
 
+/**
+ * @brief   Tick-less mode time delta.
+ * @details If this value is zero then the system uses the classic periodic
+ *          tick. A non-zero value configures the system in tick-less mode,
+ *          the system time is read from a free running counter and the
+ *          virtual timers are served by a one-shot alarm programmed on the
+ *          nearest deadline. The value represents the minimum number of
+ *          ticks that is safe to specify in a timeout directive.
+ * @note    The tick-less mode only builds with @p CH_TIME_QUANTUM set to
+ *          zero and @p CH_DBG_THREADS_PROFILING set to @p FALSE, the
+ *          latter defaults to @p TRUE in the configuration templates.
+ * @note    The default is zero.
+ */
+#if !defined(CH_TIMEDELTA) || defined(__DOXYGEN__)
+#define CH_TIMEDELTA                    0
+#endif
+
+#if (CH_TIMEDELTA > 0) && !PORT_SUPPORTS_TICKLESS
+#error "tick-less mode not supported by this port"
+#endif
+
+#if (CH_TIMEDELTA > 0) && (CH_TIME_QUANTUM > 0)
+#error "CH_TIME_QUANTUM not supported in tick-less mode"
+#endif
+
+#if (CH_TIMEDELTA > 0) && CH_DBG_THREADS_PROFILING
+#error "CH_DBG_THREADS_PROFILING not supported in tick-less mode"
+#endif
+
+/**
+ * @brief   Hierarchical timing wheel.
+ * @details If enabled the virtual timers are kept in a hierarchical timing
+ *          wheel instead of a delta list, the set and reset operations
+ *          become constant time operations at the cost of some extra RAM
+ *          and of a cascade operation in the tick handler every
+ *          @p VT_WHEEL_SLOTS ticks.
+ * @note    The default is @p FALSE.
+ * @note    Not compatible with the tick-less mode.
+ */
+#if !defined(CH_USE_VT_WHEEL) || defined(__DOXYGEN__)
+#define CH_USE_VT_WHEEL                 FALSE
+#endif
+
+/**
+ * @brief   Number of bits of the system time decoded by each wheel level.
+ * @details Each wheel level has <tt>2^CH_VT_WHEEL_BITS</tt> slots.
+ * @note    The default is 6, 64 slots per level.
+ */
+#if !defined(CH_VT_WHEEL_BITS) || defined(__DOXYGEN__)
+#define CH_VT_WHEEL_BITS                6
+#endif
+
+#if CH_USE_VT_WHEEL && (CH_TIMEDELTA > 0)
+#error "CH_USE_VT_WHEEL not supported in tick-less mode"
+#endif
+
+#if CH_USE_VT_WHEEL && ((CH_VT_WHEEL_BITS < 1) || (CH_VT_WHEEL_BITS > 8))
+#error "CH_VT_WHEEL_BITS must be within 1 and 8"
+#endif
+
+/**
+ * @brief   Deferred virtual timers callbacks.
+ * @details If enabled the tick handler does not invoke the callbacks of the
+ *          expired timers, the timers are moved into a pending list and a
+ *          timer service thread invokes the callbacks, the tick interrupt
+ *          duration no more depends on the number of expired timers.
+ * @note    The default is @p FALSE.
+ * @note    Not compatible with the tick-less mode.
+ */
+#if !defined(CH_USE_VT_DEFERRED) || defined(__DOXYGEN__)
+#define CH_USE_VT_DEFERRED              FALSE
+#endif
+
+/**
+ * @brief   Timer service thread priority.
+ */
+#if !defined(CH_VT_SERVICE_PRIORITY) || defined(__DOXYGEN__)
+#define CH_VT_SERVICE_PRIORITY          (HIGHPRIO - 1)
+#endif
+
+/**
+ * @brief   Maximum number of callbacks invoked for each system tick.
+ * @details The timer service thread invokes at most this number of
+ *          callbacks then waits for the next tick, the remaining callbacks
+ *          are delayed.
+ */
+#if !defined(CH_VT_SERVICE_BUDGET) || defined(__DOXYGEN__)
+#define CH_VT_SERVICE_BUDGET            16
+#endif
+
+/**
+ * @brief   Timer service thread stack size.
+ */
+#if !defined(CH_VT_SERVICE_STACK_SIZE) || defined(__DOXYGEN__)
+#define CH_VT_SERVICE_STACK_SIZE        128
+#endif
+
+#if CH_USE_VT_DEFERRED && (CH_TIMEDELTA > 0)
+#error "CH_USE_VT_DEFERRED not supported in tick-less mode"
+#endif
+
+#if CH_USE_VT_DEFERRED && (CH_VT_SERVICE_BUDGET < 1)
+#error "CH_VT_SERVICE_BUDGET must be greater than zero"
+#endif
+
 /**
  * @name    Time conversion utilities
  * @{
@@ -82,6 +187,25 @@
                 1000000UL) + 1UL))
 /** @} */
 
+#if CH_USE_VT_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Number of slots in each wheel level.
+ */
+#define VT_WHEEL_SLOTS                  (1U << CH_VT_WHEEL_BITS)
+
+/**
+ * @brief   Mask of the slot index in a wheel level.
+ */
+#define VT_WHEEL_MASK                   (VT_WHEEL_SLOTS - 1U)
+
+/**
+ * @brief   Number of wheel levels.
+ * @details The levels cover the whole @p systime_t range.
+ */
+#define VT_WHEEL_LEVELS                                                     \
+  ((sizeof (systime_t) * 8U + CH_VT_WHEEL_BITS - 1U) / CH_VT_WHEEL_BITS)
+#endif /* CH_USE_VT_WHEEL */
+
 /**
  * @brief   Virtual Timer callback function.
  */
@@ -102,7 +226,9 @@ struct VirtualTimer {
                                                 list.                       */
   VirtualTimer          *vt_prev;   /**< @brief Previous timer in the delta
                                                 list.                       */
-  systime_t             vt_time;    /**< @brief Time delta before timeout.  */
+  systime_t             vt_time;    /**< @brief Time delta before timeout,
+                                                absolute deadline when the
+                                                timing wheel is in use.     */
   vtfunc_t              vt_func;    /**< @brief Timer callback function
                                                 pointer.                    */
   void                  *vt_par;    /**< @brief Timer callback function
@@ -115,19 +241,73 @@ struct VirtualTimer {
  *          in order to make the unlink time constant, the reset of a virtual
  *          timer is often used in the code.
  */
+#if !CH_USE_VT_WHEEL || defined(__DOXYGEN__)
 typedef struct {
   VirtualTimer          *vt_next;   /**< @brief Next timer in the delta
                                                 list.                       */
   VirtualTimer          *vt_prev;   /**< @brief Last timer in the delta
                                                 list.                       */
   systime_t             vt_time;    /**< @brief Must be initialized to -1.  */
+#if (CH_TIMEDELTA == 0) || defined(__DOXYGEN__)
   volatile systime_t    vt_systime; /**< @brief System Time counter.        */
+#endif
+#if (CH_TIMEDELTA > 0) || defined(__DOXYGEN__)
+  /**
+   * @brief System time of the last processed deadline, the delta of the
+   *        first timer in the list is relative to this time.
+   */
+  systime_t             vt_lasttime;
+#endif
+#if CH_USE_VT_DEFERRED || defined(__DOXYGEN__)
+  /**
+   * @brief Expired timers waiting for the timer service thread.
+   * @note  A whole @p VirtualTimer is used as list header so that the
+   *        pending timers can be reset like timers in the delta list.
+   */
+  VirtualTimer          vt_pending;
+#endif
+} VTList;
+#endif /* !CH_USE_VT_WHEEL */
+
+#if CH_USE_VT_WHEEL || defined(__DOXYGEN__)
+/**
+ * @brief   Timing wheel slot.
+ * @details Each slot is the header of a double link circular list of
+ *          timers, the order of the timers within a slot is not relevant.
+ */
+typedef struct {
+  VirtualTimer          *vt_next;   /**< @brief First timer in the slot.    */
+  VirtualTimer          *vt_prev;   /**< @brief Last timer in the slot.     */
+} VTSlot;
+
+/**
+ * @brief   Virtual timers timing wheel header.
+ * @details Timers are placed in the level whose range contains their
+ *          remaining time, the slot is selected by the bits of the
+ *          absolute deadline decoded by that level. Timers in upper levels
+ *          are cascaded toward the lower levels when the lower levels wrap.
+ */
+typedef struct {
+  volatile systime_t    vt_systime; /**< @brief System Time counter.        */
+  /**
+   * @brief Timing wheel levels.
+   */
+  VTSlot                vt_wheel[VT_WHEEL_LEVELS][VT_WHEEL_SLOTS];
+#if CH_USE_VT_DEFERRED || defined(__DOXYGEN__)
+  /**
+   * @brief Expired timers waiting for the timer service thread.
+   */
+  VTSlot                vt_pending;
+#endif
 } VTList;
+#endif /* CH_USE_VT_WHEEL */
 
 /**
  * @name    Macro Functions
  * @{
  */
+#if ((CH_TIMEDELTA == 0) && !CH_USE_VT_WHEEL && !CH_USE_VT_DEFERRED) ||      \
+    defined(__DOXYGEN__)
 /**
  * @brief   Virtual timers ticker.
  * @note    The system lock is released before entering the callback and
@@ -148,12 +328,14 @@ typedef struct {
       vtp->vt_func = (vtfunc_t)NULL;                                        \
       vtp->vt_next->vt_prev = (void *)&vtlist;                              \
       (&vtlist)->vt_next = vtp->vt_next;                                    \
+      dbg_trace_event(CH_TRACE_TYPE_VT_FIRE, NULL, vtp);                    \
       chSysUnlockFromIsr();                                                 \
       fn(vtp->vt_par);                                                      \
       chSysLockFromIsr();                                                   \
     }                                                                       \
   }                                                                         \
 }
+#endif /* (CH_TIMEDELTA == 0) && !CH_USE_VT_WHEEL && !CH_USE_VT_DEFERRED */
 
 /**
  * @brief   Returns @p TRUE if the specified timer is armed.
@@ -213,7 +395,11 @@ typedef struct {
  *
  * @api
  */
+#if (CH_TIMEDELTA == 0) || defined(__DOXYGEN__)
 #define chTimeNow() (vtlist.vt_systime)
+#else
+#define chTimeNow() port_timer_get_time()
+#endif
 /** @} */
 
 extern VTList vtlist;
@@ -227,6 +413,10 @@ extern "C" {
   void _vt_init(void);
   void chVTSetI(VirtualTimer *vtp, systime_t time, vtfunc_t vtfunc, void *par);
   void chVTResetI(VirtualTimer *vtp);
+  bool_t chVTGetNextDeltaI(systime_t *dp);
+#if (CH_TIMEDELTA > 0) || CH_USE_VT_WHEEL || CH_USE_VT_DEFERRED
+  void chVTDoTickI(void);
+#endif
   bool_t chTimeIsWithin(systime_t start, systime_t end);
 #ifdef __cplusplus
 }
@@ -0,0 +1,217 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    chworkq.h
+ * @brief   Work queues macros and structures.
+ *
+ * @addtogroup workqueues
+ * @{
+ */
+
+#ifndef _CHWORKQ_H_
+#define _CHWORKQ_H_
+
+/**
+ * @brief   Work queues APIs.
+ * @details If enabled then the work queues APIs are included in the kernel.
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_WORKQUEUES) || defined(__DOXYGEN__)
+#define CH_USE_WORKQUEUES               FALSE
+#endif
+
+#if CH_USE_WORKQUEUES || defined(__DOXYGEN__)
+
+/**
+ * @brief   Work queues latency timestamp.
+ * @details The latency is measured using the port realtime counter, if
+ *          supported, else using the system time.
+ */
+#if !defined(CH_WQ_TIMESTAMP) || defined(__DOXYGEN__)
+#if PORT_SUPPORTS_RT || defined(__DOXYGEN__)
+#define CH_WQ_TIMESTAMP()           port_rt_get_counter_value()
+#else
+#define CH_WQ_TIMESTAMP()           ((uint32_t)chTimeNow())
+#endif
+#endif
+
+/**
+ * @brief   Work queues latency timestamp frequency.
+ */
+#if !defined(CH_WQ_FREQUENCY) || defined(__DOXYGEN__)
+#if PORT_SUPPORTS_RT || defined(__DOXYGEN__)
+#define CH_WQ_FREQUENCY()           port_rt_get_counter_frequency()
+#else
+#define CH_WQ_FREQUENCY()           ((uint32_t)CH_FREQUENCY)
+#endif
+#endif
+
+/**
+ * @brief   Work function type.
+ */
+typedef void (*wqfunc_t)(void *arg);
+
+/**
+ * @brief   Type of a work queue.
+ */
+typedef struct WorkQueue WorkQueue;
+
+/**
+ * @brief   Work item structure.
+ * @details Work items are allocated by the caller, usually statically, an
+ *          item can be pending on a single queue at time.
+ */
+typedef struct WorkItem {
+  struct WorkItem       *wi_next;   /**< @brief Next pending item.          */
+  WorkQueue             *wi_queue;  /**< @brief Queue the item is pending
+                                                on or @p NULL.              */
+  wqfunc_t              wi_func;    /**< @brief Work function.              */
+  void                  *wi_arg;    /**< @brief Work function argument.     */
+  uint32_t              wi_stamp;   /**< @brief Enqueue timestamp.          */
+} WorkItem;
+
+/**
+ * @brief   Work queue statistics.
+ * @note    The latencies are measured between the enqueue operation and the
+ *          start of the work function, in @p CH_WQ_FREQUENCY() units.
+ */
+typedef struct {
+  uint32_t              ws_executed;/**< @brief Executed items.             */
+  uint32_t              ws_dups;    /**< @brief Enqueue operations on
+                                                items already pending on
+                                                this queue.                 */
+  uint32_t              ws_batches; /**< @brief Worker activations with at
+                                                least an executed item.     */
+  uint32_t              ws_maxbatch;/**< @brief Largest number of items
+                                                executed in an activation.  */
+  uint32_t              ws_minlat;  /**< @brief Minimum latency.            */
+  uint32_t              ws_maxlat;  /**< @brief Maximum latency.            */
+  uint64_t              ws_sumlat;  /**< @brief Sum of the latencies.       */
+} WorkQueueStats;
+
+/**
+ * @brief   Work queue structure.
+ */
+struct WorkQueue {
+  WorkItem              *wq_head;   /**< @brief First pending item.         */
+  WorkItem              *wq_tail;   /**< @brief Last pending item.          */
+  Thread                *wq_worker; /**< @brief Worker thread or @p NULL.   */
+  Thread                *wq_waiting;/**< @brief Worker thread while
+                                                waiting or @p NULL.         */
+  const char            *wq_name;   /**< @brief Worker thread name.         */
+  bool_t                wq_stopped; /**< @brief Stop requested, enqueue
+                                                operations are rejected.    */
+  WorkQueueStats        wq_stats;   /**< @brief Statistics.                 */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void chWQInit(WorkQueue *wqp);
+  Thread *chWQStart(WorkQueue *wqp, void *wsp, size_t size, tprio_t prio,
+                    const char *name);
+  void chWQStop(WorkQueue *wqp);
+  void chWIInit(WorkItem *wip, wqfunc_t func, void *arg);
+  bool_t chWQEnqueue(WorkQueue *wqp, WorkItem *wip);
+  bool_t chWQEnqueueI(WorkQueue *wqp, WorkItem *wip);
+  void chWQResetStatsI(WorkQueue *wqp);
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @brief   Data part of a static work queue initializer.
+ * @details This macro should be used when statically initializing a
+ *          work queue that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the work queue variable
+ */
+#define _WORKQUEUE_DATA(name)                                               \
+  {NULL, NULL, NULL, NULL, NULL, FALSE, {0, 0, 0, 0, (uint32_t)-1, 0, 0}}
+
+/**
+ * @brief   Static work queue initializer.
+ * @details Statically initialized work queues require no explicit
+ *          initialization using @p chWQInit().
+ *
+ * @param[in] name      the name of the work queue variable
+ */
+#define WORKQUEUE_DECL(name) WorkQueue name = _WORKQUEUE_DATA(name)
+
+/**
+ * @brief   Data part of a static work item initializer.
+ * @details This macro should be used when statically initializing a
+ *          work item that is part of a bigger structure.
+ *
+ * @param[in] name      the name of the work item variable
+ * @param[in] func      the work function
+ * @param[in] arg       the work function argument
+ */
+#define _WORKITEM_DATA(name, func, arg) {NULL, NULL, func, arg, 0}
+
+/**
+ * @brief   Static work item initializer.
+ * @details Statically initialized work items require no explicit
+ *          initialization using @p chWIInit().
+ *
+ * @param[in] name      the name of the work item variable
+ * @param[in] func      the work function
+ * @param[in] arg       the work function argument
+ */
+#define WORKITEM_DECL(name, func, arg)                                      \
+  WorkItem name = _WORKITEM_DATA(name, func, arg)
+
+/**
+ * @name    Macro Functions
+ * @{
+ */
+/**
+ * @brief   Returns @p TRUE if the work item is pending on a queue.
+ *
+ * @param[in] wip       pointer to the @p WorkItem structure
+ *
+ * @iclass
+ */
+#define chWIIsPendingI(wip) ((bool_t)((wip)->wi_queue != NULL))
+
+/**
+ * @brief   Returns a pointer to the statistics of a work queue.
+ * @note    The statistics should be read with the kernel locked.
+ *
+ * @param[in] wqp       pointer to the @p WorkQueue structure
+ *
+ * @iclass
+ */
+#define chWQGetStatsI(wqp) (&(wqp)->wq_stats)
+/** @} */
+
+#endif /* CH_USE_WORKQUEUES */
+
+#endif /* _CHWORKQ_H_ */
+
+/** @} */
@@ -46,6 +46,7 @@
  *            - SV#11, misplaced S-class function.
  *            .
  *          - Trace buffer.
+ *          - Threads accounting.
  *          - Parameters check.
  *          - Kernel assertions.
  *          - Kernel panics.
@@ -222,6 +223,45 @@ void chDbgCheckClassS(void) {
  */
 ch_trace_buffer_t dbg_trace_buffer;
 
+/**
+ * @brief   Compiler barrier between the trace buffer accesses.
+ * @note    The writer and the reader run on the same core so a compiler
+ *          barrier is sufficient.
+ */
+#if defined(__GNUC__) || defined(__DOXYGEN__)
+#define trace_barrier() asm volatile ("" : : : "memory")
+#else
+#define trace_barrier()
+#endif
+
+/**
+ * @brief   Writes a record in the trace buffer.
+ * @note    Must be invoked from within the kernel critical zone, this
+ *          makes the writer unique and no other lock is required.
+ *
+ * @param[in] type      the event type
+ * @param[in] tp        the thread involved or @p NULL
+ * @param[in] obj       the object involved or @p NULL
+ * @param[in] state     the thread state
+ * @param[in] prio      the thread priority
+ */
+static void trace_write(uint8_t type, Thread *tp, void *obj,
+                        uint8_t state, uint8_t prio) {
+  unsigned head = dbg_trace_buffer.tb_head;
+  ch_trace_event_t *tep =
+      &dbg_trace_buffer.tb_buffer[head & (CH_TRACE_BUFFER_SIZE - 1)];
+
+  tep->te_time  = CH_TRACE_TIMESTAMP();
+  tep->te_tp    = tp;
+  tep->te_obj   = obj;
+  tep->te_type  = type;
+  tep->te_state = state;
+  tep->te_prio  = prio;
+  /* The record must be complete before it is published to the reader.*/
+  trace_barrier();
+  dbg_trace_buffer.tb_head = head + 1;
+}
+
 /**
  * @brief   Trace circular buffer subsystem initialization.
  * @note    Internal use only.
@@ -229,7 +269,9 @@ ch_trace_buffer_t dbg_trace_buffer;
 void _trace_init(void) {
 
   dbg_trace_buffer.tb_size = CH_TRACE_BUFFER_SIZE;
-  dbg_trace_buffer.tb_ptr = &dbg_trace_buffer.tb_buffer[0];
+  dbg_trace_buffer.tb_head = 0;
+  dbg_trace_buffer.tb_tail = 0;
+  dbg_trace_buffer.tb_last = 0;
 }
 
 /**
@@ -241,16 +283,364 @@ void _trace_init(void) {
  */
 void dbg_trace(Thread *otp) {
 
-  dbg_trace_buffer.tb_ptr->se_time   = chTimeNow();
-  dbg_trace_buffer.tb_ptr->se_tp     = currp;
-  dbg_trace_buffer.tb_ptr->se_wtobjp = otp->p_u.wtobjp;
-  dbg_trace_buffer.tb_ptr->se_state  = (uint8_t)otp->p_state;
-  if (++dbg_trace_buffer.tb_ptr >=
-      &dbg_trace_buffer.tb_buffer[CH_TRACE_BUFFER_SIZE])
-    dbg_trace_buffer.tb_ptr = &dbg_trace_buffer.tb_buffer[0];
+  trace_write(CH_TRACE_TYPE_SWITCH, currp, otp,
+              (uint8_t)otp->p_state, (uint8_t)currp->p_prio);
+}
+
+/**
+ * @brief   Inserts in the circular debug trace buffer an event record.
+ *
+ * @param[in] type      the event type
+ * @param[in] tp        the thread involved or @p NULL
+ * @param[in] obj       the object involved or @p NULL
+ *
+ * @notapi
+ */
+void dbg_trace_event(uint8_t type, Thread *tp, void *obj) {
+
+  if (tp != NULL)
+    trace_write(type, tp, obj, (uint8_t)tp->p_state, (uint8_t)tp->p_prio);
+  else
+    trace_write(type, NULL, obj, 0, 0);
+}
+
+/**
+ * @brief   Inserts in the circular debug trace buffer an ISR enter record.
+ *
+ * @notapi
+ */
+void dbg_trace_isr_enter(void) {
+
+  port_lock_from_isr();
+  trace_write(CH_TRACE_TYPE_ISR_ENTER, currp, NULL, 0, 0);
+  port_unlock_from_isr();
+}
+
+/**
+ * @brief   Inserts in the circular debug trace buffer an ISR leave record.
+ *
+ * @notapi
+ */
+void dbg_trace_isr_leave(void) {
+
+  port_lock_from_isr();
+  trace_write(CH_TRACE_TYPE_ISR_LEAVE, currp, NULL, 0, 0);
+  port_unlock_from_isr();
+}
+
+/**
+ * @brief   Writes an unsigned value in the stream using a variable length
+ *          encoding.
+ * @details The value is written in groups of 7 bits starting from the
+ *          least significant, the most significant bit of each byte is set
+ *          if more bytes follow.
+ *
+ * @param[in] chp       pointer to a @p BaseSequentialStream object
+ * @param[in] n         the value to be written
+ */
+static void trace_put_varint(BaseSequentialStream *chp, uintptr_t n) {
+  uint8_t buf[(sizeof (uintptr_t) * 8 + 6) / 7];
+  unsigned i = 0;
+
+  while (n >= 0x80) {
+    buf[i++] = (uint8_t)(n | 0x80);
+    n >>= 7;
+  }
+  buf[i++] = (uint8_t)n;
+  chSequentialStreamWrite(chp, buf, i);
+}
+
+/**
+ * @brief   Starts a trace capture over a stream.
+ * @details The stream header is written followed by the names of the
+ *          threads in the registry, then all the records still in the
+ *          trace buffer become available to @p chDbgTraceDrain().
+ * @note    The stream header is composed by the "CHTR" signature, the
+ *          format version, the pointers size in bytes and the timestamps
+ *          frequency as a 32 bits little endian value.
+ *
+ * @param[in] chp       pointer to a @p BaseSequentialStream object
+ *
+ * @api
+ */
+void chDbgTraceStart(BaseSequentialStream *chp) {
+  uint32_t f = CH_TRACE_FREQUENCY();
+  uint8_t hdr[10];
+#if CH_USE_REGISTRY
+  Thread *tp;
+#endif
+
+  hdr[0] = 'C';
+  hdr[1] = 'H';
+  hdr[2] = 'T';
+  hdr[3] = 'R';
+  hdr[4] = CH_TRACE_STREAM_VERSION;
+  hdr[5] = (uint8_t)sizeof (void *);
+  hdr[6] = (uint8_t)f;
+  hdr[7] = (uint8_t)(f >> 8);
+  hdr[8] = (uint8_t)(f >> 16);
+  hdr[9] = (uint8_t)(f >> 24);
+  chSequentialStreamWrite(chp, hdr, sizeof hdr);
+
+#if CH_USE_REGISTRY
+  tp = chRegFirstThread();
+  do {
+    const char *name = chRegGetThreadName(tp);
+
+    if (name != NULL) {
+      size_t n = 0;
+
+      while ((name[n] != '\0') && (n < 255))
+        n++;
+      chSequentialStreamPut(chp, CH_TRACE_STREAM_NAME);
+      trace_put_varint(chp, (uintptr_t)tp);
+      chSequentialStreamPut(chp, (uint8_t)n);
+      chSequentialStreamWrite(chp, (const uint8_t *)name, n);
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+#endif
+
+  chSysLock();
+  if (dbg_trace_buffer.tb_head > CH_TRACE_BUFFER_SIZE)
+    dbg_trace_buffer.tb_tail = dbg_trace_buffer.tb_head - CH_TRACE_BUFFER_SIZE;
+  else
+    dbg_trace_buffer.tb_tail = 0;
+  chSysUnlock();
+  dbg_trace_buffer.tb_last = 0;
+}
+
+/**
+ * @brief   Writes the new trace records into a stream.
+ * @details The records written after the previous invocation are encoded
+ *          and written into the stream. Each record is composed by the
+ *          event type, the thread state and priority bytes followed by the
+ *          variable length encoded timestamp delta from the previous record,
+ *          thread pointer and object pointer.<br>
+ *          Records overwritten before being read are reported with a lost
+ *          events record.
+ * @note    The kernel is not locked while reading the trace buffer, this
+ *          function can be invoked periodically by a low priority thread.
+ *
+ * @param[in] chp       pointer to a @p BaseSequentialStream object
+ * @return              The number of records written.
+ *
+ * @api
+ */
+unsigned chDbgTraceDrain(BaseSequentialStream *chp) {
+  unsigned head, lost = 0, n = 0;
+
+  head = dbg_trace_buffer.tb_head;
+  while (dbg_trace_buffer.tb_tail != head) {
+    ch_trace_event_t te;
+    uint8_t buf[3];
+
+    /* Records already overwritten are skipped.*/
+    if (head - dbg_trace_buffer.tb_tail > CH_TRACE_BUFFER_SIZE) {
+      lost += head - dbg_trace_buffer.tb_tail - CH_TRACE_BUFFER_SIZE;
+      dbg_trace_buffer.tb_tail = head - CH_TRACE_BUFFER_SIZE;
+    }
+
+    te = dbg_trace_buffer.tb_buffer[dbg_trace_buffer.tb_tail &
+                                    (CH_TRACE_BUFFER_SIZE - 1)];
+    trace_barrier();
+
+    /* If the writer reached the record while it was being copied then the
+       copy could be inconsistent, the record is skipped.*/
+    head = dbg_trace_buffer.tb_head;
+    if (head - dbg_trace_buffer.tb_tail >= CH_TRACE_BUFFER_SIZE) {
+      lost++;
+      dbg_trace_buffer.tb_tail++;
+      continue;
+    }
+
+    if (lost > 0) {
+      chSequentialStreamPut(chp, CH_TRACE_STREAM_LOST);
+      trace_put_varint(chp, lost);
+      lost = 0;
+    }
+    buf[0] = te.te_type;
+    buf[1] = te.te_state;
+    buf[2] = te.te_prio;
+    chSequentialStreamWrite(chp, buf, sizeof buf);
+    trace_put_varint(chp, (uint32_t)(te.te_time - dbg_trace_buffer.tb_last));
+    trace_put_varint(chp, (uintptr_t)te.te_tp);
+    trace_put_varint(chp, (uintptr_t)te.te_obj);
+    dbg_trace_buffer.tb_last = te.te_time;
+    dbg_trace_buffer.tb_tail++;
+    n++;
+  }
+  if (lost > 0) {
+    chSequentialStreamPut(chp, CH_TRACE_STREAM_LOST);
+    trace_put_varint(chp, lost);
+  }
+  return n;
 }
 #endif /* CH_DBG_ENABLE_TRACE */
 
+#if CH_DBG_THREADS_ACCOUNTING || defined(__DOXYGEN__)
+/**
+ * @brief   Public accounting state.
+ */
+ch_accounting_t dbg_accounting;
+
+/**
+ * @brief   Computes a load in hundredths of percent.
+ *
+ * @param[in] t         time spent in the window
+ * @param[in] window    window length
+ * @return              The load value.
+ */
+static uint16_t acc_load(uint64_t t, uint32_t window) {
+
+  t = (t * 10000) / window;
+  return t > 10000 ? 10000 : (uint16_t)t;
+}
+
+/**
+ * @brief   Threads accounting subsystem initialization.
+ * @note    Internal use only.
+ */
+void _acc_init(void) {
+
+  dbg_accounting.acc_last = port_rt_get_counter_value();
+  dbg_accounting.acc_window = dbg_accounting.acc_last;
+  dbg_accounting.acc_period = (uint32_t)(((uint64_t)CH_ACCOUNTING_WINDOW *
+                                          port_rt_get_counter_frequency()) /
+                                         1000);
+  dbg_accounting.acc_serial = 0;
+  dbg_accounting.acc_elapsed = dbg_accounting.acc_period;
+  dbg_accounting.acc_nesting = 0;
+  dbg_accounting.acc_isr_count = 0;
+  dbg_accounting.acc_isr_load = 0;
+  dbg_accounting.acc_isr_time = 0;
+  dbg_accounting.acc_isr_mark = 0;
+}
+
+/**
+ * @brief   Brings the load of a thread up to the current window.
+ * @details If the thread has not been charged since the last window end
+ *          then its load is computed over that window, a thread not
+ *          charged during the last window has zero load.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @notapi
+ */
+void dbg_acc_roll(Thread *tp) {
+
+  if (tp->p_window != dbg_accounting.acc_serial) {
+    if (tp->p_window + 1 == dbg_accounting.acc_serial)
+      tp->p_load = acc_load(tp->p_runtime - tp->p_runmark,
+                            dbg_accounting.acc_elapsed);
+    else
+      tp->p_load = 0;
+    tp->p_runmark = tp->p_runtime;
+    tp->p_window = dbg_accounting.acc_serial;
+  }
+}
+
+/**
+ * @brief   Charges the time elapsed since the last accounting event to the
+ *          thread being switched out.
+ *
+ * @param[in] otp       the thread being switched out
+ *
+ * @notapi
+ */
+void dbg_acc_switch(Thread *otp) {
+  uint32_t now = port_rt_get_counter_value();
+
+  dbg_acc_roll(otp);
+  otp->p_runtime += (uint32_t)(now - dbg_accounting.acc_last);
+  dbg_accounting.acc_last = now;
+}
+
+/**
+ * @brief   Charges the time elapsed since the last accounting event to the
+ *          interrupted thread.
+ * @note    Nested ISRs are charged to the outermost one.
+ *
+ * @notapi
+ */
+void dbg_acc_isr_enter(void) {
+
+  port_lock_from_isr();
+  if (dbg_accounting.acc_nesting++ == 0) {
+    uint32_t now = port_rt_get_counter_value();
+
+    dbg_acc_roll(currp);
+    currp->p_runtime += (uint32_t)(now - dbg_accounting.acc_last);
+    dbg_accounting.acc_last = now;
+  }
+  port_unlock_from_isr();
+}
+
+/**
+ * @brief   Charges the time elapsed since the outermost ISR enter to the
+ *          ISRs account.
+ *
+ * @notapi
+ */
+void dbg_acc_isr_leave(void) {
+
+  port_lock_from_isr();
+  if (--dbg_accounting.acc_nesting == 0) {
+    uint32_t now = port_rt_get_counter_value();
+
+    dbg_accounting.acc_isr_time += (uint32_t)(now - dbg_accounting.acc_last);
+    dbg_accounting.acc_isr_count++;
+    dbg_accounting.acc_last = now;
+  }
+  port_unlock_from_isr();
+}
+
+/**
+ * @brief   Closes the measurement window when its period is elapsed.
+ * @details The load of each thread is the fraction of the last window spent
+ *          executing the thread. Only the interrupted thread is updated
+ *          here, the other threads are updated the next time they are
+ *          charged or their load is read.
+ * @note    In tick-less mode the windows are closed on the first system
+ *          timer event after their end so the loads can be stale.
+ *
+ * @iclass
+ */
+void dbg_acc_tick(void) {
+  uint32_t elapsed = port_rt_get_counter_value() - dbg_accounting.acc_window;
+
+  chDbgCheckClassI();
+
+  if (elapsed < dbg_accounting.acc_period)
+    return;
+
+  dbg_accounting.acc_serial++;
+  dbg_accounting.acc_elapsed = elapsed;
+  dbg_acc_roll(currp);
+  dbg_accounting.acc_isr_load = acc_load(dbg_accounting.acc_isr_time -
+                                         dbg_accounting.acc_isr_mark,
+                                         elapsed);
+  dbg_accounting.acc_isr_mark = dbg_accounting.acc_isr_time;
+  dbg_accounting.acc_window += elapsed;
+}
+
+/**
+ * @brief   Returns the time spent in ISRs.
+ *
+ * @return              The time in realtime counter cycles.
+ *
+ * @api
+ */
+uint64_t chDbgGetIsrRunTime(void) {
+  uint64_t t;
+
+  chSysLock();
+  t = dbg_accounting.acc_isr_time;
+  chSysUnlock();
+  return t;
+}
+#endif /* CH_DBG_THREADS_ACCOUNTING */
+
 /*===========================================================================*/
 /* Panic related code and variables.                                         */
 /*===========================================================================*/
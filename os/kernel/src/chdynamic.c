@@ -148,6 +148,9 @@ Thread *chThdCreateFromHeap(MemoryHeap *heapp, size_t size,
   chSysLock();
   tp = chThdCreateI(wsp, size, prio, pf, arg);
   tp->p_flags = THD_MEM_MODE_HEAP;
+#if CH_DBG_FILL_THREADS
+  tp->p_wend = (uint8_t *)wsp + size;
+#endif
   chSchWakeupS(tp, RDY_OK);
   chSysUnlock();
   return tp;
@@ -200,6 +203,9 @@ Thread *chThdCreateFromMemoryPool(MemoryPool *mp, tprio_t prio,
   tp = chThdCreateI(wsp, mp->mp_object_size, prio, pf, arg);
   tp->p_flags = THD_MEM_MODE_MEMPOOL;
   tp->p_mpool = mp;
+#if CH_DBG_FILL_THREADS
+  tp->p_wend = (uint8_t *)wsp + mp->mp_object_size;
+#endif
   chSchWakeupS(tp, RDY_OK);
   chSysUnlock();
   return tp;
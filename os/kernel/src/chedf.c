@@ -0,0 +1,160 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    chedf.c
+ * @brief   EDF scheduling class code.
+ *
+ * @addtogroup edf
+ * @details Earliest deadline first scheduling class.<br>
+ *          A thread enters the EDF class by invoking @p chEdfEnter() with
+ *          its activation period and relative deadline, from that point its
+ *          code is a sequence of jobs separated by calls to
+ *          @p chEdfWaitNextPeriod().<br>
+ *          The EDF threads share the reserved @p EDFPRIO priority level,
+ *          within that level the ready list keeps them ordered by absolute
+ *          deadline so the thread with the earliest deadline runs first,
+ *          threads with higher priority preempt the EDF threads and
+ *          threads with lower priority only run when no EDF thread is
+ *          ready. An EDF thread is preempted by a ready EDF thread with an
+ *          earlier deadline and is not subject to round robin.<br>
+ *          Each job is watched by a virtual timer armed on its absolute
+ *          deadline, if the job is not completed before the deadline the
+ *          miss is counted immediately.
+ * @note    The priority inheritance protocol is not aware of deadlines, an
+ *          EDF thread waiting on a mutex owned by an EDF thread with a
+ *          later deadline does not boost it.
+ * @pre     In order to use the EDF APIs the @p CH_USE_EDF option must be
+ *          enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_EDF || defined(__DOXYGEN__)
+
+/*
+ * Deadline miss callback.
+ */
+static void edf_miss(void *p) {
+
+  chSysLockFromIsr();
+  ((Thread *)p)->p_edf.ed_misses++;
+  chSysUnlockFromIsr();
+}
+
+/*
+ * Arms the deadline miss detection timer of the current job, a deadline
+ * already passed is counted as missed immediately.
+ */
+static void edf_arm(Thread *tp) {
+  systime_t delay = (systime_t)(tp->p_edf.ed_deadline - chTimeNow());
+
+  if ((delay == 0) || (delay > tp->p_edf.ed_reldl))
+    tp->p_edf.ed_misses++;
+  else
+    chVTSetI(&tp->p_edf.ed_timer, delay, edf_miss, tp);
+}
+
+/**
+ * @brief   Makes the current thread an EDF thread.
+ * @details The thread priority is changed to @p EDFPRIO and its first job is
+ *          released immediately.
+ *
+ * @param[in] period    the activation period in system ticks
+ * @param[in] deadline  the relative deadline in system ticks, it must not be
+ *                      greater than the period
+ *
+ * @api
+ */
+void chEdfEnter(systime_t period, systime_t deadline) {
+  Thread *ctp = currp;
+
+  chDbgCheck((deadline > 0) && (deadline <= period) &&
+             (period < (systime_t)-1 / 2), "chEdfEnter");
+  chDbgAssert(ctp->p_edf.ed_period == 0,
+              "chEdfEnter(), #1", "already an EDF thread");
+
+  chSysLock();
+  ctp->p_edf.ed_period = period;
+  ctp->p_edf.ed_reldl = deadline;
+  ctp->p_edf.ed_release = chTimeNow();
+  ctp->p_edf.ed_deadline = ctp->p_edf.ed_release + deadline;
+  edf_arm(ctp);
+  chSysUnlock();
+  chThdSetPriority(EDFPRIO);
+}
+
+/**
+ * @brief   Completes the current job and waits for the next release.
+ * @details The next job is released one period after the current job
+ *          release. If the release time has already passed, because the job
+ *          overran its period, the next job is released immediately and the
+ *          following releases are realigned to the current time.
+ *
+ * @return              The completed job outcome.
+ * @retval FALSE        if the job completed within its deadline.
+ * @retval TRUE         if the job missed its deadline.
+ *
+ * @api
+ */
+bool_t chEdfWaitNextPeriod(void) {
+  Thread *ctp = currp;
+  systime_t now, delay;
+  bool_t missed;
+
+  chDbgAssert(ctp->p_edf.ed_period != 0,
+              "chEdfWaitNextPeriod(), #1", "not an EDF thread");
+
+  chSysLock();
+  /* If the timer already fired then the miss has already been counted.*/
+  missed = !chVTIsArmedI(&ctp->p_edf.ed_timer);
+  if (!missed)
+    chVTResetI(&ctp->p_edf.ed_timer);
+  ctp->p_edf.ed_jobs++;
+  ctp->p_edf.ed_release += ctp->p_edf.ed_period;
+  now = chTimeNow();
+  delay = (systime_t)(ctp->p_edf.ed_release - now);
+  if ((delay == 0) || (delay > ctp->p_edf.ed_period))
+    ctp->p_edf.ed_release = now;
+  /* The deadline is updated before sleeping because it is the ready list
+     ordering key when the thread is awakened.*/
+  ctp->p_edf.ed_deadline = ctp->p_edf.ed_release + ctp->p_edf.ed_reldl;
+  if (ctp->p_edf.ed_release != now)
+    chThdSleepS(delay);
+  else {
+    /* The deadline moved, other EDF threads could have precedence now.*/
+    chSchRescheduleS();
+  }
+  edf_arm(ctp);
+  chSysUnlock();
+  return missed;
+}
+
+#endif /* CH_USE_EDF */
+
+/** @} */
@@ -36,6 +36,12 @@
  *          are functionally equivalent to the usual @p malloc() and @p free()
  *          library functions. The main difference is that the OS heap APIs
  *          are guaranteed to be thread safe.<br>
+ *          By enabling the @p CH_USE_HEAP_TLSF option the heap manager
+ *          uses a two-level segregated fit allocator instead, the free
+ *          blocks are kept in per size class lists indexed by two levels
+ *          of bitmaps and the adjacent free blocks are merged using
+ *          boundary tags, both the allocation and the release are constant
+ *          time operations.<br>
  *          By enabling the @p CH_USE_MALLOC_HEAP option the heap manager
  *          will use the runtime-provided @p malloc() and @p free() as
  *          back end for the heap APIs instead of the system provided
@@ -67,6 +73,555 @@
  */
 static MemoryHeap default_heap;
 
+#if CH_USE_HEAP_CACHE || defined(__DOXYGEN__)
+/*===========================================================================*/
+/* Heap cache.                                                               */
+/*===========================================================================*/
+
+#define HC_MAX_SIZE     ((size_t)CH_HEAP_CACHE_MIN_SIZE <<                  \
+                         (CH_HEAP_CACHE_CLASSES - 1))
+
+/**
+ * @brief   Serves an allocation from the current thread cache.
+ * @details On a cache miss the requested size is rounded up to the size
+ *          of its class so that the block can be cached when released.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in,out] sizep pointer to the requested size
+ * @return              Pointer to the cached block.
+ * @retval NULL         if the allocation must be served by the heap.
+ */
+static void *hcache_alloc(MemoryHeap *heapp, size_t *sizep) {
+  HeapCache *hcp = currp->p_hcache;
+  size_t csize = CH_HEAP_CACHE_MIN_SIZE;
+  unsigned c = 0;
+
+  if ((hcp == NULL) || (hcp->hc_heap != heapp) || (*sizep > HC_MAX_SIZE))
+    return NULL;
+  while (csize < *sizep) {
+    csize <<= 1;
+    c++;
+  }
+  if (hcp->hc_count[c] > 0) {
+    hcp->hc_hits++;
+    return hcp->hc_blocks[c][--hcp->hc_count[c]];
+  }
+  hcp->hc_misses++;
+  *sizep = csize;
+  return NULL;
+}
+
+/**
+ * @brief   Puts a released block in the current thread cache.
+ * @details The block is put in the biggest class not exceeding its size.
+ *
+ * @param[in] p         pointer to the memory block
+ * @param[in] heapp     the block owner heap
+ * @param[in] size      the block size
+ * @return              The operation result.
+ * @retval TRUE         if the block has been cached.
+ * @retval FALSE        if the block must be returned to the heap.
+ */
+static bool_t hcache_free(void *p, MemoryHeap *heapp, size_t size) {
+  HeapCache *hcp = currp->p_hcache;
+  size_t csize = HC_MAX_SIZE;
+  unsigned c = CH_HEAP_CACHE_CLASSES - 1;
+
+  if ((hcp == NULL) || (hcp->hc_heap != heapp) ||
+      (size < CH_HEAP_CACHE_MIN_SIZE) || (size >= HC_MAX_SIZE * 2))
+    return FALSE;
+  while (csize > size) {
+    csize >>= 1;
+    c--;
+  }
+  if (hcp->hc_count[c] >= CH_HEAP_CACHE_DEPTH)
+    return FALSE;
+  hcp->hc_blocks[c][hcp->hc_count[c]++] = p;
+  return TRUE;
+}
+
+/**
+ * @brief   Initializes a heap cache.
+ *
+ * @param[out] hcp      pointer to the @p HeapCache structure
+ * @param[in] heapp     pointer to the cached heap or @p NULL for the
+ *                      default heap
+ *
+ * @init
+ */
+void chHeapCacheInit(HeapCache *hcp, MemoryHeap *heapp) {
+  unsigned c;
+
+  chDbgCheck(hcp != NULL, "chHeapCacheInit");
+
+  hcp->hc_heap = heapp != NULL ? heapp : &default_heap;
+  hcp->hc_hits = 0;
+  hcp->hc_misses = 0;
+  for (c = 0; c < CH_HEAP_CACHE_CLASSES; c++)
+    hcp->hc_count[c] = 0;
+}
+
+/**
+ * @brief   Attaches a heap cache to the current thread.
+ * @details The small allocations and releases performed by the thread on
+ *          the cached heap go through the cache.
+ * @note    The cache must not be attached to other threads.
+ *
+ * @param[in] hcp       pointer to the @p HeapCache structure
+ *
+ * @api
+ */
+void chHeapCacheAttach(HeapCache *hcp) {
+
+  chDbgCheck(hcp != NULL, "chHeapCacheAttach");
+
+  currp->p_hcache = hcp;
+}
+
+/**
+ * @brief   Detaches the heap cache from the current thread.
+ * @details The cached blocks are returned to the heap.
+ * @note    A thread should detach its cache before terminating, else the
+ *          blocks remain in the cache until it is flushed.
+ *
+ * @api
+ */
+void chHeapCacheDetach(void) {
+  HeapCache *hcp = currp->p_hcache;
+
+  if (hcp != NULL)
+    chHeapCacheFlush(hcp);
+  currp->p_hcache = NULL;
+}
+
+/**
+ * @brief   Returns all the cached blocks to the heap.
+ * @note    The cache must be attached to the current thread or to no
+ *          thread at all.
+ *
+ * @param[in] hcp       pointer to the @p HeapCache structure
+ *
+ * @api
+ */
+void chHeapCacheFlush(HeapCache *hcp) {
+  HeapCache *saved = currp->p_hcache;
+  unsigned c;
+
+  chDbgCheck(hcp != NULL, "chHeapCacheFlush");
+
+  currp->p_hcache = NULL;
+  for (c = 0; c < CH_HEAP_CACHE_CLASSES; c++)
+    while (hcp->hc_count[c] > 0)
+      chHeapFree(hcp->hc_blocks[c][--hcp->hc_count[c]]);
+  currp->p_hcache = saved;
+}
+#endif /* CH_USE_HEAP_CACHE */
+
+#if CH_USE_HEAP_TLSF || defined(__DOXYGEN__)
+/*===========================================================================*/
+/* TLSF allocator.                                                           */
+/*===========================================================================*/
+
+/*
+ * Shortcut for the block header type.
+ */
+typedef union heap_tlsf_header tlsf_block_t;
+
+/**
+ * @brief   Free list links stored in the payload of the free blocks.
+ */
+typedef struct {
+  tlsf_block_t          *next;
+  tlsf_block_t          *prev;
+} tlsf_links_t;
+
+#define TLSF_SL_COUNT   (1U << CH_HEAP_TLSF_SL_LOG2)
+#define TLSF_SMALL      (TLSF_SL_COUNT * MEM_ALIGN_SIZE)
+#define TLSF_MIN        MEM_ALIGN_NEXT(sizeof (tlsf_links_t))
+#define TLSF_FREE       ((size_t)1)
+
+#define B_SIZE(bp)      ((bp)->h.size & ~TLSF_FREE)
+#define B_IS_FREE(bp)   (((bp)->h.size & TLSF_FREE) != 0)
+#define B_LINKS(bp)     ((tlsf_links_t *)((bp) + 1))
+#define B_NEXT(bp)      ((tlsf_block_t *)((uint8_t *)((bp) + 1) +           \
+                                          B_SIZE(bp)))
+
+/*
+ * Index of the most significant set bit in a non-zero size.
+ */
+#if defined(__GNUC__)
+#define tlsf_fls(x) ((unsigned)(sizeof (unsigned long) * 8 - 1 -           \
+                                __builtin_clzl((unsigned long)(x))))
+#define tlsf_ffs(w) ((unsigned)__builtin_ctz(w))
+#else
+static unsigned tlsf_fls(size_t x) {
+  unsigned b = 0;
+
+  while (x >>= 1)
+    b++;
+  return b;
+}
+
+static unsigned tlsf_ffs(uint32_t w) {
+  unsigned b = 0;
+
+  while ((w & 1) == 0) {
+    w >>= 1;
+    b++;
+  }
+  return b;
+}
+#endif
+
+/**
+ * @brief   Computes the class of a block size.
+ *
+ * @param[in] size      the block size
+ * @param[out] flp      the first level class
+ * @param[out] slp      the second level class
+ */
+static void tlsf_mapping(size_t size, unsigned *flp, unsigned *slp) {
+  unsigned b;
+
+  if (size < TLSF_SMALL) {
+    *flp = 0;
+    *slp = (unsigned)(size / MEM_ALIGN_SIZE);
+    return;
+  }
+  b = tlsf_fls(size);
+  *flp = b - tlsf_fls(TLSF_SMALL) + 1;
+  *slp = (unsigned)(size >> (b - CH_HEAP_TLSF_SL_LOG2)) & (TLSF_SL_COUNT - 1);
+  if (*flp >= CH_HEAP_TLSF_FL_COUNT) {
+    *flp = CH_HEAP_TLSF_FL_COUNT - 1;
+    *slp = TLSF_SL_COUNT - 1;
+  }
+}
+
+/**
+ * @brief   Inserts a free block in its free list.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] bp        pointer to the block
+ */
+static void tlsf_insert(MemoryHeap *heapp, tlsf_block_t *bp) {
+  unsigned fl, sl;
+
+  tlsf_mapping(B_SIZE(bp), &fl, &sl);
+  B_LINKS(bp)->prev = NULL;
+  B_LINKS(bp)->next = heapp->h_blocks[fl][sl];
+  if (heapp->h_blocks[fl][sl] != NULL)
+    B_LINKS(heapp->h_blocks[fl][sl])->prev = bp;
+  heapp->h_blocks[fl][sl] = bp;
+  heapp->h_fl_map |= (uint32_t)1 << fl;
+  heapp->h_sl_map[fl] |= (uint32_t)1 << sl;
+}
+
+/**
+ * @brief   Removes a free block from its free list.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] bp        pointer to the block
+ */
+static void tlsf_remove(MemoryHeap *heapp, tlsf_block_t *bp) {
+  tlsf_block_t *next = B_LINKS(bp)->next, *prev = B_LINKS(bp)->prev;
+  unsigned fl, sl;
+
+  tlsf_mapping(B_SIZE(bp), &fl, &sl);
+  if (next != NULL)
+    B_LINKS(next)->prev = prev;
+  if (prev != NULL)
+    B_LINKS(prev)->next = next;
+  else if ((heapp->h_blocks[fl][sl] = next) == NULL) {
+    heapp->h_sl_map[fl] &= ~((uint32_t)1 << sl);
+    if (heapp->h_sl_map[fl] == 0)
+      heapp->h_fl_map &= ~((uint32_t)1 << fl);
+  }
+}
+
+/**
+ * @brief   Finds a free block able to contain the specified size.
+ * @details The size is rounded up to the next class boundary so that any
+ *          block in the found class is big enough. If there is no such
+ *          class then the first block of the size class itself is tried.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] size      the requested size
+ * @return              Pointer to the found block.
+ * @retval NULL         if there is not a suitable free block.
+ */
+static tlsf_block_t *tlsf_find(MemoryHeap *heapp, size_t size) {
+  unsigned fl, sl;
+  uint32_t map;
+  tlsf_block_t *bp;
+
+  tlsf_mapping(size, &fl, &sl);
+  if ((size >= TLSF_SMALL) && (fl < CH_HEAP_TLSF_FL_COUNT - 1) &&
+      ((size & (((size_t)1 << (tlsf_fls(size) -
+                               CH_HEAP_TLSF_SL_LOG2)) - 1)) != 0)) {
+    /* Rounding up to the next class.*/
+    if (++sl >= TLSF_SL_COUNT) {
+      sl = 0;
+      fl++;
+    }
+  }
+  map = heapp->h_sl_map[fl] & ((uint32_t)-1 << sl);
+  if (map == 0) {
+    map = heapp->h_fl_map & ((uint32_t)-1 << (fl + 1));
+    if (map != 0) {
+      fl = tlsf_ffs(map);
+      map = heapp->h_sl_map[fl];
+    }
+  }
+  if (map != 0) {
+    bp = heapp->h_blocks[fl][tlsf_ffs(map)];
+    /* The blocks in the last class are not bounded.*/
+    if (B_SIZE(bp) >= size)
+      return bp;
+  }
+
+  /* Last chance, the first block in the exact class.*/
+  tlsf_mapping(size, &fl, &sl);
+  bp = heapp->h_blocks[fl][sl];
+  if ((bp != NULL) && (B_SIZE(bp) >= size))
+    return bp;
+  return NULL;
+}
+
+/**
+ * @brief   Initializes the TLSF data of a heap.
+ *
+ * @param[out] heapp    pointer to the heap descriptor
+ */
+static void tlsf_init(MemoryHeap *heapp) {
+  unsigned fl, sl;
+
+  heapp->h_fl_map = 0;
+  for (fl = 0; fl < CH_HEAP_TLSF_FL_COUNT; fl++) {
+    heapp->h_sl_map[fl] = 0;
+    for (sl = 0; sl < TLSF_SL_COUNT; sl++)
+      heapp->h_blocks[fl][sl] = NULL;
+  }
+#if CH_USE_MUTEXES || defined(__DOXYGEN__)
+  chMtxInit(&heapp->h_mtx);
+#else
+  chSemInit(&heapp->h_sem, 1);
+#endif
+}
+
+/**
+ * @brief   Formats a memory area as a single block followed by a sentinel.
+ * @details The sentinel is a zero sized allocated block terminating the
+ *          area, it stops the coalescing of the last block.
+ *
+ * @param[in] heapp     pointer to the heap descriptor
+ * @param[in] p         area base
+ * @param[in] size      size of the block payload
+ * @return              Pointer to the block.
+ */
+static tlsf_block_t *tlsf_area(MemoryHeap *heapp, void *p, size_t size) {
+  tlsf_block_t *bp = p, *sp;
+
+  bp->h.prev = NULL;
+  bp->h.size = size;
+  bp->h.heap = heapp;
+  sp = B_NEXT(bp);
+  sp->h.prev = bp;
+  sp->h.size = 0;
+  sp->h.heap = heapp;
+  return bp;
+}
+
+/**
+ * @brief   Initializes the default heap.
+ *
+ * @notapi
+ */
+void _heap_init(void) {
+
+  default_heap.h_provider = chCoreAlloc;
+  tlsf_init(&default_heap);
+}
+
+/**
+ * @brief   Initializes a memory heap from a static memory area.
+ * @pre     Both the heap buffer base and the heap size must be aligned to
+ *          the @p stkalign_t type size.
+ * @pre     In order to use this function the option @p CH_USE_MALLOC_HEAP
+ *          must be disabled.
+ *
+ * @param[out] heapp    pointer to the memory heap descriptor to be initialized
+ * @param[in] buf       heap buffer base
+ * @param[in] size      heap size
+ *
+ * @init
+ */
+void chHeapInit(MemoryHeap *heapp, void *buf, size_t size) {
+  tlsf_block_t *bp;
+
+  chDbgCheck(MEM_IS_ALIGNED(buf) && MEM_IS_ALIGNED(size) &&
+             (size >= 2 * sizeof (tlsf_block_t) + TLSF_MIN), "chHeapInit");
+
+  heapp->h_provider = (memgetfunc_t)NULL;
+  tlsf_init(heapp);
+  bp = tlsf_area(heapp, buf, size - 2 * sizeof (tlsf_block_t));
+  bp->h.size |= TLSF_FREE;
+  tlsf_insert(heapp, bp);
+}
+
+/**
+ * @brief   Allocates a block of memory from the heap by using the TLSF
+ *          algorithm.
+ * @details The allocated block is guaranteed to be properly aligned for a
+ *          pointer data type (@p stkalign_t).
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[in] size      the size of the block to be allocated. Note that the
+ *                      allocated block may be a bit bigger than the requested
+ *                      size for alignment and fragmentation reasons.
+ * @return              A pointer to the allocated block.
+ * @retval NULL         if the block cannot be allocated.
+ *
+ * @api
+ */
+void *chHeapAlloc(MemoryHeap *heapp, size_t size) {
+  tlsf_block_t *bp, *fp;
+#if CH_USE_HEAP_CACHE
+  void *p;
+#endif
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+#if CH_USE_HEAP_CACHE
+  if ((p = hcache_alloc(heapp, &size)) != NULL)
+    return p;
+#endif
+  size = MEM_ALIGN_NEXT(size);
+  if (size < TLSF_MIN)
+    size = TLSF_MIN;
+  H_LOCK(heapp);
+
+  if ((bp = tlsf_find(heapp, size)) != NULL) {
+    tlsf_remove(heapp, bp);
+    if (B_SIZE(bp) >= size + sizeof (tlsf_block_t) + TLSF_MIN) {
+      /* Block bigger enough, must split it, the remaining part cannot be
+         merged because the next block is surely allocated.*/
+      fp = (tlsf_block_t *)((uint8_t *)(bp + 1) + size);
+      fp->h.prev = bp;
+      fp->h.size = (B_SIZE(bp) - size - sizeof (tlsf_block_t)) | TLSF_FREE;
+      B_NEXT(fp)->h.prev = fp;
+      bp->h.size = size;
+      tlsf_insert(heapp, fp);
+    }
+    else
+      bp->h.size = B_SIZE(bp);
+    bp->h.heap = heapp;
+
+    H_UNLOCK(heapp);
+    return (void *)(bp + 1);
+  }
+
+  H_UNLOCK(heapp);
+
+  /* More memory is required, tries to get it from the associated provider
+     else fails. The new area is made of the block and its sentinel.*/
+  if ((heapp->h_provider) && (size < (size_t)-1 - 2 * sizeof (tlsf_block_t))) {
+    void *p = heapp->h_provider(size + 2 * sizeof (tlsf_block_t));
+    if (p != NULL)
+      return (void *)(tlsf_area(heapp, p, size) + 1);
+  }
+  return NULL;
+}
+
+/**
+ * @brief   Frees a previously allocated memory block.
+ * @details The block is merged with the adjacent free blocks, if any.
+ *
+ * @param[in] p         pointer to the memory block to be freed
+ *
+ * @api
+ */
+void chHeapFree(void *p) {
+  tlsf_block_t *bp, *np;
+  MemoryHeap *heapp;
+
+  chDbgCheck(p != NULL, "chHeapFree");
+
+  bp = (tlsf_block_t *)p - 1;
+  heapp = bp->h.heap;
+#if CH_USE_HEAP_CACHE
+  if (hcache_free(p, heapp, B_SIZE(bp)))
+    return;
+#endif
+  H_LOCK(heapp);
+
+  chDbgAssert(!B_IS_FREE(bp), "chHeapFree(), #1", "block already free");
+
+  np = B_NEXT(bp);
+  if (B_IS_FREE(np)) {
+    /* Merge with the next block.*/
+    tlsf_remove(heapp, np);
+    bp->h.size += sizeof (tlsf_block_t) + B_SIZE(np);
+    B_NEXT(bp)->h.prev = bp;
+  }
+  if ((bp->h.prev != NULL) && B_IS_FREE(bp->h.prev)) {
+    /* Merge with the previous block.*/
+    np = bp;
+    bp = bp->h.prev;
+    tlsf_remove(heapp, bp);
+    bp->h.size += sizeof (tlsf_block_t) + B_SIZE(np);
+    B_NEXT(bp)->h.prev = bp;
+  }
+  bp->h.size |= TLSF_FREE;
+  tlsf_insert(heapp, bp);
+
+  H_UNLOCK(heapp);
+}
+
+/**
+ * @brief   Reports the heap status.
+ * @note    This function is meant to be used in the test suite, it should
+ *          not be really useful for the application code.
+ * @note    This function is not implemented when the @p CH_USE_MALLOC_HEAP
+ *          configuration option is used (it always returns zero).
+ *
+ * @param[in] heapp     pointer to a heap descriptor or @p NULL in order to
+ *                      access the default heap.
+ * @param[in] sizep     pointer to a variable that will receive the total
+ *                      fragmented free space
+ * @return              The number of fragments in the heap.
+ *
+ * @api
+ */
+size_t chHeapStatus(MemoryHeap *heapp, size_t *sizep) {
+  tlsf_block_t *bp;
+  unsigned fl, sl;
+  size_t n, sz;
+
+  if (heapp == NULL)
+    heapp = &default_heap;
+
+  H_LOCK(heapp);
+
+  n = sz = 0;
+  for (fl = 0; fl < CH_HEAP_TLSF_FL_COUNT; fl++) {
+    for (sl = 0; sl < TLSF_SL_COUNT; sl++) {
+      for (bp = heapp->h_blocks[fl][sl]; bp != NULL; bp = B_LINKS(bp)->next) {
+        n++;
+        sz += B_SIZE(bp);
+      }
+    }
+  }
+  if (sizep)
+    *sizep = sz;
+
+  H_UNLOCK(heapp);
+  return n;
+}
+
+#else /* !CH_USE_HEAP_TLSF */
+
 /**
  * @brief   Initializes the default heap.
  *
@@ -131,10 +686,17 @@ void chHeapInit(MemoryHeap *heapp, void *buf, size_t size) {
  */
 void *chHeapAlloc(MemoryHeap *heapp, size_t size) {
   union heap_header *qp, *hp, *fp;
+#if CH_USE_HEAP_CACHE
+  void *p;
+#endif
 
   if (heapp == NULL)
     heapp = &default_heap;
 
+#if CH_USE_HEAP_CACHE
+  if ((p = hcache_alloc(heapp, &size)) != NULL)
+    return p;
+#endif
   size = MEM_ALIGN_NEXT(size);
   qp = &heapp->h_free;
   H_LOCK(heapp);
@@ -199,6 +761,10 @@ void chHeapFree(void *p) {
 
   hp = (union heap_header *)p - 1;
   heapp = hp->h.u.heap;
+#if CH_USE_HEAP_CACHE
+  if (hcache_free(p, heapp, hp->h.size))
+    return;
+#endif
   qp = &heapp->h_free;
   H_LOCK(heapp);
 
@@ -265,6 +831,7 @@ size_t chHeapStatus(MemoryHeap *heapp, size_t *sizep) {
   H_UNLOCK(heapp);
   return n;
 }
+#endif /* !CH_USE_HEAP_TLSF */
 
 #else /* CH_USE_MALLOC_HEAP */
 
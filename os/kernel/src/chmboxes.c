@@ -60,6 +60,60 @@
 #include "ch.h"
 
 #if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+/**
+ * @brief   Copies messages into the mailbox buffer.
+ * @note    The free slots must have already been reserved.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[in] msgs      pointer to the messages array
+ * @param[in] n         number of messages to be copied
+ */
+static void mb_put(Mailbox *mbp, const msg_t *msgs, cnt_t n) {
+
+  while (n-- > 0) {
+    *mbp->mb_wrptr++ = *msgs++;
+    if (mbp->mb_wrptr >= mbp->mb_top)
+      mbp->mb_wrptr = mbp->mb_buffer;
+  }
+}
+
+/**
+ * @brief   Copies messages from the mailbox buffer.
+ * @note    The full slots must have already been reserved.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[out] msgs     pointer to the messages array
+ * @param[in] n         number of messages to be copied
+ */
+static void mb_get(Mailbox *mbp, msg_t *msgs, cnt_t n) {
+
+  while (n-- > 0) {
+    *msgs++ = *mbp->mb_rdptr++;
+    if (mbp->mb_rdptr >= mbp->mb_top)
+      mbp->mb_rdptr = mbp->mb_buffer;
+  }
+}
+
+/**
+ * @brief   Reserves up to @p n slots from a mailbox semaphore.
+ * @details The slots are taken without waiting, the semaphore counter is
+ *          decreased at once.
+ *
+ * @param[in] sp        pointer to the @p Semaphore structure
+ * @param[in] n         maximum number of slots
+ * @return              The number of reserved slots.
+ */
+static cnt_t mb_reserve(Semaphore *sp, cnt_t n) {
+  cnt_t avail = chSemGetCounterI(sp);
+
+  if (avail <= 0)
+    return 0;
+  if (n > avail)
+    n = avail;
+  sp->s_cnt -= n;
+  return n;
+}
+
 /**
  * @brief   Initializes a Mailbox object.
  *
@@ -158,6 +212,7 @@ msg_t chMBPostS(Mailbox *mbp, msg_t msg, systime_t time) {
     *mbp->mb_wrptr++ = msg;
     if (mbp->mb_wrptr >= mbp->mb_top)
       mbp->mb_wrptr = mbp->mb_buffer;
+    dbg_trace_event(CH_TRACE_TYPE_MB_POST, currp, mbp);
     chSemSignalI(&mbp->mb_fullsem);
     chSchRescheduleS();
   }
@@ -189,10 +244,106 @@ msg_t chMBPostI(Mailbox *mbp, msg_t msg) {
   *mbp->mb_wrptr++ = msg;
   if (mbp->mb_wrptr >= mbp->mb_top)
     mbp->mb_wrptr = mbp->mb_buffer;
+  dbg_trace_event(CH_TRACE_TYPE_MB_POST, currp, mbp);
   chSemSignalI(&mbp->mb_fullsem);
   return RDY_OK;
 }
 
+/**
+ * @brief   Posts multiple messages into a mailbox.
+ * @details The invoking thread waits until at least an empty slot in the
+ *          mailbox becomes available or the specified time runs out, then
+ *          up to @p n messages are posted at once.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[in] msgs      pointer to the array of messages to be posted
+ * @param[in] n         maximum number of messages to be posted, the value 0
+ *                      is reserved
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of posted messages.
+ * @retval 0            if the mailbox has been reset while waiting or the
+ *                      operation has timed out.
+ *
+ * @api
+ */
+cnt_t chMBPostN(Mailbox *mbp, const msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t posted;
+
+  chSysLock();
+  posted = chMBPostNS(mbp, msgs, n, time);
+  chSysUnlock();
+  return posted;
+}
+
+/**
+ * @brief   Posts multiple messages into a mailbox.
+ * @details The invoking thread waits until at least an empty slot in the
+ *          mailbox becomes available or the specified time runs out, then
+ *          up to @p n messages are posted at once.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[in] msgs      pointer to the array of messages to be posted
+ * @param[in] n         maximum number of messages to be posted, the value 0
+ *                      is reserved
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of posted messages.
+ * @retval 0            if the mailbox has been reset while waiting or the
+ *                      operation has timed out.
+ *
+ * @sclass
+ */
+cnt_t chMBPostNS(Mailbox *mbp, const msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t posted;
+
+  chDbgCheckClassS();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0), "chMBPostNS");
+
+  if (chSemWaitTimeoutS(&mbp->mb_emptysem, time) != RDY_OK)
+    return 0;
+  posted = 1 + mb_reserve(&mbp->mb_emptysem, n - 1);
+  mb_put(mbp, msgs, posted);
+  dbg_trace_event(CH_TRACE_TYPE_MB_POST, currp, mbp);
+  chSemAddCounterI(&mbp->mb_fullsem, posted);
+  chSchRescheduleS();
+  return posted;
+}
+
+/**
+ * @brief   Posts multiple messages into a mailbox.
+ * @details This variant is non-blocking, up to @p n messages are posted
+ *          depending on the free slots in the mailbox.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[in] msgs      pointer to the array of messages to be posted
+ * @param[in] n         maximum number of messages to be posted, the value 0
+ *                      is reserved
+ * @return              The number of posted messages.
+ * @retval 0            if the mailbox is full.
+ *
+ * @iclass
+ */
+cnt_t chMBPostNI(Mailbox *mbp, const msg_t *msgs, cnt_t n) {
+  cnt_t posted;
+
+  chDbgCheckClassI();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0), "chMBPostNI");
+
+  if ((posted = mb_reserve(&mbp->mb_emptysem, n)) == 0)
+    return 0;
+  mb_put(mbp, msgs, posted);
+  dbg_trace_event(CH_TRACE_TYPE_MB_POST, currp, mbp);
+  chSemAddCounterI(&mbp->mb_fullsem, posted);
+  return posted;
+}
+
 /**
  * @brief   Posts an high priority message into a mailbox.
  * @details The invoking thread waits until a empty slot in the mailbox becomes
@@ -251,6 +402,7 @@ msg_t chMBPostAheadS(Mailbox *mbp, msg_t msg, systime_t time) {
     if (--mbp->mb_rdptr < mbp->mb_buffer)
       mbp->mb_rdptr = mbp->mb_top - 1;
     *mbp->mb_rdptr = msg;
+    dbg_trace_event(CH_TRACE_TYPE_MB_POST, currp, mbp);
     chSemSignalI(&mbp->mb_fullsem);
     chSchRescheduleS();
   }
@@ -282,6 +434,7 @@ msg_t chMBPostAheadI(Mailbox *mbp, msg_t msg) {
   if (--mbp->mb_rdptr < mbp->mb_buffer)
     mbp->mb_rdptr = mbp->mb_top - 1;
   *mbp->mb_rdptr = msg;
+  dbg_trace_event(CH_TRACE_TYPE_MB_POST, currp, mbp);
   chSemSignalI(&mbp->mb_fullsem);
   return RDY_OK;
 }
@@ -344,6 +497,7 @@ msg_t chMBFetchS(Mailbox *mbp, msg_t *msgp, systime_t time) {
     *msgp = *mbp->mb_rdptr++;
     if (mbp->mb_rdptr >= mbp->mb_top)
       mbp->mb_rdptr = mbp->mb_buffer;
+    dbg_trace_event(CH_TRACE_TYPE_MB_FETCH, currp, mbp);
     chSemSignalI(&mbp->mb_emptysem);
     chSchRescheduleS();
   }
@@ -375,9 +529,105 @@ msg_t chMBFetchI(Mailbox *mbp, msg_t *msgp) {
   *msgp = *mbp->mb_rdptr++;
   if (mbp->mb_rdptr >= mbp->mb_top)
     mbp->mb_rdptr = mbp->mb_buffer;
+  dbg_trace_event(CH_TRACE_TYPE_MB_FETCH, currp, mbp);
   chSemSignalI(&mbp->mb_emptysem);
   return RDY_OK;
 }
+
+/**
+ * @brief   Retrieves multiple messages from a mailbox.
+ * @details The invoking thread waits until at least a message is posted in
+ *          the mailbox or the specified time runs out, then up to @p n
+ *          messages are retrieved at once.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[out] msgs     pointer to an array for the received messages
+ * @param[in] n         maximum number of messages to be retrieved, the
+ *                      value 0 is reserved
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of retrieved messages.
+ * @retval 0            if the mailbox has been reset while waiting or the
+ *                      operation has timed out.
+ *
+ * @api
+ */
+cnt_t chMBFetchN(Mailbox *mbp, msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t fetched;
+
+  chSysLock();
+  fetched = chMBFetchNS(mbp, msgs, n, time);
+  chSysUnlock();
+  return fetched;
+}
+
+/**
+ * @brief   Retrieves multiple messages from a mailbox.
+ * @details The invoking thread waits until at least a message is posted in
+ *          the mailbox or the specified time runs out, then up to @p n
+ *          messages are retrieved at once.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[out] msgs     pointer to an array for the received messages
+ * @param[in] n         maximum number of messages to be retrieved, the
+ *                      value 0 is reserved
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of retrieved messages.
+ * @retval 0            if the mailbox has been reset while waiting or the
+ *                      operation has timed out.
+ *
+ * @sclass
+ */
+cnt_t chMBFetchNS(Mailbox *mbp, msg_t *msgs, cnt_t n, systime_t time) {
+  cnt_t fetched;
+
+  chDbgCheckClassS();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0), "chMBFetchNS");
+
+  if (chSemWaitTimeoutS(&mbp->mb_fullsem, time) != RDY_OK)
+    return 0;
+  fetched = 1 + mb_reserve(&mbp->mb_fullsem, n - 1);
+  mb_get(mbp, msgs, fetched);
+  dbg_trace_event(CH_TRACE_TYPE_MB_FETCH, currp, mbp);
+  chSemAddCounterI(&mbp->mb_emptysem, fetched);
+  chSchRescheduleS();
+  return fetched;
+}
+
+/**
+ * @brief   Retrieves multiple messages from a mailbox.
+ * @details This variant is non-blocking, up to @p n messages are retrieved
+ *          depending on the messages in the mailbox.
+ *
+ * @param[in] mbp       the pointer to an initialized Mailbox object
+ * @param[out] msgs     pointer to an array for the received messages
+ * @param[in] n         maximum number of messages to be retrieved, the
+ *                      value 0 is reserved
+ * @return              The number of retrieved messages.
+ * @retval 0            if the mailbox is empty.
+ *
+ * @iclass
+ */
+cnt_t chMBFetchNI(Mailbox *mbp, msg_t *msgs, cnt_t n) {
+  cnt_t fetched;
+
+  chDbgCheckClassI();
+  chDbgCheck((mbp != NULL) && (msgs != NULL) && (n > 0), "chMBFetchNI");
+
+  if ((fetched = mb_reserve(&mbp->mb_fullsem, n)) == 0)
+    return 0;
+  mb_get(mbp, msgs, fetched);
+  dbg_trace_event(CH_TRACE_TYPE_MB_FETCH, currp, mbp);
+  chSemAddCounterI(&mbp->mb_emptysem, fetched);
+  return fetched;
+}
 #endif /* CH_USE_MAILBOXES */
 
 /** @} */
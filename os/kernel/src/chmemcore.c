@@ -45,7 +45,13 @@
  *          can coexist and share the main memory.<br>
  *          This allocator, alone, is also useful for very simple
  *          applications that just require a simple way to get memory
- *          blocks.
+ *          blocks.<br>
+ *          If the @p CH_USE_MEMCORE_REGIONS option is enabled then more
+ *          memory regions, for example a core coupled RAM or a backup RAM,
+ *          can be registered with their attributes. The placed allocations
+ *          select the region by attributes and the @p chCoreAllocDMA() and
+ *          @p chCoreAllocFast() functions can be used as providers for the
+ *          memory pools.
  * @pre     In order to use the core memory manager APIs the @p CH_USE_MEMCORE
  *          option must be enabled in @p chconf.h.
  * @{
@@ -55,8 +61,18 @@
 
 #if CH_USE_MEMCORE || defined(__DOXYGEN__)
 
+#if !CH_USE_MEMCORE_REGIONS
 static uint8_t *nextmem;
 static uint8_t *endmem;
+#else
+/**
+ * @brief   Default region, it is the head of the regions list.
+ */
+static MemoryRegion default_region;
+
+#define nextmem     default_region.mr_next
+#define endmem      default_region.mr_end
+#endif
 
 /**
  * @brief   Low level memory manager initialization.
@@ -74,6 +90,11 @@ void _core_init(void) {
   nextmem = (uint8_t *)&buffer[0];
   endmem = (uint8_t *)&buffer[MEM_ALIGN_NEXT(CH_MEMCORE_SIZE)/MEM_ALIGN_SIZE];
 #endif
+#if CH_USE_MEMCORE_REGIONS
+  default_region.mr_link = NULL;
+  default_region.mr_name = "core";
+  default_region.mr_attr = CH_MEMCORE_ATTRIBUTES;
+#endif
 }
 
 /**
@@ -133,6 +154,230 @@ size_t chCoreStatus(void) {
 
   return (size_t)(endmem - nextmem);
 }
+
+#if CH_USE_MEMCORE_REGIONS || defined(__DOXYGEN__)
+/**
+ * @brief   Registers a memory region.
+ * @details The regions are searched in registration order by the placed
+ *          allocations, the default region is always the first.
+ * @note    Registering again an already registered region resets it, its
+ *          position in the regions list is kept.
+ *
+ * @param[out] mrp      pointer to a @p MemoryRegion structure
+ * @param[in] name      the region name
+ * @param[in] base      the region base address
+ * @param[in] size      the region size
+ * @param[in] attr      the region attributes
+ *
+ * @api
+ */
+void chCoreRegisterRegion(MemoryRegion *mrp, const char *name,
+                          void *base, size_t size, memattr_t attr) {
+  MemoryRegion *lp;
+
+  chDbgCheck((mrp != NULL) && (base != NULL), "chCoreRegisterRegion");
+
+  chSysLock();
+  lp = &default_region;
+  while ((lp != mrp) && (lp->mr_link != NULL))
+    lp = lp->mr_link;
+  /* The link of an already registered region is preserved, clearing it
+     would drop all the regions registered after it.*/
+  if (lp != mrp) {
+    mrp->mr_link = NULL;
+    lp->mr_link = mrp;
+  }
+  mrp->mr_name = name;
+  mrp->mr_next = (uint8_t *)MEM_ALIGN_NEXT(base);
+  mrp->mr_end = (uint8_t *)MEM_ALIGN_PREV((uint8_t *)base + size);
+  mrp->mr_attr = attr;
+  chSysUnlock();
+}
+
+/**
+ * @brief   Returns a registered region by name.
+ *
+ * @param[in] name      the region name
+ * @return              The pointer to the region.
+ * @retval NULL         if the region does not exist.
+ *
+ * @api
+ */
+MemoryRegion *chCoreGetRegion(const char *name) {
+  MemoryRegion *mrp = &default_region;
+
+  chDbgCheck(name != NULL, "chCoreGetRegion");
+
+  do {
+    const char *p1 = mrp->mr_name, *p2 = name;
+
+    while ((*p1 != '\0') && (*p1 == *p2)) {
+      p1++;
+      p2++;
+    }
+    if (*p1 == *p2)
+      return mrp;
+    mrp = mrp->mr_link;
+  } while (mrp != NULL);
+  return NULL;
+}
+
+/**
+ * @brief   Returns the next registered region.
+ *
+ * @param[in] mrp       pointer to a @p MemoryRegion structure or @p NULL
+ *                      for the first region
+ * @return              The pointer to the next region.
+ * @retval NULL         if there are no more regions.
+ *
+ * @api
+ */
+MemoryRegion *chCoreNextRegion(MemoryRegion *mrp) {
+
+  return mrp == NULL ? &default_region : mrp->mr_link;
+}
+
+/**
+ * @brief   Region memory status.
+ *
+ * @param[in] mrp       pointer to a @p MemoryRegion structure
+ * @return              The size, in bytes, of the free memory in the region.
+ *
+ * @api
+ */
+size_t chCoreRegionStatus(MemoryRegion *mrp) {
+
+  chDbgCheck(mrp != NULL, "chCoreRegionStatus");
+
+  return (size_t)(mrp->mr_end - mrp->mr_next);
+}
+
+/**
+ * @brief   Allocates an aligned memory block from a region.
+ * @note    The memory skipped in order to align the block is lost.
+ *
+ * @param[in] mrp       pointer to a @p MemoryRegion structure
+ * @param[in] size      the size of the block to be allocated
+ * @param[in] align     the required alignment, it must be a power of two,
+ *                      values lower than @p MEM_ALIGN_SIZE are rounded up
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, region memory exhausted.
+ *
+ * @iclass
+ */
+void *chCoreAllocAlignedI(MemoryRegion *mrp, size_t size, size_t align) {
+  uint8_t *p;
+
+  chDbgCheckClassI();
+  chDbgCheck((mrp != NULL) && ((align & (align - 1)) == 0),
+             "chCoreAllocAlignedI");
+
+  if (align < MEM_ALIGN_SIZE)
+    align = MEM_ALIGN_SIZE;
+  size = MEM_ALIGN_NEXT(size);
+  p = (uint8_t *)(((uintptr_t)mrp->mr_next + align - 1) &
+                  ~((uintptr_t)align - 1));
+  if ((p > mrp->mr_end) || ((size_t)(mrp->mr_end - p) < size))
+    return NULL;
+  mrp->mr_next = p + size;
+  return p;
+}
+
+/**
+ * @brief   Allocates an aligned memory block with placement hints.
+ * @details The block is allocated from the first region having both the
+ *          required and the preferred attributes, if no such region can
+ *          satisfy the request then the first region having the required
+ *          attributes is used.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @param[in] align     the required alignment, it must be a power of two
+ * @param[in] required  the attributes the region must have
+ * @param[in] preferred the attributes the region should have
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, no suitable region.
+ *
+ * @iclass
+ */
+void *chCoreAllocPlacedI(size_t size, size_t align,
+                         memattr_t required, memattr_t preferred) {
+  MemoryRegion *mrp;
+  memattr_t attr = required | preferred;
+  void *p;
+
+  chDbgCheckClassI();
+
+  while (TRUE) {
+    for (mrp = &default_region; mrp != NULL; mrp = mrp->mr_link) {
+      if (((mrp->mr_attr & attr) == attr) &&
+          ((p = chCoreAllocAlignedI(mrp, size, align)) != NULL))
+        return p;
+    }
+    if (attr == required)
+      return NULL;
+    attr = required;
+  }
+}
+
+/**
+ * @brief   Allocates an aligned memory block with placement hints.
+ * @details The block is allocated from the first region having both the
+ *          required and the preferred attributes, if no such region can
+ *          satisfy the request then the first region having the required
+ *          attributes is used.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @param[in] align     the required alignment, it must be a power of two
+ * @param[in] required  the attributes the region must have
+ * @param[in] preferred the attributes the region should have
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, no suitable region.
+ *
+ * @api
+ */
+void *chCoreAllocPlaced(size_t size, size_t align,
+                        memattr_t required, memattr_t preferred) {
+  void *p;
+
+  chSysLock();
+  p = chCoreAllocPlacedI(size, align, required, preferred);
+  chSysUnlock();
+  return p;
+}
+
+/**
+ * @brief   Allocates a memory block reachable by the DMA.
+ * @details The block is aligned to @p CH_MEMCORE_DMA_ALIGN.
+ * @note    This function is a @p memgetfunc_t and can be used as provider
+ *          for pools of DMA buffers.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, no suitable region.
+ *
+ * @api
+ */
+void *chCoreAllocDMA(size_t size) {
+
+  return chCoreAllocPlaced(size, CH_MEMCORE_DMA_ALIGN, MEM_ATTR_DMA, 0);
+}
+
+/**
+ * @brief   Allocates a memory block preferably from the fastest memory.
+ * @note    This function is a @p memgetfunc_t and can be used as provider
+ *          for pools of thread working areas or hot data.
+ *
+ * @param[in] size      the size of the block to be allocated
+ * @return              A pointer to the allocated memory block.
+ * @retval NULL         allocation failed, core memory exhausted.
+ *
+ * @api
+ */
+void *chCoreAllocFast(size_t size) {
+
+  return chCoreAllocPlaced(size, MEM_ALIGN_SIZE, 0, MEM_ATTR_FAST);
+}
+#endif /* CH_USE_MEMCORE_REGIONS */
 #endif /* CH_USE_MEMCORE */
 
 /** @} */
@@ -175,6 +175,155 @@ void chPoolFree(MemoryPool *mp, void *objp) {
   chSysUnlock();
 }
 
+#if CH_USE_MEMPOOLS_LOCKFREE || defined(__DOXYGEN__)
+/**
+ * @brief   Atomically adds a value to a counter.
+ *
+ * @param[in] p         pointer to the counter
+ * @param[in] n         value to be added
+ * @return              The new counter value.
+ */
+static cnt_t lfadd(volatile cnt_t *p, cnt_t n) {
+  cnt_t cnt;
+
+  do {
+    cnt = *p;
+  } while (!port_atomic_cas(p, cnt, cnt + n));
+  return cnt + n;
+}
+
+/**
+ * @brief   Pushes an object on the tagged list head.
+ *
+ * @param[in] lp        pointer to a @p LockFreePool structure
+ * @param[in] objp      the pointer to the object
+ */
+static void lfpush(LockFreePool *lp, void *objp) {
+  struct pool_header *php = objp;
+  lfpool_head_t o, n;
+
+  n.t.ptr = php;
+  do {
+    o.w = lp->lp_head.w;
+    php->ph_next = o.t.ptr;
+    n.t.tag = o.t.tag + 1;
+    CH_LFPOOL_CAS_HOOK();
+  } while (!port_atomic_cas2(&lp->lp_head.w, o.w, n.w));
+}
+
+/**
+ * @brief   Initializes an empty lock-free memory pool.
+ *
+ * @param[out] lp       pointer to a @p LockFreePool structure
+ * @param[in] size      the size of the objects contained in this memory pool,
+ *                      the minimum accepted size is the size of a pointer to
+ *                      void.
+ *
+ * @init
+ */
+void chLFPoolInit(LockFreePool *lp, size_t size) {
+
+  chDbgCheck((lp != NULL) && (size >= sizeof(void *)), "chLFPoolInit");
+
+  lp->lp_head.t.ptr = NULL;
+  lp->lp_head.t.tag = 0;
+  lp->lp_object_size = size;
+  lp->lp_used = 0;
+  lp->lp_highwater = 0;
+  lp->lp_failures = 0;
+}
+
+/**
+ * @brief   Loads a lock-free memory pool with an array of static objects.
+ * @pre     The memory pool must be already been initialized.
+ * @pre     The array elements must be of the right size for the specified
+ *          memory pool.
+ * @post    The memory pool contains the elements of the input array.
+ * @note    The loaded objects are not accounted as released.
+ *
+ * @param[in] lp        pointer to a @p LockFreePool structure
+ * @param[in] p         pointer to the array first element
+ * @param[in] n         number of elements in the array
+ *
+ * @api
+ */
+void chLFPoolLoadArray(LockFreePool *lp, void *p, size_t n) {
+
+  chDbgCheck((lp != NULL) && (n != 0), "chLFPoolLoadArray");
+
+  while (n) {
+    lfpush(lp, p);
+    p = (void *)(((uint8_t *)p) + lp->lp_object_size);
+    n--;
+  }
+}
+
+/**
+ * @brief   Allocates an object from a lock-free memory pool.
+ * @pre     The memory pool must be already been initialized.
+ * @note    This function does not use the kernel lock and can be called
+ *          from any context, including ISRs and critical zones.
+ *
+ * @param[in] lp        pointer to a @p LockFreePool structure
+ * @return              The pointer to the allocated object.
+ * @retval NULL         if pool is empty.
+ *
+ * @special
+ */
+void *chLFPoolAlloc(LockFreePool *lp) {
+  lfpool_head_t o, n;
+  cnt_t used, hw;
+
+  chDbgCheck(lp != NULL, "chLFPoolAlloc");
+
+  do {
+    o.w = lp->lp_head.w;
+    if (o.t.ptr == NULL) {
+      uint32_t f;
+
+      do {
+        f = lp->lp_failures;
+      } while (!port_atomic_cas(&lp->lp_failures, f, f + 1));
+      return NULL;
+    }
+    /* The object could be already allocated by someone else and its
+       content overwritten, in that case the tag has changed and the
+       swap fails.*/
+    n.t.ptr = o.t.ptr->ph_next;
+    n.t.tag = o.t.tag + 1;
+    CH_LFPOOL_CAS_HOOK();
+  } while (!port_atomic_cas2(&lp->lp_head.w, o.w, n.w));
+
+  used = lfadd(&lp->lp_used, 1);
+  do {
+    hw = lp->lp_highwater;
+  } while ((used > hw) && !port_atomic_cas(&lp->lp_highwater, hw, used));
+  return (void *)o.t.ptr;
+}
+
+/**
+ * @brief   Releases an object into a lock-free memory pool.
+ * @pre     The memory pool must be already been initialized.
+ * @pre     The freed object must be of the right size for the specified
+ *          memory pool.
+ * @pre     The object must be properly aligned to contain a pointer to void.
+ * @note    This function does not use the kernel lock and can be called
+ *          from any context, including ISRs and critical zones.
+ *
+ * @param[in] lp        pointer to a @p LockFreePool structure
+ * @param[in] objp      the pointer to the object to be released
+ *
+ * @special
+ */
+void chLFPoolFree(LockFreePool *lp, void *objp) {
+
+  chDbgCheck((lp != NULL) && (objp != NULL), "chLFPoolFree");
+
+  lfpush(lp, objp);
+  (void)lfadd(&lp->lp_used, -1);
+}
+#endif /* CH_USE_MEMPOOLS_LOCKFREE */
+
 #endif /* CH_USE_MEMPOOLS */
 
 /** @} */
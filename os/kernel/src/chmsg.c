@@ -44,6 +44,10 @@
  *          Messages are usually processed in FIFO order but it is possible to
  *          process them in priority order by enabling the
  *          @p CH_USE_MESSAGES_PRIORITY option in @p chconf.h.<br>
+ *          If the @p CH_USE_MESSAGES_ASYNC option is enabled then the
+ *          asynchronous message ports are also available, the clients post
+ *          requests without blocking and receive the replies through
+ *          futures, the servers fetch the posted requests in batches.<br>
  * @pre     In order to use the message APIs the @p CH_USE_MESSAGES option
  *          must be enabled in @p chconf.h.
  * @post    Enabling messages requires 6-12 (depending on the architecture)
@@ -134,6 +138,229 @@ void chMsgRelease(Thread *tp, msg_t msg) {
   chSysUnlock();
 }
 
+#if CH_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes a @p MsgPort object.
+ *
+ * @param[out] mpp      pointer to a @p MsgPort structure
+ *
+ * @init
+ */
+void chMsgPortInit(MsgPort *mpp) {
+
+  chDbgCheck(mpp != NULL, "chMsgPortInit");
+
+  mpp->mp_head = NULL;
+  mpp->mp_tail = NULL;
+  mpp->mp_server = NULL;
+}
+
+/**
+ * @brief   Posts an asynchronous request to a port.
+ * @details The future is queued on the port and the server, if waiting, is
+ *          made ready. The caller does not block.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] mpp       pointer to a @p MsgPort structure
+ * @param[out] mfp      pointer to the @p MsgFuture structure carrying the
+ *                      request
+ * @param[in] msg       the request message
+ *
+ * @iclass
+ */
+void chMsgPostI(MsgPort *mpp, MsgFuture *mfp, msg_t msg) {
+  Thread *tp;
+
+  chDbgCheckClassI();
+  chDbgCheck((mpp != NULL) && (mfp != NULL), "chMsgPostI");
+
+  mfp->mf_next = NULL;
+  mfp->mf_msg = msg;
+  mfp->mf_waiter = NULL;
+  mfp->mf_state = MSG_FUTURE_PENDING;
+  if (mpp->mp_head == NULL)
+    mpp->mp_head = mfp;
+  else
+    mpp->mp_tail->mf_next = mfp;
+  mpp->mp_tail = mfp;
+
+  /* The server could have already been awakened by a timeout.*/
+  if (((tp = mpp->mp_server) != NULL) && (tp->p_state == THD_STATE_WTMSG)) {
+    mpp->mp_server = NULL;
+    tp->p_u.rdymsg = RDY_OK;
+    chSchReadyI(tp);
+  }
+}
+
+/**
+ * @brief   Posts an asynchronous request to a port.
+ * @details The future is queued on the port and the server, if waiting, is
+ *          made ready. The caller does not wait for the reply, the future
+ *          can be polled or waited later.
+ *
+ * @param[in] mpp       pointer to a @p MsgPort structure
+ * @param[out] mfp      pointer to the @p MsgFuture structure carrying the
+ *                      request
+ * @param[in] msg       the request message
+ *
+ * @api
+ */
+void chMsgPost(MsgPort *mpp, MsgFuture *mfp, msg_t msg) {
+
+  chSysLock();
+  chMsgPostI(mpp, mfp, msg);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Fetches all the requests posted to a port.
+ * @details The posted futures are removed from the port as a whole and
+ *          returned as a list, the list is walked using
+ *          @p chMsgFutureNext().
+ *
+ * @param[in] mpp       pointer to a @p MsgPort structure
+ * @return              The list of the posted futures in FIFO order.
+ * @retval NULL         if there are no posted requests.
+ *
+ * @iclass
+ */
+MsgFuture *chMsgPortFetchI(MsgPort *mpp) {
+  MsgFuture *mfp;
+
+  chDbgCheckClassI();
+  chDbgCheck(mpp != NULL, "chMsgPortFetchI");
+
+  mfp = mpp->mp_head;
+  mpp->mp_head = NULL;
+  mpp->mp_tail = NULL;
+  return mfp;
+}
+
+/**
+ * @brief   Waits for the requests posted to a port.
+ * @details All the requests posted since the previous fetch are returned
+ *          at once so a server can process them in a batch.
+ * @note    Only one thread at time can wait on a port.
+ *
+ * @param[in] mpp       pointer to a @p MsgPort structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The list of the posted futures in FIFO order.
+ * @retval NULL         if the operation timed out.
+ *
+ * @api
+ */
+MsgFuture *chMsgPortFetchTimeout(MsgPort *mpp, systime_t time) {
+  MsgFuture *mfp;
+
+  chDbgCheck(mpp != NULL, "chMsgPortFetchTimeout");
+
+  chSysLock();
+  chDbgAssert(mpp->mp_server == NULL,
+              "chMsgPortFetchTimeout(), #1", "port already waited");
+  if ((mpp->mp_head == NULL) && (time != TIME_IMMEDIATE)) {
+    mpp->mp_server = currp;
+    chSchGoSleepTimeoutS(THD_STATE_WTMSG, time);
+    mpp->mp_server = NULL;
+  }
+  mfp = chMsgPortFetchI(mpp);
+  chSysUnlock();
+  return mfp;
+}
+
+/**
+ * @brief   Completes a future with a reply.
+ * @details The client waiting on the future, if any, is made ready.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. A server
+ *          can complete a whole batch and reschedule once.
+ *
+ * @param[in] mfp       pointer to a @p MsgFuture structure
+ * @param[in] reply     the reply message
+ *
+ * @iclass
+ */
+void chMsgCompleteI(MsgFuture *mfp, msg_t reply) {
+  Thread *tp;
+
+  chDbgCheckClassI();
+  chDbgCheck(mfp != NULL, "chMsgCompleteI");
+  chDbgAssert(mfp->mf_state == MSG_FUTURE_PENDING,
+              "chMsgCompleteI(), #1", "not pending");
+
+  mfp->mf_reply = reply;
+  mfp->mf_state = MSG_FUTURE_DONE;
+  if (((tp = mfp->mf_waiter) != NULL) &&
+      (tp->p_state == THD_STATE_SUSPENDED)) {
+    mfp->mf_waiter = NULL;
+    tp->p_u.rdymsg = RDY_OK;
+    chSchReadyI(tp);
+  }
+}
+
+/**
+ * @brief   Completes a future with a reply.
+ * @details The client waiting on the future, if any, is awakened.
+ *
+ * @param[in] mfp       pointer to a @p MsgFuture structure
+ * @param[in] reply     the reply message
+ *
+ * @api
+ */
+void chMsgComplete(MsgFuture *mfp, msg_t reply) {
+
+  chSysLock();
+  chMsgCompleteI(mfp, reply);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Waits for the completion of a future.
+ * @note    Only one thread at time can wait on a future.
+ *
+ * @param[in] mfp       pointer to a @p MsgFuture structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The reply message.
+ * @retval RDY_TIMEOUT  if the future has not been completed within the
+ *                      specified timeout, the request is still pending
+ *                      and the future can be waited again.
+ *
+ * @api
+ */
+msg_t chMsgFutureWaitTimeout(MsgFuture *mfp, systime_t time) {
+  msg_t msg;
+
+  chDbgCheck(mfp != NULL, "chMsgFutureWaitTimeout");
+
+  chSysLock();
+  if (mfp->mf_state != MSG_FUTURE_DONE) {
+    if (time == TIME_IMMEDIATE) {
+      chSysUnlock();
+      return RDY_TIMEOUT;
+    }
+    mfp->mf_waiter = currp;
+    if (chSchGoSleepTimeoutS(THD_STATE_SUSPENDED, time) != RDY_OK) {
+      mfp->mf_waiter = NULL;
+      chSysUnlock();
+      return RDY_TIMEOUT;
+    }
+  }
+  msg = mfp->mf_reply;
+  chSysUnlock();
+  return msg;
+}
+#endif /* CH_USE_MESSAGES_ASYNC */
+
 #endif /* CH_USE_MESSAGES */
 
 /** @} */
@@ -65,6 +65,18 @@
  *          The mechanism works with any number of nested mutexes and any
  *          number of involved threads. The algorithm complexity (worst case)
  *          is N with N equal to the number of nested mutexes.
+ *
+ *          <h2>Priority ceiling</h2>
+ *          When the @p CH_USE_MUTEXES_CEILING option is enabled a mutex can
+ *          be initialized with a static ceiling priority using
+ *          @p chMtxInitCeiling(). The ceiling must be equal or higher than
+ *          the priority of any thread using the mutex. The locking thread
+ *          is immediately raised to the ceiling priority and restored on
+ *          unlock, the lock operation does not explore the thread-mutex
+ *          dependencies and has constant execution time. A contended lock
+ *          is only possible if the owner sleeps while holding the mutex or
+ *          if a thread at the ceiling priority is preempted by round robin,
+ *          in that case the caller is queued without boosting the owner.
  * @pre     In order to use the mutex APIs the @p CH_USE_MUTEXES option
  *          must be enabled in @p chconf.h.
  * @post    Enabling mutexes requires 5-12 (depending on the architecture)
@@ -76,6 +88,158 @@
 
 #if CH_USE_MUTEXES || defined(__DOXYGEN__)
 
+/**
+ * @brief   Returns the priority the specified thread is entitled to.
+ * @details The priority is the highest among the thread base priority, the
+ *          priorities of the threads waiting on the owned mutexes and the
+ *          ceilings of the owned priority ceiling mutexes.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The thread priority.
+ */
+static tprio_t mtx_owner_prio(Thread *tp) {
+  tprio_t prio = tp->p_realprio;
+  Mutex *mp = tp->p_mtxlist;
+
+  while (mp != NULL) {
+    /* If the highest priority thread waiting in the mutexes list has a
+       greater priority than the current thread base priority then the final
+       priority will have at least that priority.*/
+    if (chMtxQueueNotEmptyS(mp) && (mp->m_queue.p_next->p_prio > prio))
+      prio = mp->m_queue.p_next->p_prio;
+#if CH_USE_MUTEXES_CEILING
+    if (mp->m_ceiling > prio)
+      prio = mp->m_ceiling;
+#endif
+    mp = mp->m_next;
+  }
+  return prio;
+}
+
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+/**
+ * @brief   Adaptive wait on an owned mutex.
+ * @details The running thread yields to the ready threads with equal or
+ *          higher priority until the mutex is released or the iterations
+ *          limit is reached. Spinning is not performed because a mutex
+ *          cannot be released from an ISR.
+ *
+ * @param[in] mp        pointer to a @p Mutex structure
+ */
+static void mtx_adaptive_wait(Mutex *mp) {
+  cnt_t n = mp->m_aw.aw_limit;
+
+  while ((mp->m_owner != NULL) && (n-- > 0) && chSchAdaptiveStepS(FALSE))
+    ;
+  if (mp->m_owner == NULL)
+    mp->m_aw.aw_hits++;
+  else
+    mp->m_aw.aw_misses++;
+}
+#endif /* CH_USE_ADAPTIVE_WAIT */
+
+/**
+ * @brief   Boosts the owner of a mutex to the priority of the running
+ *          thread.
+ * @details Priority inheritance protocol; explores the thread-mutex
+ *          dependencies boosting the priority of all the affected threads to
+ *          equal the priority of the running thread requesting the mutex.
+ * @pre     The mutex must be owned.
+ *
+ * @param[in] mp        pointer to the @p Mutex structure
+ *
+ * @notapi
+ */
+void _mtx_prio_boost(Mutex *mp) {
+  Thread *ctp = currp;
+  Thread *tp = mp->m_owner;
+
+  /* Does the running thread have higher priority than the mutex
+     owning thread? */
+  while (tp->p_prio < ctp->p_prio) {
+    if (tp->p_state == THD_STATE_READY) {
+      /* Re-enqueues tp with its new priority on the ready list, it is
+         removed before changing the priority because the ready list
+         can be indexed by priority.*/
+      chSchRemoveI(tp);
+      tp->p_prio = ctp->p_prio;
+      dbg_trace_event(CH_TRACE_TYPE_MTX_BOOST, tp, mp);
+#if CH_DBG_ENABLE_ASSERTS
+      /* Prevents an assertion in chSchReadyI().*/
+      tp->p_state = THD_STATE_CURRENT;
+#endif
+      chSchReadyI(tp);
+      break;
+    }
+    /* Make priority of thread tp match the running thread's priority.*/
+    tp->p_prio = ctp->p_prio;
+    dbg_trace_event(CH_TRACE_TYPE_MTX_BOOST, tp, mp);
+    /* The following states need priority queues reordering.*/
+    switch (tp->p_state) {
+    case THD_STATE_WTMTX:
+#if CH_USE_RWLOCKS
+    case THD_STATE_WTRDLOCK:
+    case THD_STATE_WTWRLOCK:
+      /* A readers-writer lock starts with its writer ownership mutex, the
+         waiting threads are queued on it and a lock with waiting threads
+         always has a writer owner.*/
+#endif
+      /* Re-enqueues the mutex owner with its new priority.*/
+      prio_insert(dequeue(tp), (ThreadsQueue *)tp->p_u.wtobjp);
+      tp = ((Mutex *)tp->p_u.wtobjp)->m_owner;
+      continue;
+#if CH_USE_CONDVARS |                                                       \
+    (CH_USE_SEMAPHORES && CH_USE_SEMAPHORES_PRIORITY) |                     \
+    (CH_USE_MESSAGES && CH_USE_MESSAGES_PRIORITY)
+#if CH_USE_CONDVARS
+    case THD_STATE_WTCOND:
+#endif
+#if CH_USE_SEMAPHORES && CH_USE_SEMAPHORES_PRIORITY
+    case THD_STATE_WTSEM:
+#endif
+#if CH_USE_MESSAGES && CH_USE_MESSAGES_PRIORITY
+    case THD_STATE_SNDMSGQ:
+#endif
+      /* Re-enqueues tp with its new priority on the queue.*/
+      prio_insert(dequeue(tp), (ThreadsQueue *)tp->p_u.wtobjp);
+      break;
+#endif
+    }
+    break;
+  }
+}
+
+/**
+ * @brief   Restores the priority of a mutexes owner.
+ * @details The priority is recalculated from the owned mutexes list, this
+ *          is required when a thread leaves a mutex queue without acquiring
+ *          the mutex, the owner could have been boosted by that thread.
+ * @note    Only the direct owner is lowered, the threads it is in turn
+ *          waiting on keep their priority until they release their
+ *          mutexes.
+ *
+ * @param[in] tp        pointer to the thread
+ *
+ * @notapi
+ */
+void _mtx_prio_restore(Thread *tp) {
+  tprio_t prio = mtx_owner_prio(tp);
+
+  if (prio == tp->p_prio)
+    return;
+  if (tp->p_state == THD_STATE_READY) {
+    chSchRemoveI(tp);
+    tp->p_prio = prio;
+#if CH_DBG_ENABLE_ASSERTS
+    /* Prevents an assertion in chSchReadyI().*/
+    tp->p_state = THD_STATE_CURRENT;
+#endif
+    chSchReadyI(tp);
+  }
+  else
+    tp->p_prio = prio;
+}
+
 /**
  * @brief   Initializes s @p Mutex structure.
  *
@@ -89,8 +253,44 @@ void chMtxInit(Mutex *mp) {
 
   queue_init(&mp->m_queue);
   mp->m_owner = NULL;
+#if CH_USE_MUTEXES_CEILING
+  mp->m_ceiling = 0;
+#endif
+#if CH_USE_ADAPTIVE_WAIT
+  mp->m_aw.aw_limit = 0;
+  mp->m_aw.aw_hits = 0;
+  mp->m_aw.aw_misses = 0;
+#endif
 }
 
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+/**
+ * @brief   Initializes a @p Mutex structure as a priority ceiling mutex.
+ * @pre     This function is only available when the
+ *          @p CH_USE_MUTEXES_CEILING configuration option is enabled.
+ *
+ * @param[out] mp       pointer to a @p Mutex structure
+ * @param[in] ceiling   the ceiling priority, it must be equal or higher than
+ *                      the priority of any thread locking the mutex
+ *
+ * @init
+ */
+void chMtxInitCeiling(Mutex *mp, tprio_t ceiling) {
+
+  chDbgCheck((mp != NULL) && (ceiling >= LOWPRIO) && (ceiling <= HIGHPRIO),
+             "chMtxInitCeiling");
+
+  queue_init(&mp->m_queue);
+  mp->m_owner = NULL;
+  mp->m_ceiling = ceiling;
+#if CH_USE_ADAPTIVE_WAIT
+  mp->m_aw.aw_limit = 0;
+  mp->m_aw.aw_hits = 0;
+  mp->m_aw.aw_misses = 0;
+#endif
+}
+#endif /* CH_USE_MUTEXES_CEILING */
+
 /**
  * @brief   Locks the specified mutex.
  * @post    The mutex is locked and inserted in the per-thread stack of owned
@@ -124,51 +324,38 @@ void chMtxLockS(Mutex *mp) {
   chDbgCheckClassS();
   chDbgCheck(mp != NULL, "chMtxLockS");
 
-  /* Is the mutex already locked? */
-  if (mp->m_owner != NULL) {
-    /* Priority inheritance protocol; explores the thread-mutex dependencies
-       boosting the priority of all the affected threads to equal the priority
-       of the running thread requesting the mutex.*/
-    Thread *tp = mp->m_owner;
-    /* Does the running thread have higher priority than the mutex
-       owning thread? */
-    while (tp->p_prio < ctp->p_prio) {
-      /* Make priority of thread tp match the running thread's priority.*/
-      tp->p_prio = ctp->p_prio;
-      /* The following states need priority queues reordering.*/
-      switch (tp->p_state) {
-      case THD_STATE_WTMTX:
-        /* Re-enqueues the mutex owner with its new priority.*/
-        prio_insert(dequeue(tp), (ThreadsQueue *)tp->p_u.wtobjp);
-        tp = ((Mutex *)tp->p_u.wtobjp)->m_owner;
-        continue;
-#if CH_USE_CONDVARS |                                                       \
-    (CH_USE_SEMAPHORES && CH_USE_SEMAPHORES_PRIORITY) |                     \
-    (CH_USE_MESSAGES && CH_USE_MESSAGES_PRIORITY)
-#if CH_USE_CONDVARS
-      case THD_STATE_WTCOND:
-#endif
-#if CH_USE_SEMAPHORES && CH_USE_SEMAPHORES_PRIORITY
-      case THD_STATE_WTSEM:
-#endif
-#if CH_USE_MESSAGES && CH_USE_MESSAGES_PRIORITY
-      case THD_STATE_SNDMSGQ:
+  dbg_trace_event(CH_TRACE_TYPE_MTX_LOCK, ctp, mp);
+#if CH_USE_ADAPTIVE_WAIT
+  if ((mp->m_owner != NULL) && (mp->m_aw.aw_limit > 0))
+    mtx_adaptive_wait(mp);
 #endif
-        /* Re-enqueues tp with its new priority on the queue.*/
-        prio_insert(dequeue(tp), (ThreadsQueue *)tp->p_u.wtobjp);
-        break;
-#endif
-      case THD_STATE_READY:
-#if CH_DBG_ENABLE_ASSERTS
-        /* Prevents an assertion in chSchReadyI().*/
-        tp->p_state = THD_STATE_CURRENT;
-#endif
-        /* Re-enqueues tp with its new priority on the ready list.*/
-        chSchReadyI(dequeue(tp));
-        break;
-      }
-      break;
+#if CH_USE_MUTEXES_CEILING
+  if (mp->m_ceiling > 0) {
+    chDbgAssert(ctp->p_realprio <= mp->m_ceiling,
+                "chMtxLockS(), #3", "ceiling violation");
+    if (mp->m_owner != NULL) {
+      /* The owner is not boosted, the running thread is queued and made
+         owner by the unlocking thread.*/
+      prio_insert(ctp, &mp->m_queue);
+      ctp->p_u.wtobjp = mp;
+      chSchGoSleepS(THD_STATE_WTMTX);
+      chDbgAssert(mp->m_owner == ctp, "chMtxLockS(), #4", "not owner");
+      chDbgAssert(ctp->p_mtxlist == mp, "chMtxLockS(), #5", "not owned");
+    }
+    else {
+      /* Immediate raise to the ceiling priority.*/
+      mp->m_owner = ctp;
+      mp->m_next = ctp->p_mtxlist;
+      ctp->p_mtxlist = mp;
+      if (ctp->p_prio < mp->m_ceiling)
+        ctp->p_prio = mp->m_ceiling;
     }
+    return;
+  }
+#endif
+  /* Is the mutex already locked? */
+  if (mp->m_owner != NULL) {
+    _mtx_prio_boost(mp);
     /* Sleep on the mutex.*/
     prio_insert(ctp, &mp->m_queue);
     ctp->p_u.wtobjp = mp;
@@ -238,9 +425,16 @@ bool_t chMtxTryLockS(Mutex *mp) {
 
   if (mp->m_owner != NULL)
     return FALSE;
+  dbg_trace_event(CH_TRACE_TYPE_MTX_LOCK, currp, mp);
   mp->m_owner = currp;
   mp->m_next = currp->p_mtxlist;
   currp->p_mtxlist = mp;
+#if CH_USE_MUTEXES_CEILING
+  chDbgAssert((mp->m_ceiling == 0) || (currp->p_realprio <= mp->m_ceiling),
+              "chMtxTryLockS(), #1", "ceiling violation");
+  if (currp->p_prio < mp->m_ceiling)
+    currp->p_prio = mp->m_ceiling;
+#endif
   return TRUE;
 }
 
@@ -256,7 +450,7 @@ bool_t chMtxTryLockS(Mutex *mp) {
  */
 Mutex *chMtxUnlock(void) {
   Thread *ctp = currp;
-  Mutex *ump, *mp;
+  Mutex *ump;
 
   chSysLock();
   chDbgAssert(ctp->p_mtxlist != NULL,
@@ -269,35 +463,37 @@ Mutex *chMtxUnlock(void) {
      as not owned.*/
   ump = ctp->p_mtxlist;
   ctp->p_mtxlist = ump->m_next;
+  dbg_trace_event(CH_TRACE_TYPE_MTX_UNLOCK, ctp, ump);
   /* If a thread is waiting on the mutex then the fun part begins.*/
   if (chMtxQueueNotEmptyS(ump)) {
     Thread *tp;
 
     /* Recalculates the optimal thread priority by scanning the owned
        mutexes list.*/
-    tprio_t newprio = ctp->p_realprio;
-    mp = ctp->p_mtxlist;
-    while (mp != NULL) {
-      /* If the highest priority thread waiting in the mutexes list has a
-         greater priority than the current thread base priority then the final
-         priority will have at least that priority.*/
-      if (chMtxQueueNotEmptyS(mp) && (mp->m_queue.p_next->p_prio > newprio))
-        newprio = mp->m_queue.p_next->p_prio;
-      mp = mp->m_next;
-    }
-    /* Assigns to the current thread the highest priority among all the
-       waiting threads.*/
-    ctp->p_prio = newprio;
+    ctp->p_prio = mtx_owner_prio(ctp);
     /* Awakens the highest priority thread waiting for the unlocked mutex and
        assigns the mutex to it.*/
     tp = fifo_remove(&ump->m_queue);
     ump->m_owner = tp;
     ump->m_next = tp->p_mtxlist;
     tp->p_mtxlist = ump;
+#if CH_USE_MUTEXES_CEILING
+    /* The new owner is raised to the ceiling priority.*/
+    if (tp->p_prio < ump->m_ceiling)
+      tp->p_prio = ump->m_ceiling;
+#endif
     chSchWakeupS(tp, RDY_OK);
   }
-  else
+  else {
     ump->m_owner = NULL;
+#if CH_USE_MUTEXES_CEILING
+    /* Leaving a ceiling, the thread priority is restored.*/
+    if (ump->m_ceiling > 0) {
+      ctp->p_prio = mtx_owner_prio(ctp);
+      chSchRescheduleS();
+    }
+#endif
+  }
   chSysUnlock();
   return ump;
 }
@@ -316,7 +512,7 @@ Mutex *chMtxUnlock(void) {
  */
 Mutex *chMtxUnlockS(void) {
   Thread *ctp = currp;
-  Mutex *ump, *mp;
+  Mutex *ump;
 
   chDbgCheckClassS();
   chDbgAssert(ctp->p_mtxlist != NULL,
@@ -330,33 +526,35 @@ Mutex *chMtxUnlockS(void) {
      owned.*/
   ump = ctp->p_mtxlist;
   ctp->p_mtxlist = ump->m_next;
+  dbg_trace_event(CH_TRACE_TYPE_MTX_UNLOCK, ctp, ump);
   /* If a thread is waiting on the mutex then the fun part begins.*/
   if (chMtxQueueNotEmptyS(ump)) {
     Thread *tp;
 
     /* Recalculates the optimal thread priority by scanning the owned
        mutexes list.*/
-    tprio_t newprio = ctp->p_realprio;
-    mp = ctp->p_mtxlist;
-    while (mp != NULL) {
-      /* If the highest priority thread waiting in the mutexes list has a
-         greater priority than the current thread base priority then the final
-         priority will have at least that priority.*/
-      if (chMtxQueueNotEmptyS(mp) && (mp->m_queue.p_next->p_prio > newprio))
-        newprio = mp->m_queue.p_next->p_prio;
-      mp = mp->m_next;
-    }
-    ctp->p_prio = newprio;
+    ctp->p_prio = mtx_owner_prio(ctp);
     /* Awakens the highest priority thread waiting for the unlocked mutex and
        assigns the mutex to it.*/
     tp = fifo_remove(&ump->m_queue);
     ump->m_owner = tp;
     ump->m_next = tp->p_mtxlist;
     tp->p_mtxlist = ump;
+#if CH_USE_MUTEXES_CEILING
+    /* The new owner is raised to the ceiling priority.*/
+    if (tp->p_prio < ump->m_ceiling)
+      tp->p_prio = ump->m_ceiling;
+#endif
     chSchReadyI(tp);
   }
-  else
+  else {
     ump->m_owner = NULL;
+#if CH_USE_MUTEXES_CEILING
+    /* Leaving a ceiling, the thread priority is restored.*/
+    if (ump->m_ceiling > 0)
+      ctp->p_prio = mtx_owner_prio(ctp);
+#endif
+  }
   return ump;
 }
 
@@ -368,6 +566,8 @@ Mutex *chMtxUnlockS(void) {
  *          mutexes one by one and not just because the call overhead,
  *          this function does not have any overhead related to the priority
  *          inheritance mechanism.
+ * @note    Readers-writer locks held in exclusive mode are in the owned
+ *          mutexes list, they are released as by @p chRWLockWriteUnlock().
  *
  * @api
  */
@@ -379,11 +579,28 @@ void chMtxUnlockAll(void) {
     do {
       Mutex *ump = ctp->p_mtxlist;
       ctp->p_mtxlist = ump->m_next;
+      dbg_trace_event(CH_TRACE_TYPE_MTX_UNLOCK, ctp, ump);
       if (chMtxQueueNotEmptyS(ump)) {
+#if CH_USE_RWLOCKS
+        /* Handing a readers-writer lock to its next waiter as a plain mutex
+           would bypass the readers accounting, the lock is recognized by
+           the state of its waiting threads and its queue is served by the
+           readers-writer lock code. The mutex is the first field of the
+           lock.*/
+        if ((ump->m_queue.p_next->p_state == THD_STATE_WTRDLOCK) ||
+            (ump->m_queue.p_next->p_state == THD_STATE_WTWRLOCK)) {
+          _rw_release((RWLock *)ump);
+          continue;
+        }
+#endif
         Thread *tp = fifo_remove(&ump->m_queue);
         ump->m_owner = tp;
         ump->m_next = tp->p_mtxlist;
         tp->p_mtxlist = ump;
+#if CH_USE_MUTEXES_CEILING
+        if (tp->p_prio < ump->m_ceiling)
+          tp->p_prio = ump->m_ceiling;
+#endif
         chSchReadyI(tp);
       }
       else
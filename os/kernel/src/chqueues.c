@@ -42,6 +42,12 @@
  *          - <b>Full duplex queue</b>, bidirectional queue. Full duplex queues
  *            are implemented by pairing an input queue and an output queue
  *            together.
+ *          - <b>Input ring</b> and <b>Output ring</b>, lock-free single
+ *            producer, single consumer variants of the input and output
+ *            queues. The data is moved in blocks without entering the kernel
+ *            lock, the lock is only used for sleeping, waking up and invoking
+ *            the notification callbacks. The rings require the
+ *            @p CH_USE_QUEUES_RINGS option.
  *          .
  * @pre     In order to use the I/O queues the @p CH_USE_QUEUES option must
  *          be enabled in @p chconf.h.
@@ -76,6 +82,55 @@ static msg_t qwait(GenericQueue *qp, systime_t time) {
   return chSchGoSleepTimeoutS(THD_STATE_WTQUEUE, time);
 }
 
+/**
+ * @brief   Describes a queue area as a span.
+ *
+ * @param[in] qp        pointer to an @p GenericQueue structure
+ * @param[in] p         pointer to the first byte of the area
+ * @param[in] n         size of the area
+ * @param[out] sp       pointer to the @p QueueSpan structure to be filled
+ * @return              The size of the area.
+ */
+static size_t qspan(GenericQueue *qp, uint8_t *p, size_t n, QueueSpan *sp) {
+  size_t first = (size_t)(qp->q_top - p);
+
+  if (first > n)
+    first = n;
+  sp->qs_ptr[0] = p;
+  sp->qs_size[0] = first;
+  sp->qs_ptr[1] = qp->q_buffer;
+  sp->qs_size[1] = n - first;
+  return n;
+}
+
+/**
+ * @brief   Advances a queue pointer wrapping around the buffer end.
+ *
+ * @param[in] qp        pointer to an @p GenericQueue structure
+ * @param[in] p         the pointer to be advanced
+ * @param[in] n         number of bytes
+ * @return              The advanced pointer.
+ */
+static uint8_t *qadvance(GenericQueue *qp, uint8_t *p, size_t n) {
+
+  p += n;
+  if (p >= qp->q_top)
+    p -= chQSizeI(qp);
+  return p;
+}
+
+/**
+ * @brief   Wakes up to @p n threads waiting on a queue.
+ *
+ * @param[in] qp        pointer to an @p GenericQueue structure
+ * @param[in] n         maximum number of threads to be awakened
+ */
+static void qwakeup(GenericQueue *qp, size_t n) {
+
+  while (notempty(&qp->q_waiting) && (n-- > 0))
+    chSchReadyI(fifo_remove(&qp->q_waiting))->p_u.rdymsg = Q_OK;
+}
+
 /**
  * @brief   Initializes an input queue.
  * @details A Semaphore is internally initialized and works as a counter of
@@ -256,6 +311,117 @@ size_t chIQReadTimeout(InputQueue *iqp, uint8_t *bp,
   }
 }
 
+/**
+ * @brief   Returns the free space of an input queue as a span.
+ * @details The low level driver can fill the returned regions in place,
+ *          for example using a DMA, then the data is made available to the
+ *          readers using @p chIQCommitWriteI().
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[out] sp       pointer to the @p QueueSpan structure to be filled
+ * @return              The total size of the span.
+ * @retval 0            if the queue is full.
+ *
+ * @iclass
+ */
+size_t chIQGetWriteSpanI(InputQueue *iqp, QueueSpan *sp) {
+
+  chDbgCheckClassI();
+
+  return qspan(iqp, iqp->q_wrptr, chIQGetEmptyI(iqp), sp);
+}
+
+/**
+ * @brief   Commits data written into an input queue span.
+ * @details The first @p n bytes of the span previously obtained using
+ *          @p chIQGetWriteSpanI() are made available to the readers, up to
+ *          @p n waiting threads are awakened.
+ * @note    The amount is limited to the free space in the queue, this can
+ *          happen if the queue has been reset after obtaining the span.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[in] n         number of bytes written in the span
+ *
+ * @iclass
+ */
+void chIQCommitWriteI(InputQueue *iqp, size_t n) {
+
+  chDbgCheckClassI();
+
+  if (n > chIQGetEmptyI(iqp))
+    n = chIQGetEmptyI(iqp);
+  iqp->q_counter += n;
+  iqp->q_wrptr = qadvance(iqp, iqp->q_wrptr, n);
+  qwakeup(iqp, n);
+}
+
+/**
+ * @brief   Returns the data in an input queue as a span.
+ * @details If the queue is empty then the calling thread is suspended until
+ *          some data arrives in the queue or a timeout occurs. The returned
+ *          regions can be parsed in place, then the data is removed from
+ *          the queue using @p chIQCommitRead().
+ * @note    The span remains valid until the commit only if the calling
+ *          thread is the only reader of the queue.
+ * @note    The callback is invoked before entering the state
+ *          @p THD_STATE_WTQUEUE.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[out] sp       pointer to the @p QueueSpan structure to be filled
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The total size of the span.
+ * @retval 0            if the specified time expired or the queue has
+ *                      been reset.
+ *
+ * @api
+ */
+size_t chIQGetReadSpanTimeout(InputQueue *iqp, QueueSpan *sp,
+                              systime_t time) {
+  size_t n;
+
+  chSysLock();
+  while (chIQIsEmptyI(iqp)) {
+    if (iqp->q_notify)
+      iqp->q_notify(iqp);
+    if (qwait((GenericQueue *)iqp, time) != Q_OK) {
+      chSysUnlock();
+      return 0;
+    }
+  }
+  n = qspan(iqp, iqp->q_rdptr, chIQGetFullI(iqp), sp);
+  chSysUnlock();
+  return n;
+}
+
+/**
+ * @brief   Removes data read from an input queue span.
+ * @details The first @p n bytes of the span previously obtained using
+ *          @p chIQGetReadSpanTimeout() are removed from the queue.
+ * @note    The amount is limited to the data in the queue, this can
+ *          happen if the queue has been reset after obtaining the span.
+ * @note    The callback is invoked after removing the data.
+ *
+ * @param[in] iqp       pointer to an @p InputQueue structure
+ * @param[in] n         number of bytes consumed from the span
+ *
+ * @api
+ */
+void chIQCommitRead(InputQueue *iqp, size_t n) {
+
+  chSysLock();
+  if (n > chIQGetFullI(iqp))
+    n = chIQGetFullI(iqp);
+  iqp->q_counter -= n;
+  iqp->q_rdptr = qadvance(iqp, iqp->q_rdptr, n);
+  if (iqp->q_notify)
+    iqp->q_notify(iqp);
+  chSysUnlock();
+}
+
 /**
  * @brief   Initializes an output queue.
  * @details A Semaphore is internally initialized and works as a counter of
@@ -433,6 +599,639 @@ size_t chOQWriteTimeout(OutputQueue *oqp, const uint8_t *bp,
     chSysLock();
   }
 }
+
+/**
+ * @brief   Returns the free space of an output queue as a span.
+ * @details If the queue is full then the calling thread is suspended until
+ *          there is space in the queue or a timeout occurs. The returned
+ *          regions can be filled in place, then the data is queued using
+ *          @p chOQCommitWrite().
+ * @note    The span remains valid until the commit only if the calling
+ *          thread is the only writer of the queue.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[out] sp       pointer to the @p QueueSpan structure to be filled
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The total size of the span.
+ * @retval 0            if the specified time expired or the queue has
+ *                      been reset.
+ *
+ * @api
+ */
+size_t chOQGetWriteSpanTimeout(OutputQueue *oqp, QueueSpan *sp,
+                               systime_t time) {
+  size_t n;
+
+  chSysLock();
+  while (chOQIsFullI(oqp)) {
+    if (qwait((GenericQueue *)oqp, time) != Q_OK) {
+      chSysUnlock();
+      return 0;
+    }
+  }
+  n = qspan(oqp, oqp->q_wrptr, chOQGetEmptyI(oqp), sp);
+  chSysUnlock();
+  return n;
+}
+
+/**
+ * @brief   Commits data written into an output queue span.
+ * @details The first @p n bytes of the span previously obtained using
+ *          @p chOQGetWriteSpanTimeout() are queued for output.
+ * @note    The amount is limited to the free space in the queue, this can
+ *          happen if the queue has been reset after obtaining the span.
+ * @note    The callback is invoked once after queuing the data.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[in] n         number of bytes written in the span
+ *
+ * @api
+ */
+void chOQCommitWrite(OutputQueue *oqp, size_t n) {
+
+  chSysLock();
+  if (n > chOQGetEmptyI(oqp))
+    n = chOQGetEmptyI(oqp);
+  oqp->q_counter -= n;
+  oqp->q_wrptr = qadvance(oqp, oqp->q_wrptr, n);
+  if (oqp->q_notify)
+    oqp->q_notify(oqp);
+  chSysUnlock();
+}
+
+/**
+ * @brief   Returns the data in an output queue as a span.
+ * @details The low level driver can transmit the returned regions in
+ *          place, for example using a DMA, then the data is removed from
+ *          the queue using @p chOQCommitReadI().
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[out] sp       pointer to the @p QueueSpan structure to be filled
+ * @return              The total size of the span.
+ * @retval 0            if the queue is empty.
+ *
+ * @iclass
+ */
+size_t chOQGetReadSpanI(OutputQueue *oqp, QueueSpan *sp) {
+
+  chDbgCheckClassI();
+
+  return qspan(oqp, oqp->q_rdptr, chOQGetFullI(oqp), sp);
+}
+
+/**
+ * @brief   Removes data read from an output queue span.
+ * @details The first @p n bytes of the span previously obtained using
+ *          @p chOQGetReadSpanI() are removed from the queue, up to @p n
+ *          waiting threads are awakened.
+ * @note    The amount is limited to the data in the queue, this can
+ *          happen if the queue has been reset after obtaining the span.
+ *
+ * @param[in] oqp       pointer to an @p OutputQueue structure
+ * @param[in] n         number of bytes consumed from the span
+ *
+ * @iclass
+ */
+void chOQCommitReadI(OutputQueue *oqp, size_t n) {
+
+  chDbgCheckClassI();
+
+  if (n > chOQGetFullI(oqp))
+    n = chOQGetFullI(oqp);
+  oqp->q_counter += n;
+  oqp->q_rdptr = qadvance(oqp, oqp->q_rdptr, n);
+  qwakeup(oqp, n);
+}
+
+#if CH_USE_QUEUES_RINGS || defined(__DOXYGEN__)
+/**
+ * @brief   Compiler barrier between the ring buffer and indexes accesses.
+ * @note    The producer and the consumer run on the same core so a compiler
+ *          barrier is sufficient.
+ */
+#if defined(__GNUC__) || defined(__DOXYGEN__)
+#define ring_barrier() asm volatile ("" : : : "memory")
+#else
+#define ring_barrier()
+#endif
+
+/**
+ * @brief   Puts the invoking thread into the ring's threads queue.
+ *
+ * @param[out] rp       pointer to a @p ByteRing structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A message specifying how the invoking thread has been
+ *                      released from threads queue.
+ * @retval Q_OK         is the normal exit, thread signaled.
+ * @retval Q_RESET      if the ring has been reset.
+ * @retval Q_TIMEOUT    if the ring operation timed out.
+ */
+static msg_t rwait(ByteRing *rp, systime_t time) {
+
+  if (TIME_IMMEDIATE == time)
+    return Q_TIMEOUT;
+  currp->p_u.wtobjp = rp;
+  queue_insert(currp, &rp->r_waiting);
+  return chSchGoSleepTimeoutS(THD_STATE_WTQUEUE, time);
+}
+
+/**
+ * @brief   Wakes up the thread waiting on a ring, if any.
+ *
+ * @param[in] rp        pointer to a @p ByteRing structure
+ * @param[in] msg       the wakeup message
+ */
+static void rwakeup(ByteRing *rp, msg_t msg) {
+
+  while (notempty(&rp->r_waiting))
+    chSchReadyI(fifo_remove(&rp->r_waiting))->p_u.rdymsg = msg;
+}
+
+/**
+ * @brief   Copies data into the ring buffer starting from an index.
+ */
+static void rcopyin(ByteRing *rp, size_t i, const uint8_t *bp, size_t n) {
+
+  while (n--)
+    rp->r_buffer[i++ & rp->r_mask] = *bp++;
+}
+
+/**
+ * @brief   Copies data from the ring buffer starting from an index.
+ */
+static void rcopyout(ByteRing *rp, size_t i, uint8_t *bp, size_t n) {
+
+  while (n--)
+    *bp++ = rp->r_buffer[i++ & rp->r_mask];
+}
+
+/**
+ * @brief   Invokes the ring notification callback, if any.
+ */
+static void rnotify(ByteRing *rp) {
+
+  if (rp->r_notify) {
+    chSysLock();
+    rp->r_notify(rp);
+    chSysUnlock();
+  }
+}
+
+/**
+ * @brief   Initializes an input ring.
+ * @note    The callback is invoked from within the S-Locked system state,
+ *          see @ref system_states.
+ *
+ * @param[out] irp      pointer to an @p InputRing structure
+ * @param[in] bp        pointer to a memory area allocated as ring buffer
+ * @param[in] size      size of the ring buffer, must be a power of two
+ * @param[in] infy      pointer to a callback function that is invoked when
+ *                      data is read from the ring. The value can be @p NULL.
+ * @param[in] link      application defined pointer
+ *
+ * @init
+ */
+void chIRInit(InputRing *irp, uint8_t *bp, size_t size, rnotify_t infy,
+              void *link) {
+
+  chDbgCheck((bp != NULL) && (size > 0) && ((size & (size - 1)) == 0),
+             "chIRInit");
+
+  irp->r_head = irp->r_tail = 0;
+  queue_init(&irp->r_waiting);
+  irp->r_buffer = bp;
+  irp->r_mask = size - 1;
+  irp->r_notify = infy;
+  irp->r_link = link;
+}
+
+/**
+ * @brief   Resets an input ring.
+ * @details All the data in the input ring is erased and lost, the waiting
+ *          thread, if any, is resumed with status @p Q_RESET.
+ * @pre     The reading thread must not be in the middle of a transfer, the
+ *          reset is meant to be performed while stopping the driver.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure
+ *
+ * @iclass
+ */
+void chIRResetI(InputRing *irp) {
+
+  chDbgCheckClassI();
+
+  irp->r_head = irp->r_tail;
+  rwakeup(irp, Q_RESET);
+}
+
+/**
+ * @brief   Input ring write.
+ * @details A byte value is written into the low end of an input ring.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure
+ * @param[in] b         the byte value to be written in the ring
+ * @return              The operation status.
+ * @retval Q_OK         if the operation has been completed with success.
+ * @retval Q_FULL       if the ring is full and the operation cannot be
+ *                      completed.
+ *
+ * @iclass
+ */
+msg_t chIRPutI(InputRing *irp, uint8_t b) {
+  size_t head = irp->r_head;
+
+  chDbgCheckClassI();
+
+  if (head - irp->r_tail > irp->r_mask)
+    return Q_FULL;
+
+  irp->r_buffer[head & irp->r_mask] = b;
+  ring_barrier();
+  irp->r_head = head + 1;
+
+  /* The reader can only be waiting if the ring was empty.*/
+  if (head == irp->r_tail)
+    rwakeup(irp, Q_OK);
+
+  return Q_OK;
+}
+
+/**
+ * @brief   Input ring bulk write.
+ * @details The function writes as much data as possible from a buffer into
+ *          the low end of an input ring, the reader is awakened once.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure
+ * @param[in] bp        pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred
+ * @return              The number of bytes effectively transferred.
+ * @retval 0            if the ring is full.
+ *
+ * @iclass
+ */
+size_t chIRWriteI(InputRing *irp, const uint8_t *bp, size_t n) {
+  size_t head = irp->r_head;
+  size_t tail = irp->r_tail;
+
+  chDbgCheckClassI();
+
+  if (n > chRSizeI(irp) - (head - tail))
+    n = chRSizeI(irp) - (head - tail);
+  if (n == 0)
+    return 0;
+
+  rcopyin(irp, head, bp, n);
+  ring_barrier();
+  irp->r_head = head + n;
+
+  if (head == tail)
+    rwakeup(irp, Q_OK);
+
+  return n;
+}
+
+/**
+ * @brief   Input ring read with timeout.
+ * @details This function reads a byte value from an input ring. If the ring
+ *          is empty then the calling thread is suspended until a byte arrives
+ *          in the ring or a timeout occurs.
+ * @note    The callback is invoked after reading the byte from the buffer
+ *          or before entering the state @p THD_STATE_WTQUEUE.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              A byte value from the ring.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the ring has been reset.
+ *
+ * @api
+ */
+msg_t chIRGetTimeout(InputRing *irp, systime_t time) {
+  size_t tail = irp->r_tail;
+  uint8_t b;
+
+  if (irp->r_head == tail) {
+    chSysLock();
+    if (irp->r_notify)
+      irp->r_notify(irp);
+
+    while (irp->r_head == irp->r_tail) {
+      msg_t msg;
+
+      if ((msg = rwait(irp, time)) < Q_OK) {
+        chSysUnlock();
+        return msg;
+      }
+    }
+    chSysUnlock();
+    tail = irp->r_tail;
+  }
+
+  ring_barrier();
+  b = irp->r_buffer[tail & irp->r_mask];
+  ring_barrier();
+  irp->r_tail = tail + 1;
+
+  rnotify(irp);
+  return b;
+}
+
+/**
+ * @brief   Input ring read with timeout.
+ * @details The function reads data from an input ring into a buffer. The
+ *          operation completes when the specified amount of data has been
+ *          transferred or after the specified timeout or if the ring has
+ *          been reset.<br>
+ *          All the data available in the ring is moved at once without
+ *          entering the kernel lock.
+ * @note    The callback is invoked after each block of data moved from the
+ *          buffer or before entering the state @p THD_STATE_WTQUEUE.
+ *
+ * @param[in] irp       pointer to an @p InputRing structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred, the
+ *                      value 0 is reserved
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of bytes effectively transferred.
+ *
+ * @api
+ */
+size_t chIRReadTimeout(InputRing *irp, uint8_t *bp,
+                       size_t n, systime_t time) {
+  size_t r = 0;
+
+  chDbgCheck(n > 0, "chIRReadTimeout");
+
+  while (TRUE) {
+    size_t tail = irp->r_tail;
+    size_t m = irp->r_head - tail;
+
+    if (m == 0) {
+      chSysLock();
+      if (irp->r_notify)
+        irp->r_notify(irp);
+      while (irp->r_head == irp->r_tail) {
+        if (rwait(irp, time) != Q_OK) {
+          chSysUnlock();
+          return r;
+        }
+      }
+      chSysUnlock();
+      continue;
+    }
+
+    if (m > n - r)
+      m = n - r;
+    ring_barrier();
+    rcopyout(irp, tail, bp, m);
+    ring_barrier();
+    irp->r_tail = tail + m;
+    bp += m;
+    r += m;
+
+    rnotify(irp);
+    if (r == n)
+      return r;
+  }
+}
+
+/**
+ * @brief   Initializes an output ring.
+ * @note    The callback is invoked from within the S-Locked system state,
+ *          see @ref system_states.
+ *
+ * @param[out] orp      pointer to an @p OutputRing structure
+ * @param[in] bp        pointer to a memory area allocated as ring buffer
+ * @param[in] size      size of the ring buffer, must be a power of two
+ * @param[in] onfy      pointer to a callback function that is invoked when
+ *                      data is written into an empty ring. The value can be
+ *                      @p NULL.
+ * @param[in] link      application defined pointer
+ *
+ * @init
+ */
+void chORInit(OutputRing *orp, uint8_t *bp, size_t size, rnotify_t onfy,
+              void *link) {
+
+  chDbgCheck((bp != NULL) && (size > 0) && ((size & (size - 1)) == 0),
+             "chORInit");
+
+  orp->r_head = orp->r_tail = 0;
+  queue_init(&orp->r_waiting);
+  orp->r_buffer = bp;
+  orp->r_mask = size - 1;
+  orp->r_notify = onfy;
+  orp->r_link = link;
+}
+
+/**
+ * @brief   Resets an output ring.
+ * @details All the data in the output ring is erased and lost, the waiting
+ *          thread, if any, is resumed with status @p Q_RESET.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure
+ *
+ * @iclass
+ */
+void chORResetI(OutputRing *orp) {
+
+  chDbgCheckClassI();
+
+  orp->r_tail = orp->r_head;
+  rwakeup(orp, Q_RESET);
+}
+
+/**
+ * @brief   Output ring write with timeout.
+ * @details This function writes a byte value to an output ring. If the ring
+ *          is full then the calling thread is suspended until there is space
+ *          in the ring or a timeout occurs.
+ * @note    The callback is invoked after writing the byte into an empty
+ *          ring.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure
+ * @param[in] b         the byte value to be written in the ring
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval Q_OK         if the operation succeeded.
+ * @retval Q_TIMEOUT    if the specified time expired.
+ * @retval Q_RESET      if the ring has been reset.
+ *
+ * @api
+ */
+msg_t chORPutTimeout(OutputRing *orp, uint8_t b, systime_t time) {
+  size_t head = orp->r_head;
+
+  if (head - orp->r_tail > orp->r_mask) {
+    chSysLock();
+    while (head - orp->r_tail > orp->r_mask) {
+      msg_t msg;
+
+      if ((msg = rwait(orp, time)) < Q_OK) {
+        chSysUnlock();
+        return msg;
+      }
+    }
+    chSysUnlock();
+  }
+
+  orp->r_buffer[head & orp->r_mask] = b;
+  ring_barrier();
+  orp->r_head = head + 1;
+
+  /* The reader side is notified only if it could have been idle.*/
+  if (orp->r_tail == head)
+    rnotify(orp);
+  return Q_OK;
+}
+
+/**
+ * @brief   Output ring write with timeout.
+ * @details The function writes data from a buffer to an output ring. The
+ *          operation completes when the specified amount of data has been
+ *          transferred or after the specified timeout or if the ring has
+ *          been reset.<br>
+ *          All the free space in the ring is filled at once without
+ *          entering the kernel lock.
+ * @note    The callback is invoked after each block of data written into
+ *          an empty ring.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred, the
+ *                      value 0 is reserved
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The number of bytes effectively transferred.
+ *
+ * @api
+ */
+size_t chORWriteTimeout(OutputRing *orp, const uint8_t *bp,
+                        size_t n, systime_t time) {
+  size_t w = 0;
+
+  chDbgCheck(n > 0, "chORWriteTimeout");
+
+  while (TRUE) {
+    size_t head = orp->r_head;
+    size_t m = chRSizeI(orp) - (head - orp->r_tail);
+
+    if (m == 0) {
+      chSysLock();
+      while (head - orp->r_tail > orp->r_mask) {
+        if (rwait(orp, time) != Q_OK) {
+          chSysUnlock();
+          return w;
+        }
+      }
+      chSysUnlock();
+      continue;
+    }
+
+    if (m > n - w)
+      m = n - w;
+    rcopyin(orp, head, bp, m);
+    ring_barrier();
+    orp->r_head = head + m;
+    bp += m;
+    w += m;
+
+    if (orp->r_tail == head)
+      rnotify(orp);
+    if (w == n)
+      return w;
+  }
+}
+
+/**
+ * @brief   Output ring read.
+ * @details A byte value is read from the low end of an output ring.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure
+ * @return              The byte value from the ring.
+ * @retval Q_EMPTY      if the ring is empty.
+ *
+ * @iclass
+ */
+msg_t chORGetI(OutputRing *orp) {
+  size_t tail = orp->r_tail;
+  uint8_t b;
+
+  chDbgCheckClassI();
+
+  if (orp->r_head == tail)
+    return Q_EMPTY;
+
+  ring_barrier();
+  b = orp->r_buffer[tail & orp->r_mask];
+  ring_barrier();
+  orp->r_tail = tail + 1;
+
+  /* The writer can only be waiting if the ring was full.*/
+  if (orp->r_head - tail > orp->r_mask)
+    rwakeup(orp, Q_OK);
+
+  return b;
+}
+
+/**
+ * @brief   Output ring bulk read.
+ * @details The function reads as much data as possible from the low end of
+ *          an output ring into a buffer, the writer is awakened once.
+ *
+ * @param[in] orp       pointer to an @p OutputRing structure
+ * @param[out] bp       pointer to the data buffer
+ * @param[in] n         the maximum amount of data to be transferred
+ * @return              The number of bytes effectively transferred.
+ * @retval 0            if the ring is empty.
+ *
+ * @iclass
+ */
+size_t chORReadI(OutputRing *orp, uint8_t *bp, size_t n) {
+  size_t head = orp->r_head;
+  size_t tail = orp->r_tail;
+
+  chDbgCheckClassI();
+
+  if (n > head - tail)
+    n = head - tail;
+  if (n == 0)
+    return 0;
+
+  ring_barrier();
+  rcopyout(orp, tail, bp, n);
+  ring_barrier();
+  orp->r_tail = tail + n;
+
+  if (head - tail > orp->r_mask)
+    rwakeup(orp, Q_OK);
+
+  return n;
+}
+#endif /* CH_USE_QUEUES_RINGS */
 #endif  /* CH_USE_QUEUES */
 
 /** @} */
@@ -158,6 +158,52 @@ Thread *chRegNextThread(Thread *tp) {
   return ntp;
 }
 
+#if CH_DBG_THREADS_ACCOUNTING || defined(__DOXYGEN__)
+/**
+ * @brief   Returns the time consumed by the specified thread.
+ * @pre     This function is only available when the
+ *          @p CH_DBG_THREADS_ACCOUNTING configuration option is enabled.
+ * @note    The time consumed by the running thread since the last context
+ *          switch or ISR is not included.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The time in realtime counter cycles, the counter
+ *                      frequency is returned by
+ *                      @p chDbgGetRunTimeFrequency().
+ *
+ * @api
+ */
+uint64_t chRegGetThreadRunTime(Thread *tp) {
+  uint64_t t;
+
+  chSysLock();
+  t = tp->p_runtime;
+  chSysUnlock();
+  return t;
+}
+
+/**
+ * @brief   Returns the load of the specified thread.
+ * @pre     This function is only available when the
+ *          @p CH_DBG_THREADS_ACCOUNTING configuration option is enabled.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The load in the last measurement window, in
+ *                      hundredths of percent.
+ *
+ * @api
+ */
+uint16_t chRegGetThreadLoad(Thread *tp) {
+  uint16_t load;
+
+  chSysLock();
+  dbg_acc_roll(tp);
+  load = tp->p_load;
+  chSysUnlock();
+  return load;
+}
+#endif /* CH_DBG_THREADS_ACCOUNTING */
+
 #endif /* CH_USE_REGISTRY */
 
 /** @} */
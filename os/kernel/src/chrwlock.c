@@ -0,0 +1,417 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    chrwlock.c
+ * @brief   Readers-writer locks code.
+ *
+ * @addtogroup rwlocks
+ * @details Readers-writer locks related APIs and services.
+ *          <h2>Operation mode</h2>
+ *          A readers-writer lock can be held by any number of readers at
+ *          the same time or by a single writer.<br>
+ *          The lock enforces a writer preference policy, a writer requesting
+ *          the lock becomes its owner immediately if no other writer owns
+ *          it, from that point the new readers are queued and the writer
+ *          waits for the current readers to release the lock. The readers
+ *          and the writers waiting on the lock share a single queue ordered
+ *          by priority, when a writer releases the lock the queue is served
+ *          in order, the readers at the head of the queue are all admitted
+ *          and the first writer found becomes the new owner.<br>
+ *          All the lock operations accept a timeout, a writer that times out
+ *          while waiting for the readers gives up the ownership and the
+ *          queued threads are served as if the lock had been released.
+ *          <h2>Priority inheritance</h2>
+ *          The writer ownership is recorded in a @p Mutex structure embedded
+ *          in the lock and inserted in the writer owned mutexes list, the
+ *          priority inheritance mechanism boosts the writer to the priority
+ *          of the highest priority thread waiting on the lock, the boost is
+ *          also propagated through nested mutexes and locks. Readers are not
+ *          tracked and are not boosted.
+ * @note    The writer must release the lock in reverse lock order with
+ *          respect to the owned mutexes, as for mutexes.
+ * @note    A lock held in exclusive mode is also released by
+ *          @p chMtxUnlockAll().
+ * @note    A thread holding the lock as reader must not request it as
+ *          writer, the writer would wait for itself.
+ * @pre     In order to use the readers-writer lock APIs the
+ *          @p CH_USE_RWLOCKS option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+
+/**
+ * @brief   Makes a thread the writer owner of a lock.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] tp        pointer to the thread
+ */
+static void rw_own(RWLock *rwp, Thread *tp) {
+
+  rwp->rw_mtx.m_owner = tp;
+  rwp->rw_mtx.m_next = tp->p_mtxlist;
+  tp->p_mtxlist = &rwp->rw_mtx;
+}
+
+/**
+ * @brief   Serves the queue of a lock without a writer owner.
+ * @details The readers at the head of the queue are admitted, the first
+ *          writer found becomes the new owner. A writer made owner while
+ *          readers still hold the lock keeps waiting, outside the queue,
+ *          for the readers to release it.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ */
+static void rw_grant(RWLock *rwp) {
+  ThreadsQueue *qp = &rwp->rw_mtx.m_queue;
+
+  rwp->rw_mtx.m_owner = NULL;
+  while (notempty(qp)) {
+    Thread *tp = fifo_remove(qp);
+
+    if (tp->p_state == THD_STATE_WTWRLOCK) {
+      rw_own(rwp, tp);
+      if (rwp->rw_readers > 0)
+        tp->p_state = THD_STATE_SUSPENDED;
+      else
+        chSchReadyI(tp)->p_u.rdymsg = RDY_OK;
+      return;
+    }
+    rwp->rw_readers++;
+    chSchReadyI(tp)->p_u.rdymsg = RDY_OK;
+  }
+}
+
+/**
+ * @brief   Queues the running thread on a lock with a writer owner.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] newstate  the waiting state
+ * @param[in] time      the number of ticks before the operation timeouts
+ * @return              The wakeup message.
+ */
+static msg_t rw_wait(RWLock *rwp, tstate_t newstate, systime_t time) {
+  msg_t msg;
+
+  _mtx_prio_boost(&rwp->rw_mtx);
+  prio_insert(currp, &rwp->rw_mtx.m_queue);
+  currp->p_u.wtobjp = rwp;
+  msg = chSchGoSleepTimeoutS(newstate, time);
+  /* On timeout the thread has been removed from the queue, the owner
+     could have been boosted by this thread.*/
+  if ((msg == RDY_TIMEOUT) && (rwp->rw_mtx.m_owner != NULL) &&
+      (rwp->rw_mtx.m_owner != currp))
+    _mtx_prio_restore(rwp->rw_mtx.m_owner);
+  return msg;
+}
+
+/**
+ * @brief   Releases a lock held in exclusive mode.
+ * @details The queue is served as by @p chRWLockWriteUnlockS(), the lock
+ *          must have already been removed from the owner mutexes list and
+ *          the owner priority restored.
+ * @note    Used by @p chMtxUnlockAll().
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @notapi
+ */
+void _rw_release(RWLock *rwp) {
+
+  rw_grant(rwp);
+}
+
+/**
+ * @brief   Initializes a @p RWLock structure.
+ *
+ * @param[out] rwp      pointer to a @p RWLock structure
+ *
+ * @init
+ */
+void chRWLockInit(RWLock *rwp) {
+
+  chDbgCheck(rwp != NULL, "chRWLockInit");
+
+  chMtxInit(&rwp->rw_mtx);
+  rwp->rw_readers = 0;
+}
+
+/**
+ * @brief   Acquires the lock in shared mode with timeout specification.
+ * @details The invoking thread waits while a writer owns the lock, this
+ *          includes a writer waiting for the current readers to release
+ *          the lock.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+ *                      specified timeout.
+ *
+ * @api
+ */
+msg_t chRWLockReadLockTimeout(RWLock *rwp, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockReadLockTimeoutS(rwp, time);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Acquires the lock in shared mode with timeout specification.
+ * @details The invoking thread waits while a writer owns the lock, this
+ *          includes a writer waiting for the current readers to release
+ *          the lock.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+ *                      specified timeout.
+ *
+ * @sclass
+ */
+msg_t chRWLockReadLockTimeoutS(RWLock *rwp, systime_t time) {
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL, "chRWLockReadLockTimeoutS");
+  chDbgAssert(rwp->rw_mtx.m_owner != currp,
+              "chRWLockReadLockTimeoutS(), #1", "already owner");
+
+  if (rwp->rw_mtx.m_owner == NULL) {
+    rwp->rw_readers++;
+    return RDY_OK;
+  }
+  if (TIME_IMMEDIATE == time)
+    return RDY_TIMEOUT;
+  /* The readers count is increased by the thread serving the queue.*/
+  return rw_wait(rwp, THD_STATE_WTRDLOCK, time);
+}
+
+/**
+ * @brief   Releases the lock acquired in shared mode.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @api
+ */
+void chRWLockReadUnlock(RWLock *rwp) {
+
+  chSysLock();
+  chRWLockReadUnlockS(rwp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Releases the lock acquired in shared mode.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @sclass
+ */
+void chRWLockReadUnlockS(RWLock *rwp) {
+  Thread *tp;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL, "chRWLockReadUnlockS");
+  chDbgAssert(rwp->rw_readers > 0,
+              "chRWLockReadUnlockS(), #1", "not locked");
+
+  /* The last reader wakes up the writer owner, if it has not already
+     been awakened by its timeout.*/
+  tp = rwp->rw_mtx.m_owner;
+  if ((--rwp->rw_readers == 0) && (tp != NULL) &&
+      (tp->p_state == THD_STATE_SUSPENDED))
+    chSchReadyI(tp)->p_u.rdymsg = RDY_OK;
+}
+
+/**
+ * @brief   Acquires the lock in exclusive mode with timeout specification.
+ * @details If no other writer owns the lock then the invoking thread becomes
+ *          the owner immediately, new readers are no more admitted, and
+ *          waits for the current readers to release the lock. Otherwise the
+ *          invoking thread is queued and the owner priority is boosted.
+ * @post    The lock is inserted in the per-thread stack of owned mutexes.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+ *                      specified timeout.
+ *
+ * @api
+ */
+msg_t chRWLockWriteLockTimeout(RWLock *rwp, systime_t time) {
+  msg_t msg;
+
+  chSysLock();
+  msg = chRWLockWriteLockTimeoutS(rwp, time);
+  chSysUnlock();
+  return msg;
+}
+
+/**
+ * @brief   Acquires the lock in exclusive mode with timeout specification.
+ * @details If no other writer owns the lock then the invoking thread becomes
+ *          the owner immediately, new readers are no more admitted, and
+ *          waits for the current readers to release the lock. Otherwise the
+ *          invoking thread is queued and the owner priority is boosted.
+ * @post    The lock is inserted in the per-thread stack of owned mutexes.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ * @param[in] time      the number of ticks before the operation timeouts,
+ *                      the following special values are allowed:
+ *                      - @a TIME_IMMEDIATE immediate timeout.
+ *                      - @a TIME_INFINITE no timeout.
+ *                      .
+ * @return              The operation status.
+ * @retval RDY_OK       if the lock has been acquired.
+ * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+ *                      specified timeout.
+ *
+ * @sclass
+ */
+msg_t chRWLockWriteLockTimeoutS(RWLock *rwp, systime_t time) {
+  Thread *ctp = currp;
+  msg_t msg;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL, "chRWLockWriteLockTimeoutS");
+  chDbgAssert(rwp->rw_mtx.m_owner != ctp,
+              "chRWLockWriteLockTimeoutS(), #1", "already owner");
+
+  if (rwp->rw_mtx.m_owner == NULL) {
+    if (rwp->rw_readers == 0) {
+      rw_own(rwp, ctp);
+      return RDY_OK;
+    }
+    if (TIME_IMMEDIATE == time)
+      return RDY_TIMEOUT;
+    /* Becoming the owner stops the new readers, then waits for the
+       current readers to release the lock.*/
+    rw_own(rwp, ctp);
+    msg = chSchGoSleepTimeoutS(THD_STATE_SUSPENDED, time);
+  }
+  else {
+    if (TIME_IMMEDIATE == time)
+      return RDY_TIMEOUT;
+    msg = rw_wait(rwp, THD_STATE_WTWRLOCK, time);
+  }
+  if ((msg == RDY_TIMEOUT) && (rwp->rw_mtx.m_owner == ctp)) {
+    /* Timeout while waiting for the readers, it is not a timeout if the
+       readers released the lock in the meantime.*/
+    if (rwp->rw_readers == 0)
+      return RDY_OK;
+    /* The ownership is given up and the queue served as if the lock had
+       been released.*/
+    chDbgAssert(ctp->p_mtxlist == &rwp->rw_mtx,
+                "chRWLockWriteLockTimeoutS(), #2", "ownership failure");
+    ctp->p_mtxlist = rwp->rw_mtx.m_next;
+    _mtx_prio_restore(ctp);
+    rw_grant(rwp);
+    chSchRescheduleS();
+  }
+  chDbgAssert((msg != RDY_OK) || (rwp->rw_mtx.m_owner == ctp),
+              "chRWLockWriteLockTimeoutS(), #3", "not owner");
+  return msg;
+}
+
+/**
+ * @brief   Releases the lock acquired in exclusive mode.
+ * @pre     The lock must be the last mutex locked by the invoking thread.
+ * @post    The lock is removed from the per-thread stack of owned mutexes.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @api
+ */
+void chRWLockWriteUnlock(RWLock *rwp) {
+
+  chSysLock();
+  chRWLockWriteUnlockS(rwp);
+  chSchRescheduleS();
+  chSysUnlock();
+}
+
+/**
+ * @brief   Releases the lock acquired in exclusive mode.
+ * @pre     The lock must be the last mutex locked by the invoking thread.
+ * @post    The lock is removed from the per-thread stack of owned mutexes.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel.
+ *
+ * @param[in] rwp       pointer to the @p RWLock structure
+ *
+ * @sclass
+ */
+void chRWLockWriteUnlockS(RWLock *rwp) {
+  Thread *ctp = currp;
+
+  chDbgCheckClassS();
+  chDbgCheck(rwp != NULL, "chRWLockWriteUnlockS");
+  chDbgAssert((rwp->rw_mtx.m_owner == ctp) && (rwp->rw_readers == 0),
+              "chRWLockWriteUnlockS(), #1", "ownership failure");
+  chDbgAssert(ctp->p_mtxlist == &rwp->rw_mtx,
+              "chRWLockWriteUnlockS(), #2", "not the last locked mutex");
+
+  ctp->p_mtxlist = rwp->rw_mtx.m_next;
+  if (chMtxQueueNotEmptyS(&rwp->rw_mtx)) {
+    /* Recalculates the optimal thread priority by scanning the owned
+       mutexes list.*/
+    _mtx_prio_restore(ctp);
+    rw_grant(rwp);
+  }
+  else
+    rwp->rw_mtx.m_owner = NULL;
+}
+
+#endif /* CH_USE_RWLOCKS */
+
+/** @} */
@@ -59,6 +59,15 @@ void _scheduler_init(void) {
 #if CH_USE_REGISTRY
   rlist.r_newer = rlist.r_older = (Thread *)&rlist;
 #endif
+#if CH_USE_READYLIST_BITMAP
+  {
+    unsigned i;
+
+    rlist.r_summary = 0;
+    for (i = 0; i < RL_WORDS; i++)
+      rlist.r_bitmap[i] = 0;
+  }
+#endif
 }
 
 /**
@@ -90,7 +99,18 @@ Thread *chSchReadyI(Thread *tp) {
               "invalid state");
 
   tp->p_state = THD_STATE_READY;
+  dbg_trace_event(CH_TRACE_TYPE_READY, tp, currp);
   cp = (Thread *)&rlist.r_queue;
+#if CH_USE_EDF
+  if (tp->p_prio == EDFPRIO) {
+    /* The EDF threads are ordered by deadline within their level.*/
+    do {
+      cp = cp->p_next;
+    } while ((cp->p_prio > EDFPRIO) ||
+             ((cp->p_prio == EDFPRIO) && !edf_earlier(tp, cp)));
+  }
+  else
+#endif
   do {
     cp = cp->p_next;
   } while (cp->p_prio >= tp->p_prio);
@@ -102,6 +122,32 @@ Thread *chSchReadyI(Thread *tp) {
 }
 #endif /* !defined(PORT_OPTIMIZED_READYI) */
 
+/**
+ * @brief   Removes a thread from the Ready List.
+ * @pre     The thread must be in the @p THD_STATE_READY state and its
+ *          priority must not have been changed after its insertion in the
+ *          ready list.
+ * @post    The thread state is not changed, it is responsibility of the
+ *          caller to put the thread in its new state.
+ *
+ * @param[in] tp        the thread to be removed
+ * @return              The thread pointer.
+ *
+ * @iclass
+ */
+#if !defined(PORT_OPTIMIZED_REMOVEI) || defined(__DOXYGEN__)
+Thread *chSchRemoveI(Thread *tp) {
+
+  chDbgCheckClassI();
+
+  chDbgAssert(tp->p_state == THD_STATE_READY,
+              "chSchRemoveI(), #1",
+              "not ready");
+
+  return dequeue(tp);
+}
+#endif /* !defined(PORT_OPTIMIZED_REMOVEI) */
+
 /**
  * @brief   Puts the current thread to sleep into the specified state.
  * @details The thread goes into a sleeping state. The possible
@@ -144,7 +190,7 @@ static void wakeup(void *p) {
     chSysUnlockFromIsr();
     return;
 #if CH_USE_SEMAPHORES || CH_USE_QUEUES ||                                   \
-    (CH_USE_CONDVARS && CH_USE_CONDVARS_TIMEOUT)
+    (CH_USE_CONDVARS && CH_USE_CONDVARS_TIMEOUT) || CH_USE_RWLOCKS
 #if CH_USE_SEMAPHORES
   case THD_STATE_WTSEM:
     chSemFastSignalI((Semaphore *)tp->p_u.wtobjp);
@@ -155,6 +201,10 @@ static void wakeup(void *p) {
 #endif
 #if CH_USE_CONDVARS && CH_USE_CONDVARS_TIMEOUT
   case THD_STATE_WTCOND:
+#endif
+#if CH_USE_RWLOCKS
+  case THD_STATE_WTRDLOCK:
+  case THD_STATE_WTWRLOCK:
 #endif
     /* States requiring dequeuing.*/
     dequeue(tp);
@@ -231,7 +281,11 @@ void chSchWakeupS(Thread *ntp, msg_t msg) {
      one then it is just inserted in the ready list else it made
      running immediately and the invoking thread goes in the ready
      list instead.*/
+#if CH_USE_EDF
+  if (!sch_precedes(ntp, currp))
+#else
   if (ntp->p_prio <= currp->p_prio)
+#endif
     chSchReadyI(ntp);
   else {
     Thread *otp = chSchReadyI(currp);
@@ -276,6 +330,12 @@ void chSchRescheduleS(void) {
 bool_t chSchIsPreemptionRequired(void) {
   tprio_t p1 = firstprio(&rlist.r_queue);
   tprio_t p2 = currp->p_prio;
+#if CH_USE_EDF
+  /* The EDF threads are not subject to round robin, a running EDF thread
+     is only preempted by threads with an earlier deadline.*/
+  if ((p1 == EDFPRIO) && (p2 == EDFPRIO))
+    return edf_earlier(rlist.r_queue.p_next, currp);
+#endif
 #if CH_TIME_QUANTUM > 0
   /* If the running thread has not reached its time quantum, reschedule only
      if the first thread on the ready queue has a higher priority.
@@ -336,6 +396,15 @@ void chSchDoRescheduleAhead(void) {
 
   otp->p_state = THD_STATE_READY;
   cp = (Thread *)&rlist.r_queue;
+#if CH_USE_EDF
+  if (otp->p_prio == EDFPRIO) {
+    do {
+      cp = cp->p_next;
+    } while ((cp->p_prio > EDFPRIO) ||
+             ((cp->p_prio == EDFPRIO) && edf_earlier(cp, otp)));
+  }
+  else
+#endif
   do {
     cp = cp->p_next;
   } while (cp->p_prio > otp->p_prio);
@@ -382,4 +451,315 @@ void chSchDoReschedule(void) {
 }
 #endif /* !defined(PORT_OPTIMIZED_DORESCHEDULE) */
 
+#if CH_USE_READYLIST_BITMAP || defined(__DOXYGEN__)
+/*===========================================================================*/
+/* Bitmap indexed ready list.                                                */
+/*===========================================================================*/
+
+/*
+ * Index of the least significant set bit in a non-zero word.
+ */
+#if defined(__GNUC__)
+#define rl_ffs(w) ((unsigned)__builtin_ctz(w))
+#else
+static unsigned rl_ffs(uint32_t w) {
+  static const uint8_t debruijn[32] = {
+    0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+    31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+  };
+
+  return debruijn[((w & (0 - w)) * 0x077CB531UL) >> 27];
+}
+#endif
+
+/*
+ * Evaluates to non-zero if the priority level is occupied.
+ */
+#define rl_isset(prio)                                                      \
+  (rlist.r_bitmap[(prio) >> 5] & ((uint32_t)1 << ((prio) & 31)))
+
+/*
+ * Marks a priority level as occupied, tp becomes the last thread of the
+ * level.
+ */
+#define rl_set(prio, tp) {                                                  \
+  rlist.r_tail[prio] = (tp);                                                \
+  rlist.r_bitmap[(prio) >> 5] |= (uint32_t)1 << ((prio) & 31);              \
+  rlist.r_summary |= (uint32_t)1 << ((prio) >> 5);                          \
+}
+
+/*
+ * Marks a priority level as empty.
+ */
+#define rl_clear(prio) {                                                    \
+  if ((rlist.r_bitmap[(prio) >> 5] &= ~((uint32_t)1 << ((prio) & 31))) == 0)\
+    rlist.r_summary &= ~((uint32_t)1 << ((prio) >> 5));                     \
+}
+
+/*
+ * Returns the thread after which a thread must be inserted in order to be
+ * ahead of all the threads with its same priority, this is the last thread
+ * of the nearest occupied level above prio or the list header if there are
+ * no threads with higher priority.
+ */
+static Thread *rl_ahead(tprio_t prio) {
+  unsigned w = prio >> 5;
+  uint32_t m;
+
+  /* Occupied levels above prio in the same bitmap word, the double shift
+     yields zero when prio is the word most significant bit.*/
+  m = rlist.r_bitmap[w] & ~((((uint32_t)2) << (prio & 31)) - 1);
+  if (m == 0) {
+    uint32_t s = rlist.r_summary & ~((((uint32_t)2) << w) - 1);
+    if (s == 0)
+      return (Thread *)&rlist.r_queue;
+    w = rl_ffs(s);
+    m = rlist.r_bitmap[w];
+  }
+  return rlist.r_tail[(w << 5) + rl_ffs(m)];
+}
+
+/*
+ * Inserts a thread after the specified one.
+ */
+#define rl_insert_after(tp, cp) {                                           \
+  (tp)->p_prev = (cp);                                                      \
+  (tp)->p_next = (cp)->p_next;                                              \
+  (tp)->p_next->p_prev = (cp)->p_next = (tp);                               \
+}
+
+#if CH_USE_EDF
+/*
+ * Returns the thread after which an EDF thread must be inserted, the
+ * occupied EDF level is scanned backward from its tail because new jobs
+ * usually have the latest deadline. If ahead is TRUE the thread is
+ * positioned ahead of the threads with equal deadline.
+ */
+static Thread *rl_edf_after(Thread *tp, bool_t ahead) {
+  Thread *cp = rlist.r_tail[EDFPRIO];
+
+  while ((cp->p_prio == EDFPRIO) &&
+         (ahead ? !edf_earlier(cp, tp) : edf_earlier(tp, cp)))
+    cp = cp->p_prev;
+  return cp;
+}
+#endif /* CH_USE_EDF */
+
+/*
+ * Removes the first thread from the ready list.
+ */
+static Thread *rl_remove_first(void) {
+  Thread *tp = fifo_remove(&rlist.r_queue);
+
+  if (rlist.r_tail[tp->p_prio] == tp)
+    rl_clear(tp->p_prio);
+  return tp;
+}
+
+/**
+ * @brief   Inserts a thread in the Ready List.
+ * @details The thread is positioned behind all threads with higher or equal
+ *          priority. The insertion point is located using the levels bitmap
+ *          so the operation is done in constant time.
+ * @pre     The thread must not be already inserted in any list through its
+ *          @p p_next and @p p_prev or list corruption would occur.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note that
+ *          interrupt handlers always reschedule on exit so an explicit
+ *          reschedule must not be performed in ISRs.
+ *
+ * @param[in] tp        the thread to be made ready
+ * @return              The thread pointer.
+ *
+ * @iclass
+ */
+Thread *chSchReadyI(Thread *tp) {
+  tprio_t prio = tp->p_prio;
+  Thread *cp;
+
+  chDbgCheckClassI();
+
+  /* Integrity checks.*/
+  chDbgAssert((tp->p_state != THD_STATE_READY) &&
+              (tp->p_state != THD_STATE_FINAL),
+              "chSchReadyI(), #1",
+              "invalid state");
+  chDbgAssert(prio < RL_LEVELS, "chSchReadyI(), #2", "invalid priority");
+
+  tp->p_state = THD_STATE_READY;
+  dbg_trace_event(CH_TRACE_TYPE_READY, tp, currp);
+#if CH_USE_EDF
+  if ((prio == EDFPRIO) && rl_isset(prio)) {
+    cp = rl_edf_after(tp, FALSE);
+    rl_insert_after(tp, cp);
+    if (rlist.r_tail[prio] == cp)
+      rlist.r_tail[prio] = tp;
+    return tp;
+  }
+#endif
+  if (rl_isset(prio))
+    cp = rlist.r_tail[prio];
+  else
+    cp = rl_ahead(prio);
+  rl_insert_after(tp, cp);
+  rl_set(prio, tp);
+  return tp;
+}
+
+/**
+ * @brief   Removes a thread from the Ready List.
+ * @pre     The thread must be in the @p THD_STATE_READY state and its
+ *          priority must not have been changed after its insertion in the
+ *          ready list.
+ * @post    The thread state is not changed, it is responsibility of the
+ *          caller to put the thread in its new state.
+ *
+ * @param[in] tp        the thread to be removed
+ * @return              The thread pointer.
+ *
+ * @iclass
+ */
+Thread *chSchRemoveI(Thread *tp) {
+  tprio_t prio = tp->p_prio;
+
+  chDbgCheckClassI();
+
+  chDbgAssert(tp->p_state == THD_STATE_READY,
+              "chSchRemoveI(), #1",
+              "not ready");
+
+  if (rlist.r_tail[prio] == tp) {
+    /* The header priority is zero so it never matches a thread level.*/
+    if (tp->p_prev->p_prio == prio)
+      rlist.r_tail[prio] = tp->p_prev;
+    else
+      rl_clear(prio);
+  }
+  return dequeue(tp);
+}
+
+/**
+ * @brief   Puts the current thread to sleep into the specified state.
+ * @details The thread goes into a sleeping state. The possible
+ *          @ref thread_states are defined into @p threads.h.
+ *
+ * @param[in] newstate  the new thread state
+ *
+ * @sclass
+ */
+void chSchGoSleepS(tstate_t newstate) {
+  Thread *otp;
+
+  chDbgCheckClassS();
+
+  (otp = currp)->p_state = newstate;
+#if CH_TIME_QUANTUM > 0
+  /* The thread is renouncing its remaining time slices so it will have a new
+     time quantum when it will wakeup.*/
+  otp->p_preempt = CH_TIME_QUANTUM;
+#endif
+  setcurrp(rl_remove_first());
+  currp->p_state = THD_STATE_CURRENT;
+  chSysSwitch(currp, otp);
+}
+
+/**
+ * @brief   Switches to the first thread on the runnable queue.
+ * @details The current thread is positioned in the ready list behind all
+ *          threads having the same priority. The thread regains its time
+ *          quantum.
+ * @note    Not a user function, it is meant to be invoked by the scheduler
+ *          itself or from within the port layer.
+ *
+ * @special
+ */
+void chSchDoRescheduleBehind(void) {
+  Thread *otp;
+
+  otp = currp;
+  /* Picks the first thread from the ready queue and makes it current.*/
+  setcurrp(rl_remove_first());
+  currp->p_state = THD_STATE_CURRENT;
+#if CH_TIME_QUANTUM > 0
+  otp->p_preempt = CH_TIME_QUANTUM;
+#endif
+  chSchReadyI(otp);
+  chSysSwitch(currp, otp);
+}
+
+/**
+ * @brief   Switches to the first thread on the runnable queue.
+ * @details The current thread is positioned in the ready list ahead of all
+ *          threads having the same priority.
+ * @note    Not a user function, it is meant to be invoked by the scheduler
+ *          itself or from within the port layer.
+ *
+ * @special
+ */
+void chSchDoRescheduleAhead(void) {
+  Thread *otp, *cp;
+  tprio_t prio;
+
+  otp = currp;
+  prio = otp->p_prio;
+  /* Picks the first thread from the ready queue and makes it current.*/
+  setcurrp(rl_remove_first());
+  currp->p_state = THD_STATE_CURRENT;
+
+  otp->p_state = THD_STATE_READY;
+#if CH_USE_EDF
+  if ((prio == EDFPRIO) && rl_isset(prio)) {
+    /* The thread becomes the level tail if it has the latest deadline.*/
+    cp = rl_edf_after(otp, TRUE);
+    rl_insert_after(otp, cp);
+    if (rlist.r_tail[prio] == cp)
+      rlist.r_tail[prio] = otp;
+  }
+  else
+#endif
+  {
+    cp = rl_ahead(prio);
+    rl_insert_after(otp, cp);
+    /* The thread becomes the level tail only if the level was empty.*/
+    if (!rl_isset(prio))
+      rl_set(prio, otp);
+  }
+
+  chSysSwitch(currp, otp);
+}
+#endif /* CH_USE_READYLIST_BITMAP */
+
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+/**
+ * @brief   Performs an adaptive wait iteration.
+ * @details If there are ready threads with equal or higher priority then
+ *          the running thread yields to them else, if spinning is allowed,
+ *          the kernel is unlocked for a short window in order to serve the
+ *          pending interrupts.
+ * @note    Spinning is only useful for objects released from ISRs, on a
+ *          single core lower priority threads cannot run while spinning.
+ *
+ * @param[in] spin      spinning allowed
+ * @return              The iteration outcome.
+ * @retval FALSE        if nothing could be done, the caller should sleep.
+ *
+ * @sclass
+ */
+bool_t chSchAdaptiveStepS(bool_t spin) {
+
+  chDbgCheckClassS();
+
+  if (chSchCanYieldS()) {
+    chSchDoRescheduleBehind();
+    return TRUE;
+  }
+  if (spin) {
+    chSysUnlock();
+    chSysLock();
+    return TRUE;
+  }
+  return FALSE;
+}
+#endif /* CH_USE_ADAPTIVE_WAIT */
+
 /** @} */
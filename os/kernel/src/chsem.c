@@ -74,6 +74,26 @@
 #define sem_insert(tp, qp) queue_insert(tp, qp)
 #endif
 
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+/**
+ * @brief   Adaptive wait on a semaphore with a zero counter.
+ * @details The running thread yields, or spins, until the counter becomes
+ *          positive or the iterations limit is reached.
+ *
+ * @param[in] sp        pointer to a @p Semaphore structure
+ */
+static void sem_adaptive_wait(Semaphore *sp) {
+  cnt_t n = sp->s_aw.aw_limit;
+
+  while ((sp->s_cnt <= 0) && (n-- > 0) && chSchAdaptiveStepS(TRUE))
+    ;
+  if (sp->s_cnt > 0)
+    sp->s_aw.aw_hits++;
+  else
+    sp->s_aw.aw_misses++;
+}
+#endif /* CH_USE_ADAPTIVE_WAIT */
+
 /**
  * @brief   Initializes a semaphore with the specified counter value.
  *
@@ -89,6 +109,11 @@ void chSemInit(Semaphore *sp, cnt_t n) {
 
   queue_init(&sp->s_queue);
   sp->s_cnt = n;
+#if CH_USE_ADAPTIVE_WAIT
+  sp->s_aw.aw_limit = 0;
+  sp->s_aw.aw_hits = 0;
+  sp->s_aw.aw_misses = 0;
+#endif
 }
 
 /**
@@ -191,6 +216,11 @@ msg_t chSemWaitS(Semaphore *sp) {
               "chSemWaitS(), #1",
               "inconsistent semaphore");
 
+  dbg_trace_event(CH_TRACE_TYPE_SEM_WAIT, currp, sp);
+#if CH_USE_ADAPTIVE_WAIT
+  if ((sp->s_cnt == 0) && (sp->s_aw.aw_limit > 0))
+    sem_adaptive_wait(sp);
+#endif
   if (--sp->s_cnt < 0) {
     currp->p_u.wtobjp = sp;
     sem_insert(currp, &sp->s_queue);
@@ -256,6 +286,11 @@ msg_t chSemWaitTimeoutS(Semaphore *sp, systime_t time) {
               "chSemWaitTimeoutS(), #1",
               "inconsistent semaphore");
 
+  dbg_trace_event(CH_TRACE_TYPE_SEM_WAIT, currp, sp);
+#if CH_USE_ADAPTIVE_WAIT
+  if ((sp->s_cnt == 0) && (sp->s_aw.aw_limit > 0) && (time != TIME_IMMEDIATE))
+    sem_adaptive_wait(sp);
+#endif
   if (--sp->s_cnt < 0) {
     if (TIME_IMMEDIATE == time) {
       sp->s_cnt++;
@@ -284,6 +319,7 @@ void chSemSignal(Semaphore *sp) {
               "inconsistent semaphore");
 
   chSysLock();
+  dbg_trace_event(CH_TRACE_TYPE_SEM_SIGNAL, currp, sp);
   if (++sp->s_cnt <= 0)
     chSchWakeupS(fifo_remove(&sp->s_queue), RDY_OK);
   chSysUnlock();
@@ -309,6 +345,7 @@ void chSemSignalI(Semaphore *sp) {
               "chSemSignalI(), #1",
               "inconsistent semaphore");
 
+  dbg_trace_event(CH_TRACE_TYPE_SEM_SIGNAL, currp, sp);
   if (++sp->s_cnt <= 0) {
     /* Note, it is done this way in order to allow a tail call on
              chSchReadyI().*/
@@ -377,8 +414,10 @@ msg_t chSemSignalWait(Semaphore *sps, Semaphore *spw) {
               "inconsistent semaphore");
 
   chSysLock();
+  dbg_trace_event(CH_TRACE_TYPE_SEM_SIGNAL, currp, sps);
   if (++sps->s_cnt <= 0)
     chSchReadyI(fifo_remove(&sps->s_queue))->p_u.rdymsg = RDY_OK;
+  dbg_trace_event(CH_TRACE_TYPE_SEM_WAIT, currp, spw);
   if (--spw->s_cnt < 0) {
     Thread *ctp = currp;
     sem_insert(ctp, &spw->s_queue);
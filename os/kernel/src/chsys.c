@@ -99,6 +99,9 @@ void chSysInit(void) {
 #if CH_DBG_ENABLE_TRACE
   _trace_init();
 #endif
+#if CH_DBG_THREADS_ACCOUNTING
+  _acc_init();
+#endif
 
   /* Now this instructions flow becomes the main thread.*/
   setcurrp(_thread_init(&mainthread, NORMALPRIO));
@@ -121,6 +124,13 @@ void chSysInit(void) {
   chThdCreateStatic(_idle_thread_wa, sizeof(_idle_thread_wa), IDLEPRIO,
                     (tfunc_t)_idle_thread, NULL);
 #endif
+
+#if CH_USE_VT_DEFERRED
+  /* This thread invokes the callbacks of the expired virtual timers out of
+     the tick interrupt.*/
+  chThdCreateStatic(_vt_service_wa, sizeof(_vt_service_wa),
+                    CH_VT_SERVICE_PRIORITY, _vt_service_thread, NULL);
+#endif
 }
 
 /**
@@ -147,6 +157,7 @@ void chSysTimerHandlerI(void) {
 #if CH_DBG_THREADS_PROFILING
   currp->p_time++;
 #endif
+  dbg_acc_tick();
   chVTDoTickI();
 #if defined(SYSTEM_TICK_EVENT_HOOK)
   SYSTEM_TICK_EVENT_HOOK();
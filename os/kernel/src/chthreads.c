@@ -91,6 +91,12 @@ Thread *_thread_init(Thread *tp, tprio_t prio) {
 #if CH_DBG_THREADS_PROFILING
   tp->p_time = 0;
 #endif
+#if CH_DBG_THREADS_ACCOUNTING
+  tp->p_runtime = 0;
+  tp->p_runmark = 0;
+  tp->p_load = 0;
+  tp->p_window = dbg_accounting.acc_serial;
+#endif
 #if CH_USE_DYNAMIC
   tp->p_refs = 1;
 #endif
@@ -104,6 +110,18 @@ Thread *_thread_init(Thread *tp, tprio_t prio) {
 #if CH_USE_MESSAGES
   queue_init(&tp->p_msgqueue);
 #endif
+#if CH_USE_EDF
+  tp->p_edf.ed_period = 0;
+  tp->p_edf.ed_jobs = 0;
+  tp->p_edf.ed_misses = 0;
+  tp->p_edf.ed_timer.vt_func = NULL;
+#endif
+#if CH_USE_HEAP && CH_USE_HEAP_CACHE
+  tp->p_hcache = NULL;
+#endif
+#if CH_DBG_FILL_THREADS
+  tp->p_wend = NULL;
+#endif
 #if CH_DBG_ENABLE_STACK_CHECK
   tp->p_stklimit = (stkalign_t *)(tp + 1);
 #endif
@@ -128,6 +146,56 @@ void _thread_memfill(uint8_t *startp, uint8_t *endp, uint8_t v) {
   while (startp < endp)
     *startp++ = v;
 }
+
+/**
+ * @brief   Returns the size of the stack area of a thread.
+ * @details The stack area is the part of the working area above the
+ *          @p Thread structure, it includes the port overhead.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The stack area size in bytes.
+ * @retval 0            if the stack has not been filled on creation, for
+ *                      example the main thread or threads created by
+ *                      @p chThdCreateI().
+ *
+ * @api
+ */
+size_t chThdGetStackSize(Thread *tp) {
+
+  chDbgCheck(tp != NULL, "chThdGetStackSize");
+
+  if (tp->p_wend == NULL)
+    return 0;
+  return (size_t)(tp->p_wend - (uint8_t *)(tp + 1));
+}
+
+/**
+ * @brief   Returns the stack area never used by a thread.
+ * @details The stack area is scanned from its bottom for the bytes still
+ *          holding @p CH_STACK_FILL_VALUE, the result is the headroom left
+ *          at the thread stack high-water mark. The peak usage is the
+ *          difference between the value returned by
+ *          @p chThdGetStackSize() and this value.
+ * @note    The stacks are assumed to grow downward.
+ * @note    The thread must not terminate and be released during the scan,
+ *          the registry references can be used to prevent it.
+ *
+ * @param[in] tp        pointer to the thread
+ * @return              The unused stack size in bytes.
+ *
+ * @api
+ */
+size_t chThdGetStackUnused(Thread *tp) {
+  uint8_t *p = (uint8_t *)(tp + 1);
+
+  chDbgCheck(tp != NULL, "chThdGetStackUnused");
+
+  if (tp->p_wend == NULL)
+    return 0;
+  while ((p < tp->p_wend) && (*p == CH_STACK_FILL_VALUE))
+    p++;
+  return (size_t)(p - (uint8_t *)(tp + 1));
+}
 #endif /* CH_DBG_FILL_THREADS */
 
 /**
@@ -197,7 +265,11 @@ Thread *chThdCreateStatic(void *wsp, size_t size,
                   CH_STACK_FILL_VALUE);
 #endif
   chSysLock();
-  chSchWakeupS(tp = chThdCreateI(wsp, size, prio, pf, arg), RDY_OK);
+  tp = chThdCreateI(wsp, size, prio, pf, arg);
+#if CH_DBG_FILL_THREADS
+  tp->p_wend = (uint8_t *)wsp + size;
+#endif
+  chSchWakeupS(tp, RDY_OK);
   chSysUnlock();
   return tp;
 }
@@ -370,6 +442,10 @@ void chThdExitS(msg_t msg) {
 #if defined(THREAD_EXT_EXIT_HOOK)
   THREAD_EXT_EXIT_HOOK(tp);
 #endif
+#if CH_USE_EDF
+  if (chVTIsArmedI(&tp->p_edf.ed_timer))
+    chVTResetI(&tp->p_edf.ed_timer);
+#endif
 #if CH_USE_WAITEXIT
   while (notempty(&tp->p_waiting))
     chSchReadyI(list_remove(&tp->p_waiting));
@@ -41,6 +41,86 @@
  */
 VTList vtlist;
 
+#if CH_USE_VT_DEFERRED || defined(__DOXYGEN__)
+/**
+ * @brief   Timer service thread working area.
+ */
+WORKING_AREA(_vt_service_wa, CH_VT_SERVICE_STACK_SIZE);
+
+/**
+ * @brief   Pointer to the timer service thread while it is waiting.
+ */
+static Thread *vtsrvtp;
+
+/**
+ * @brief   Initializes the pending timers list.
+ */
+static void vt_pending_init(void) {
+
+  vtlist.vt_pending.vt_next = vtlist.vt_pending.vt_prev =
+      (void *)&vtlist.vt_pending;
+  vtsrvtp = NULL;
+}
+
+/**
+ * @brief   Wakes up the timer service thread if there are pending timers.
+ */
+static void vt_pending_signal(void) {
+
+  if ((vtsrvtp != NULL) &&
+      ((void *)vtlist.vt_pending.vt_next != (void *)&vtlist.vt_pending)) {
+    chSchReadyI(vtsrvtp);
+    vtsrvtp = NULL;
+  }
+}
+
+/**
+ * @brief   Timer service thread.
+ * @details The thread invokes the callbacks of the expired timers, at most
+ *          @p CH_VT_SERVICE_BUDGET callbacks are invoked before waiting for
+ *          the next system tick.
+ * @note    The callbacks are invoked in an emulated ISR context with the
+ *          kernel locked, the callbacks are allowed to use the
+ *          @p chSysLockFromIsr() and @p chSysUnlockFromIsr() primitives
+ *          as when invoked by the tick interrupt.
+ *
+ * @param[in] p         the thread parameter, unused in this scenario
+ * @return              The function never returns.
+ */
+msg_t _vt_service_thread(void *p) {
+
+  (void)p;
+  chRegSetThreadName("vtservice");
+  chSysLock();
+  while (TRUE) {
+    unsigned n = 0;
+
+    while ((n < CH_VT_SERVICE_BUDGET) &&
+           ((void *)vtlist.vt_pending.vt_next != (void *)&vtlist.vt_pending)) {
+      VirtualTimer *vtp = vtlist.vt_pending.vt_next;
+      vtfunc_t fn = vtp->vt_func;
+
+      vtp->vt_func = (vtfunc_t)NULL;
+      vtp->vt_next->vt_prev = (void *)&vtlist.vt_pending;
+      vtlist.vt_pending.vt_next = vtp->vt_next;
+      dbg_trace_event(CH_TRACE_TYPE_VT_FIRE, NULL, vtp);
+      chSysUnlock();
+      dbg_check_enter_isr();
+      port_lock();
+      fn(vtp->vt_par);
+      port_unlock();
+      dbg_check_leave_isr();
+      chSysLock();
+      chSchRescheduleS();
+      n++;
+    }
+    vtsrvtp = currp;
+    chSchGoSleepS(THD_STATE_SUSPENDED);
+  }
+}
+#endif /* CH_USE_VT_DEFERRED */
+
+#if !CH_USE_VT_WHEEL || defined(__DOXYGEN__)
 /**
  * @brief   Virtual Timers initialization.
  * @note    Internal use only.
@@ -51,7 +131,14 @@ void _vt_init(void) {
 
   vtlist.vt_next = vtlist.vt_prev = (void *)&vtlist;
   vtlist.vt_time = (systime_t)-1;
+#if CH_TIMEDELTA == 0
   vtlist.vt_systime = 0;
+#else
+  vtlist.vt_lasttime = 0;
+#endif
+#if CH_USE_VT_DEFERRED
+  vt_pending_init();
+#endif
 }
 
 /**
@@ -82,7 +169,48 @@ void chVTSetI(VirtualTimer *vtp, systime_t time, vtfunc_t vtfunc, void *par) {
 
   vtp->vt_par = par;
   vtp->vt_func = vtfunc;
+#if CH_TIMEDELTA > 0
+  {
+    systime_t now = port_timer_get_time();
+    systime_t elapsed;
+
+    /* Deadlines too close to the current time could be missed by the
+       alarm.*/
+    if (time < (systime_t)CH_TIMEDELTA)
+      time = (systime_t)CH_TIMEDELTA;
+
+    /* Special case where the timers list is empty, the current time becomes
+       the delta list base time.*/
+    if ((void *)vtlist.vt_next == (void *)&vtlist) {
+      vtlist.vt_lasttime = now;
+      vtp->vt_next = vtp->vt_prev = (void *)&vtlist;
+      vtlist.vt_next = vtlist.vt_prev = vtp;
+      vtp->vt_time = time;
+      port_timer_start_alarm(now + time);
+      return;
+    }
+
+    /* The delay is converted to a delta from the list base time, the
+       value can overflow in case of very large delays.*/
+    p = vtlist.vt_next;
+    elapsed = now - vtlist.vt_lasttime;
+    time += elapsed;
+    if (time < elapsed) {
+      /* The delta exceeded the numeric range, skipping the first element
+         brings it back in range because the elapsed time cannot be greater
+         than the first element delta.*/
+      time -= p->vt_time;
+      p = p->vt_next;
+    }
+    else if (time < p->vt_time) {
+      /* The timer becomes the first element, the alarm is moved to its
+         deadline.*/
+      port_timer_set_alarm(vtlist.vt_lasttime + time);
+    }
+  }
+#else /* CH_TIMEDELTA == 0 */
   p = vtlist.vt_next;
+#endif /* CH_TIMEDELTA == 0 */
   while (p->vt_time < time) {
     time -= p->vt_time;
     p = p->vt_next;
@@ -111,6 +239,39 @@ void chVTResetI(VirtualTimer *vtp) {
               "chVTResetI(), #1",
               "timer not set or already triggered");
 
+#if CH_TIMEDELTA > 0
+  /* Removing the first timer requires to reprogram the alarm.*/
+  if ((void *)vtlist.vt_next == (void *)vtp) {
+    systime_t elapsed;
+
+    vtlist.vt_next = vtp->vt_next;
+    vtlist.vt_next->vt_prev = (void *)&vtlist;
+    vtp->vt_func = (vtfunc_t)NULL;
+
+    /* If the list became empty then the alarm is stopped.*/
+    if ((void *)vtlist.vt_next == (void *)&vtlist) {
+      port_timer_stop_alarm();
+      return;
+    }
+
+    /* The delta of the removed timer is added to the new first timer.*/
+    vtlist.vt_next->vt_time += vtp->vt_time;
+
+    /* If the new deadline has already been reached then the alarm is
+       already pending.*/
+    elapsed = port_timer_get_time() - vtlist.vt_lasttime;
+    if (elapsed >= vtlist.vt_next->vt_time)
+      return;
+
+    /* Making sure to not schedule an alarm closer than CH_TIMEDELTA ticks
+       from now.*/
+    if (vtlist.vt_next->vt_time - elapsed < (systime_t)CH_TIMEDELTA)
+      port_timer_set_alarm(vtlist.vt_lasttime + elapsed + CH_TIMEDELTA);
+    else
+      port_timer_set_alarm(vtlist.vt_lasttime + vtlist.vt_next->vt_time);
+    return;
+  }
+#endif /* CH_TIMEDELTA > 0 */
   if (vtp->vt_next != (void *)&vtlist)
     vtp->vt_next->vt_time += vtp->vt_time;
   vtp->vt_prev->vt_next = vtp->vt_next;
@@ -118,6 +279,373 @@ void chVTResetI(VirtualTimer *vtp) {
   vtp->vt_func = (vtfunc_t)NULL;
 }
 
+/**
+ * @brief   Returns the time before the nearest virtual timer deadline.
+ * @details The function allows an idle loop or a simulator to skip the
+ *          ticks where no virtual timer expires.
+ * @note    In tick-less mode a deadline already reached is reported as a
+ *          zero delta.
+ *
+ * @param[out] dp       number of ticks from the current system time to the
+ *                      nearest deadline, not modified if there are no armed
+ *                      timers
+ * @return              The virtual timers state.
+ * @retval FALSE        if there is no armed timer.
+ * @retval TRUE         if at least one timer is armed.
+ *
+ * @iclass
+ */
+bool_t chVTGetNextDeltaI(systime_t *dp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(dp != NULL, "chVTGetNextDeltaI");
+
+  if ((void *)vtlist.vt_next == (void *)&vtlist)
+    return FALSE;
+#if CH_TIMEDELTA > 0
+  {
+    systime_t elapsed = port_timer_get_time() - vtlist.vt_lasttime;
+
+    *dp = elapsed >= vtlist.vt_next->vt_time ?
+          (systime_t)0 : vtlist.vt_next->vt_time - elapsed;
+  }
+#else
+  *dp = vtlist.vt_next->vt_time;
+#endif
+  return TRUE;
+}
+
+#if (CH_TIMEDELTA > 0) || defined(__DOXYGEN__)
+/**
+ * @brief   Virtual timers alarm handler.
+ * @details All the timers whose deadline has been reached are removed from
+ *          the list and their callbacks invoked, then the alarm is
+ *          programmed on the next deadline, if any.
+ * @note    In tick-less mode this function is invoked by
+ *          @p chSysTimerHandlerI() on the alarm interrupt.
+ * @note    The system lock is released before entering the callback and
+ *          re-acquired immediately after. It is callback's responsibility
+ *          to acquire the lock if needed. This is done in order to reduce
+ *          interrupts jitter when many timers are in use.
+ *
+ * @iclass
+ */
+void chVTDoTickI(void) {
+  VirtualTimer *vtp;
+  systime_t now, elapsed;
+
+  chDbgCheckClassI();
+
+  /* All the timers within the time window are triggered and removed, the
+     loop is stopped by the list header whose delta is greater than any
+     possible time window.*/
+  now = port_timer_get_time();
+  while ((vtp = vtlist.vt_next)->vt_time <=
+         (systime_t)(now - vtlist.vt_lasttime)) {
+    vtfunc_t fn = vtp->vt_func;
+
+    /* The timer deadline becomes the new list base time.*/
+    vtlist.vt_lasttime += vtp->vt_time;
+    vtp->vt_func = (vtfunc_t)NULL;
+    vtp->vt_next->vt_prev = (void *)&vtlist;
+    vtlist.vt_next = vtp->vt_next;
+    if ((void *)vtlist.vt_next == (void *)&vtlist)
+      port_timer_stop_alarm();
+    dbg_trace_event(CH_TRACE_TYPE_VT_FIRE, NULL, vtp);
+    chSysUnlockFromIsr();
+    fn(vtp->vt_par);
+    chSysLockFromIsr();
+  }
+
+  /* If the list is empty then the alarm has already been stopped.*/
+  if ((void *)vtlist.vt_next == (void *)&vtlist)
+    return;
+
+  /* The time is sampled again because the callbacks could have consumed
+     time, the alarm is not scheduled closer than CH_TIMEDELTA ticks from
+     now.*/
+  elapsed = port_timer_get_time() - vtlist.vt_lasttime;
+  if ((elapsed >= vtlist.vt_next->vt_time) ||
+      (vtlist.vt_next->vt_time - elapsed < (systime_t)CH_TIMEDELTA))
+    port_timer_set_alarm(vtlist.vt_lasttime + elapsed + CH_TIMEDELTA);
+  else
+    port_timer_set_alarm(vtlist.vt_lasttime + vtlist.vt_next->vt_time);
+}
+#endif /* CH_TIMEDELTA > 0 */
+
+#if ((CH_TIMEDELTA == 0) && CH_USE_VT_DEFERRED) || defined(__DOXYGEN__)
+/**
+ * @brief   Virtual timers ticker.
+ * @details The expired timers are moved into the pending timers list and
+ *          the timer service thread is awakened, the callbacks are invoked
+ *          by the timer service thread.
+ *
+ * @iclass
+ */
+void chVTDoTickI(void) {
+
+  chDbgCheckClassI();
+
+  vtlist.vt_systime++;
+  if (&vtlist != (VTList *)vtlist.vt_next) {
+    VirtualTimer *vtp;
+
+    --vtlist.vt_next->vt_time;
+    while (!(vtp = vtlist.vt_next)->vt_time) {
+      vtp->vt_next->vt_prev = (void *)&vtlist;
+      vtlist.vt_next = vtp->vt_next;
+      /* The delta is zero so the timer can be reset while pending.*/
+      vtp->vt_next = &vtlist.vt_pending;
+      vtp->vt_prev = vtlist.vt_pending.vt_prev;
+      vtp->vt_prev->vt_next = vtlist.vt_pending.vt_prev = vtp;
+    }
+  }
+  vt_pending_signal();
+}
+#endif /* (CH_TIMEDELTA == 0) && CH_USE_VT_DEFERRED */
+
+#else /* CH_USE_VT_WHEEL */
+
+/**
+ * @brief   Inserts a timer in the timing wheel.
+ * @details The level is selected by the time remaining before the deadline
+ *          and the slot by the deadline bits decoded by the level.
+ *
+ * @param[in] vtp       the @p VirtualTimer structure pointer, the
+ *                      @p vt_time field must contain the absolute deadline
+ * @param[in] base      the first system time not yet processed by the
+ *                      tick handler
+ */
+static void wheel_insert(VirtualTimer *vtp, systime_t base) {
+  systime_t delta = vtp->vt_time - base;
+  unsigned level = 0;
+  VTSlot *sp;
+
+  while ((level < VT_WHEEL_LEVELS - 1) &&
+         ((delta >> ((level + 1) * CH_VT_WHEEL_BITS)) != 0))
+    level++;
+  sp = &vtlist.vt_wheel[level][(vtp->vt_time >> (level * CH_VT_WHEEL_BITS)) &
+                               VT_WHEEL_MASK];
+  vtp->vt_next = (VirtualTimer *)sp;
+  vtp->vt_prev = sp->vt_prev;
+  vtp->vt_prev->vt_next = sp->vt_prev = vtp;
+}
+
+/**
+ * @brief   Detaches all the timers from a slot.
+ * @details The timers are moved in the list headed by @p hp, the slot is
+ *          left empty.
+ *
+ * @param[in] sp        pointer to the slot
+ * @param[out] hp       pointer to the list header receiving the timers
+ */
+static void wheel_detach(VTSlot *sp, VTSlot *hp) {
+
+  if ((void *)sp->vt_next == (void *)sp) {
+    hp->vt_next = hp->vt_prev = (VirtualTimer *)hp;
+    return;
+  }
+  hp->vt_next = sp->vt_next;
+  hp->vt_prev = sp->vt_prev;
+  hp->vt_next->vt_prev = hp->vt_prev->vt_next = (VirtualTimer *)hp;
+  sp->vt_next = sp->vt_prev = (VirtualTimer *)sp;
+}
+
+/**
+ * @brief   Virtual Timers initialization.
+ * @note    Internal use only.
+ *
+ * @notapi
+ */
+void _vt_init(void) {
+  unsigned level, slot;
+
+  for (level = 0; level < VT_WHEEL_LEVELS; level++) {
+    for (slot = 0; slot < VT_WHEEL_SLOTS; slot++) {
+      VTSlot *sp = &vtlist.vt_wheel[level][slot];
+
+      sp->vt_next = sp->vt_prev = (VirtualTimer *)sp;
+    }
+  }
+  vtlist.vt_systime = 0;
+#if CH_USE_VT_DEFERRED
+  vt_pending_init();
+#endif
+}
+
+/**
+ * @brief   Enables a virtual timer.
+ * @note    The associated function is invoked from interrupt context.
+ *
+ * @param[out] vtp      the @p VirtualTimer structure pointer
+ * @param[in] time      the number of ticks before the operation timeouts, the
+ *                      special values are handled as follow:
+ *                      - @a TIME_INFINITE is allowed but interpreted as a
+ *                        normal time specification.
+ *                      - @a TIME_IMMEDIATE this value is not allowed.
+ *                      .
+ * @param[in] vtfunc    the timer callback function. After invoking the
+ *                      callback the timer is disabled and the structure can
+ *                      be disposed or reused.
+ * @param[in] par       a parameter that will be passed to the callback
+ *                      function
+ *
+ * @iclass
+ */
+void chVTSetI(VirtualTimer *vtp, systime_t time, vtfunc_t vtfunc, void *par) {
+
+  chDbgCheckClassI();
+  chDbgCheck((vtp != NULL) && (vtfunc != NULL) && (time != TIME_IMMEDIATE),
+             "chVTSetI");
+
+  vtp->vt_par = par;
+  vtp->vt_func = vtfunc;
+  vtp->vt_time = vtlist.vt_systime + time;
+  wheel_insert(vtp, vtlist.vt_systime + 1);
+}
+
+/**
+ * @brief   Disables a Virtual Timer.
+ * @note    The timer MUST be active when this function is invoked.
+ *
+ * @param[in] vtp       the @p VirtualTimer structure pointer
+ *
+ * @iclass
+ */
+void chVTResetI(VirtualTimer *vtp) {
+
+  chDbgCheckClassI();
+  chDbgCheck(vtp != NULL, "chVTResetI");
+  chDbgAssert(vtp->vt_func != NULL,
+              "chVTResetI(), #1",
+              "timer not set or already triggered");
+
+  vtp->vt_prev->vt_next = vtp->vt_next;
+  vtp->vt_next->vt_prev = vtp->vt_prev;
+  vtp->vt_func = (vtfunc_t)NULL;
+}
+
+/**
+ * @brief   Returns the time before the nearest virtual timer deadline.
+ * @details The function allows an idle loop or a simulator to skip the
+ *          ticks where no virtual timer expires.
+ * @note    Each level is scanned from the slot following the current one,
+ *          the first slot containing timers also contains the nearest
+ *          deadlines of the level. The upper levels are not scanned when
+ *          their next cascade time is not nearer than the deadline
+ *          already found.
+ *
+ * @param[out] dp       number of ticks from the current system time to the
+ *                      nearest deadline, not modified if there are no armed
+ *                      timers
+ * @return              The virtual timers state.
+ * @retval FALSE        if there is no armed timer.
+ * @retval TRUE         if at least one timer is armed.
+ *
+ * @iclass
+ */
+bool_t chVTGetNextDeltaI(systime_t *dp) {
+  systime_t now = vtlist.vt_systime;
+  systime_t delta = (systime_t)-1;
+  bool_t armed = FALSE;
+  unsigned level, i;
+
+  chDbgCheckClassI();
+  chDbgCheck(dp != NULL, "chVTGetNextDeltaI");
+
+  for (level = 0; level < VT_WHEEL_LEVELS; level++) {
+    unsigned shift = level * CH_VT_WHEEL_BITS;
+    systime_t block = (now >> shift) + 1;
+
+    /* The timers of this level and of the upper levels cannot expire before
+       the start of the next block of this level.*/
+    if (armed && ((systime_t)((block << shift) - now) >= delta))
+      break;
+    for (i = 0; i < VT_WHEEL_SLOTS; i++) {
+      VTSlot *sp = &vtlist.vt_wheel[level][(block + i) & VT_WHEEL_MASK];
+      VirtualTimer *vtp;
+
+      if ((void *)sp->vt_next == (void *)sp)
+        continue;
+      for (vtp = sp->vt_next; (void *)vtp != (void *)sp; vtp = vtp->vt_next) {
+        if ((systime_t)(vtp->vt_time - now) < delta)
+          delta = (systime_t)(vtp->vt_time - now);
+      }
+      armed = TRUE;
+      break;
+    }
+  }
+  if (armed)
+    *dp = delta;
+  return armed;
+}
+
+/**
+ * @brief   Virtual timers ticker.
+ * @details The system time is advanced, the upper levels are cascaded when
+ *          the lower levels wrap, then all the timers in the current slot
+ *          of the first level are triggered.
+ * @note    The system lock is released before entering the callback and
+ *          re-acquired immediately after. It is callback's responsibility
+ *          to acquire the lock if needed. This is done in order to reduce
+ *          interrupts jitter when many timers are in use.
+ *
+ * @iclass
+ */
+void chVTDoTickI(void) {
+  systime_t now;
+  unsigned level;
+  VTSlot list;
+  VirtualTimer *vtp;
+
+  chDbgCheckClassI();
+
+  now = ++vtlist.vt_systime;
+
+  /* Cascading the upper levels, a level is cascaded only when all the
+     levels below it wrapped.*/
+  for (level = 1;
+       (level < VT_WHEEL_LEVELS) &&
+       (((now >> ((level - 1) * CH_VT_WHEEL_BITS)) & VT_WHEEL_MASK) == 0);
+       level++) {
+    wheel_detach(&vtlist.vt_wheel[level][(now >> (level * CH_VT_WHEEL_BITS)) &
+                                         VT_WHEEL_MASK], &list);
+    while ((void *)(vtp = list.vt_next) != (void *)&list) {
+      list.vt_next = vtp->vt_next;
+      wheel_insert(vtp, now);
+    }
+  }
+
+#if CH_USE_VT_DEFERRED
+  /* The timers in the current slot are appended to the pending timers
+     list as a whole.*/
+  wheel_detach(&vtlist.vt_wheel[0][now & VT_WHEEL_MASK], &list);
+  if ((void *)list.vt_next != (void *)&list) {
+    list.vt_next->vt_prev = vtlist.vt_pending.vt_prev;
+    list.vt_prev->vt_next = (VirtualTimer *)&vtlist.vt_pending;
+    vtlist.vt_pending.vt_prev->vt_next = list.vt_next;
+    vtlist.vt_pending.vt_prev = list.vt_prev;
+  }
+  vt_pending_signal();
+#else /* !CH_USE_VT_DEFERRED */
+  /* The timers in the current slot are moved in a local list before
+     triggering them, callbacks could re-arm timers in the same slot.*/
+  wheel_detach(&vtlist.vt_wheel[0][now & VT_WHEEL_MASK], &list);
+  while ((void *)(vtp = list.vt_next) != (void *)&list) {
+    vtfunc_t fn = vtp->vt_func;
+
+    vtp->vt_func = (vtfunc_t)NULL;
+    vtp->vt_next->vt_prev = (VirtualTimer *)&list;
+    list.vt_next = vtp->vt_next;
+    dbg_trace_event(CH_TRACE_TYPE_VT_FIRE, NULL, vtp);
+    chSysUnlockFromIsr();
+    fn(vtp->vt_par);
+    chSysLockFromIsr();
+  }
+#endif /* !CH_USE_VT_DEFERRED */
+}
+#endif /* CH_USE_VT_WHEEL */
+
 /**
  * @brief   Checks if the current system time is within the specified time
  *          window.
@@ -0,0 +1,296 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @file    chworkq.c
+ * @brief   Work queues code.
+ *
+ * @addtogroup workqueues
+ * @details Work queues allow interrupt handlers to defer work to thread
+ *          context without a dedicated thread for each driver.<br>
+ *          <h2>Operation mode</h2>
+ *          A work queue is served by a worker thread, an interrupt handler
+ *          or a thread enqueues a preallocated @p WorkItem and the worker
+ *          invokes its work function with the kernel unlocked. The worker
+ *          executes all the pending items, including the items enqueued
+ *          while it is running, before sleeping again, so a burst of
+ *          interrupts costs a single worker activation.<br>
+ *          Priority tiers are obtained by starting several work queues with
+ *          workers at different priorities, the items of a queue are
+ *          executed in FIFO order.<br>
+ *          An item already pending is not enqueued again, the duplicate
+ *          request is counted and dropped. An item is no more pending when
+ *          its work function is invoked so the function is allowed to
+ *          enqueue its own item again.<br>
+ *          A stopped queue rejects the enqueue operations until its worker
+ *          is started again, the items enqueued before the stop request
+ *          are executed before the worker terminates.<br>
+ *          Each queue keeps statistics about the executed items, the
+ *          suppressed duplicates, the batch sizes and the latency between
+ *          the enqueue operation and the start of the work function.
+ * @pre     In order to use the work queues APIs the @p CH_USE_WORKQUEUES
+ *          option must be enabled in @p chconf.h.
+ * @{
+ */
+
+#include "ch.h"
+
+#if CH_USE_WORKQUEUES || defined(__DOXYGEN__)
+
+/**
+ * @brief   Work queue worker thread.
+ *
+ * @param[in] p         pointer to the @p WorkQueue structure
+ * @return              The thread exit code, always zero.
+ */
+static msg_t wq_worker(void *p) {
+  WorkQueue *wqp = (WorkQueue *)p;
+  WorkQueueStats *wsp = &wqp->wq_stats;
+
+  chRegSetThreadName(wqp->wq_name);
+  chSysLock();
+  while (TRUE) {
+    uint32_t n = 0;
+
+    while (wqp->wq_head != NULL) {
+      WorkItem *wip = wqp->wq_head;
+      uint32_t lat = CH_WQ_TIMESTAMP() - wip->wi_stamp;
+
+      wqp->wq_head = wip->wi_next;
+      wip->wi_queue = NULL;
+      if (lat < wsp->ws_minlat)
+        wsp->ws_minlat = lat;
+      if (lat > wsp->ws_maxlat)
+        wsp->ws_maxlat = lat;
+      wsp->ws_sumlat += lat;
+      wsp->ws_executed++;
+      n++;
+      chSysUnlock();
+      wip->wi_func(wip->wi_arg);
+      chSysLock();
+    }
+    if (n > 0) {
+      wsp->ws_batches++;
+      if (n > wsp->ws_maxbatch)
+        wsp->ws_maxbatch = n;
+    }
+    if (chThdShouldTerminate())
+      break;
+    wqp->wq_waiting = currp;
+    chSchGoSleepS(THD_STATE_SUSPENDED);
+  }
+  wqp->wq_worker = NULL;
+  chSysUnlock();
+  return 0;
+}
+
+/**
+ * @brief   Initializes a @p WorkQueue structure.
+ *
+ * @param[out] wqp      pointer to a @p WorkQueue structure
+ *
+ * @init
+ */
+void chWQInit(WorkQueue *wqp) {
+
+  chDbgCheck(wqp != NULL, "chWQInit");
+
+  wqp->wq_head = NULL;
+  wqp->wq_tail = NULL;
+  wqp->wq_worker = NULL;
+  wqp->wq_waiting = NULL;
+  wqp->wq_name = NULL;
+  wqp->wq_stopped = FALSE;
+  chWQResetStatsI(wqp);
+}
+
+/**
+ * @brief   Starts the worker thread of a work queue.
+ * @details The worker thread is created into the specified working area,
+ *          the items already pending are executed immediately.
+ * @pre     The work queue must not have a running worker.
+ *
+ * @param[in] wqp       pointer to the @p WorkQueue structure
+ * @param[out] wsp      pointer to a working area dedicated to the worker
+ * @param[in] size      size of the working area
+ * @param[in] prio      the priority level of the worker
+ * @param[in] name      the worker thread name
+ * @return              The pointer to the worker @p Thread structure.
+ *
+ * @api
+ */
+Thread *chWQStart(WorkQueue *wqp, void *wsp, size_t size, tprio_t prio,
+                  const char *name) {
+
+  chDbgCheck(wqp != NULL, "chWQStart");
+  chDbgAssert(wqp->wq_worker == NULL, "chWQStart(), #1", "already started");
+
+  wqp->wq_name = name;
+  wqp->wq_stopped = FALSE;
+  wqp->wq_worker = chThdCreateStatic(wsp, size, prio, wq_worker, wqp);
+  return wqp->wq_worker;
+}
+
+/**
+ * @brief   Stops the worker thread of a work queue.
+ * @details The worker executes the pending items then terminates, the
+ *          termination can be awaited using @p chThdWait() on the pointer
+ *          returned by @p chWQStart(). From this point the enqueue
+ *          operations are rejected until the queue is started again.
+ *
+ * @param[in] wqp       pointer to the @p WorkQueue structure
+ *
+ * @api
+ */
+void chWQStop(WorkQueue *wqp) {
+
+  chDbgCheck(wqp != NULL, "chWQStop");
+
+  chSysLock();
+  wqp->wq_stopped = TRUE;
+  if (wqp->wq_worker != NULL) {
+    wqp->wq_worker->p_flags |= THD_TERMINATE;
+    if (wqp->wq_waiting != NULL) {
+      chSchWakeupS(wqp->wq_waiting, RDY_OK);
+      wqp->wq_waiting = NULL;
+    }
+  }
+  chSysUnlock();
+}
+
+/**
+ * @brief   Initializes a @p WorkItem structure.
+ *
+ * @param[out] wip      pointer to a @p WorkItem structure
+ * @param[in] func      the work function
+ * @param[in] arg       the work function argument
+ *
+ * @init
+ */
+void chWIInit(WorkItem *wip, wqfunc_t func, void *arg) {
+
+  chDbgCheck((wip != NULL) && (func != NULL), "chWIInit");
+
+  wip->wi_next = NULL;
+  wip->wi_queue = NULL;
+  wip->wi_func = func;
+  wip->wi_arg = arg;
+  wip->wi_stamp = 0;
+}
+
+/**
+ * @brief   Enqueues a work item.
+ *
+ * @param[in] wqp       pointer to the @p WorkQueue structure
+ * @param[in] wip       pointer to the @p WorkItem structure
+ * @return              The operation status.
+ * @retval TRUE         if the item has been enqueued.
+ * @retval FALSE        if the item was already pending or the queue has
+ *                      been stopped.
+ *
+ * @api
+ */
+bool_t chWQEnqueue(WorkQueue *wqp, WorkItem *wip) {
+  bool_t b;
+
+  chSysLock();
+  b = chWQEnqueueI(wqp, wip);
+  chSchRescheduleS();
+  chSysUnlock();
+  return b;
+}
+
+/**
+ * @brief   Enqueues a work item.
+ * @details The item is appended to the queue and the worker is awakened if
+ *          waiting, if the item is already pending, on this or another
+ *          queue, then the request is dropped and counted as a duplicate
+ *          by the queue the item is pending on. The request is also
+ *          dropped if the queue has been stopped, the item is left not
+ *          pending.
+ * @post    This function does not reschedule so a call to a rescheduling
+ *          function must be performed before unlocking the kernel. Note
+ *          that interrupt handlers always reschedule on exit so an
+ *          explicit reschedule must not be performed in ISRs.
+ *
+ * @param[in] wqp       pointer to the @p WorkQueue structure
+ * @param[in] wip       pointer to the @p WorkItem structure
+ * @return              The operation status.
+ * @retval TRUE         if the item has been enqueued.
+ * @retval FALSE        if the item was already pending or the queue has
+ *                      been stopped.
+ *
+ * @iclass
+ */
+bool_t chWQEnqueueI(WorkQueue *wqp, WorkItem *wip) {
+
+  chDbgCheckClassI();
+  chDbgCheck((wqp != NULL) && (wip != NULL), "chWQEnqueueI");
+
+  if (wqp->wq_stopped)
+    return FALSE;
+  if (wip->wi_queue != NULL) {
+    wip->wi_queue->wq_stats.ws_dups++;
+    return FALSE;
+  }
+  wip->wi_next = NULL;
+  wip->wi_queue = wqp;
+  wip->wi_stamp = CH_WQ_TIMESTAMP();
+  if (wqp->wq_head == NULL)
+    wqp->wq_head = wip;
+  else
+    wqp->wq_tail->wi_next = wip;
+  wqp->wq_tail = wip;
+  if (wqp->wq_waiting != NULL) {
+    chSchReadyI(wqp->wq_waiting);
+    wqp->wq_waiting = NULL;
+  }
+  return TRUE;
+}
+
+/**
+ * @brief   Resets the statistics of a work queue.
+ *
+ * @param[in] wqp       pointer to the @p WorkQueue structure
+ *
+ * @iclass
+ */
+void chWQResetStatsI(WorkQueue *wqp) {
+  WorkQueueStats *wsp = &wqp->wq_stats;
+
+  wsp->ws_executed = 0;
+  wsp->ws_dups = 0;
+  wsp->ws_batches = 0;
+  wsp->ws_maxbatch = 0;
+  wsp->ws_minlat = (uint32_t)-1;
+  wsp->ws_maxlat = 0;
+  wsp->ws_sumlat = 0;
+}
+
+#endif /* CH_USE_WORKQUEUES */
+
+/** @} */
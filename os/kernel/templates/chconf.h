@@ -70,6 +70,78 @@
 #define CH_TIME_QUANTUM                 20
 #endif
 
+/**
+ * @brief   Time delta constant for the tick-less mode.
+ * @note    If this value is zero then the system uses the classic
+ *          periodic tick. A non-zero value enables the tick-less mode,
+ *          the value represents the minimum number of ticks that is safe
+ *          to specify in a timeout directive. The port layer must support
+ *          the tick-less mode, @p CH_TIME_QUANTUM must be zero and
+ *          @p CH_DBG_THREADS_PROFILING must be disabled.
+ * @note    @p CH_DBG_THREADS_PROFILING defaults to @p TRUE in this file,
+ *          it must be explicitly set to @p FALSE together with this
+ *          option or the build fails.
+ */
+#if !defined(CH_TIMEDELTA) || defined(__DOXYGEN__)
+#define CH_TIMEDELTA                    0
+#endif
+
+/**
+ * @brief   Virtual timers hierarchical timing wheel.
+ * @details If enabled the virtual timers are kept in a hierarchical timing
+ *          wheel instead of a delta list, set and reset become constant
+ *          time operations.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Not compatible with the tick-less mode.
+ */
+#if !defined(CH_USE_VT_WHEEL) || defined(__DOXYGEN__)
+#define CH_USE_VT_WHEEL                 FALSE
+#endif
+
+/**
+ * @brief   Timing wheel level size.
+ * @details Number of system time bits decoded by each level of the timing
+ *          wheel, each level has <tt>2^CH_VT_WHEEL_BITS</tt> slots.
+ */
+#if !defined(CH_VT_WHEEL_BITS) || defined(__DOXYGEN__)
+#define CH_VT_WHEEL_BITS                6
+#endif
+
+/**
+ * @brief   Deferred virtual timers callbacks.
+ * @details If enabled the expired virtual timers are moved by the tick
+ *          handler into a pending list and their callbacks are invoked by
+ *          a timer service thread, this bounds the tick interrupt duration.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Not compatible with the tick-less mode.
+ */
+#if !defined(CH_USE_VT_DEFERRED) || defined(__DOXYGEN__)
+#define CH_USE_VT_DEFERRED              FALSE
+#endif
+
+/**
+ * @brief   Timer service thread priority.
+ */
+#if !defined(CH_VT_SERVICE_PRIORITY) || defined(__DOXYGEN__)
+#define CH_VT_SERVICE_PRIORITY          (HIGHPRIO - 1)
+#endif
+
+/**
+ * @brief   Maximum number of deferred callbacks invoked for each tick.
+ */
+#if !defined(CH_VT_SERVICE_BUDGET) || defined(__DOXYGEN__)
+#define CH_VT_SERVICE_BUDGET            16
+#endif
+
+/**
+ * @brief   Timer service thread stack size.
+ */
+#if !defined(CH_VT_SERVICE_STACK_SIZE) || defined(__DOXYGEN__)
+#define CH_VT_SERVICE_STACK_SIZE        128
+#endif
+
 /**
  * @brief   Managed RAM size.
  * @details Size of the RAM area to be managed by the OS. If set to zero
@@ -123,6 +195,47 @@
 #define CH_OPTIMIZE_SPEED               TRUE
 #endif
 
+/**
+ * @brief   Bitmap indexed ready list.
+ * @details If enabled then the ready list keeps a bitmap of the occupied
+ *          priority levels, the insertion of a thread in the ready list
+ *          becomes a constant time operation regardless of the number of
+ *          ready threads.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires 4 bytes per priority level plus the bitmap in the
+ *          ready list header.
+ */
+#if !defined(CH_USE_READYLIST_BITMAP) || defined(__DOXYGEN__)
+#define CH_USE_READYLIST_BITMAP         FALSE
+#endif
+
+/**
+ * @brief   EDF scheduling class.
+ * @details If enabled then the threads can enter the earliest deadline first
+ *          scheduling class using @p chEdfEnter(), the EDF threads run at
+ *          the @p CH_EDF_PRIORITY level ordered by absolute deadline and
+ *          their deadline misses are counted.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_EDF) || defined(__DOXYGEN__)
+#define CH_USE_EDF                      FALSE
+#endif
+
+/**
+ * @brief   Priority level reserved to the EDF threads.
+ * @details Threads with higher priority preempt the EDF threads, threads
+ *          with lower priority only run when no EDF thread is ready. The
+ *          level should not be used by other threads.
+ *
+ * @note    The default is @p HIGHPRIO-2, one level below the timer
+ *          service thread, the two levels must be different.
+ */
+#if !defined(CH_EDF_PRIORITY) || defined(__DOXYGEN__)
+#define CH_EDF_PRIORITY                 (HIGHPRIO - 2)
+#endif
+
 /** @} */
 
 /*===========================================================================*/
@@ -197,6 +310,35 @@
 #define CH_USE_MUTEXES                  TRUE
 #endif
 
+/**
+ * @brief   Priority ceiling mutexes.
+ * @details If enabled then the mutexes can be initialized with a static
+ *          ceiling priority using @p chMtxInitCeiling(), the locking thread
+ *          is immediately raised to the ceiling priority and the priority
+ *          inheritance chain walk is not performed.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MUTEXES.
+ */
+#if !defined(CH_USE_MUTEXES_CEILING) || defined(__DOXYGEN__)
+#define CH_USE_MUTEXES_CEILING          FALSE
+#endif
+
+/**
+ * @brief   Adaptive wait mode.
+ * @details If enabled then semaphores and mutexes can be configured, using
+ *          @p chSemSetAdaptive() and @p chMtxSetAdaptive(), to yield to the
+ *          other ready threads for a bounded number of iterations before
+ *          putting the waiting thread to sleep. Semaphores also spin with
+ *          interrupts enabled when there are no other ready threads.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_SEMAPHORES or @p CH_USE_MUTEXES.
+ */
+#if !defined(CH_USE_ADAPTIVE_WAIT) || defined(__DOXYGEN__)
+#define CH_USE_ADAPTIVE_WAIT            FALSE
+#endif
+
 /**
  * @brief   Conditional Variables APIs.
  * @details If enabled then the conditional variables APIs are included
@@ -221,6 +363,19 @@
 #define CH_USE_CONDVARS_TIMEOUT         TRUE
 #endif
 
+/**
+ * @brief   Readers-writer locks APIs.
+ * @details If enabled then the readers-writer locks APIs are included in
+ *          the kernel. The locks have a writer preference policy, timeouts
+ *          and priority inheritance on the writer side.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MUTEXES.
+ */
+#if !defined(CH_USE_RWLOCKS) || defined(__DOXYGEN__)
+#define CH_USE_RWLOCKS                  FALSE
+#endif
+
 /**
  * @brief   Events Flags APIs.
  * @details If enabled then the event flags APIs are included in the kernel.
@@ -266,6 +421,19 @@
 #define CH_USE_MESSAGES_PRIORITY        FALSE
 #endif
 
+/**
+ * @brief   Asynchronous message ports APIs.
+ * @details If enabled then the message ports APIs are included in the
+ *          kernel, the clients post requests without blocking and wait or
+ *          poll the replies later using futures.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MESSAGES.
+ */
+#if !defined(CH_USE_MESSAGES_ASYNC) || defined(__DOXYGEN__)
+#define CH_USE_MESSAGES_ASYNC           FALSE
+#endif
+
 /**
  * @brief   Mailboxes APIs.
  * @details If enabled then the asynchronous messages (mailboxes) APIs are
@@ -278,6 +446,17 @@
 #define CH_USE_MAILBOXES                TRUE
 #endif
 
+/**
+ * @brief   Work queues APIs.
+ * @details If enabled then the work queues APIs are included in the kernel,
+ *          interrupt handlers can defer work items to worker threads.
+ *
+ * @note    The default is @p FALSE.
+ */
+#if !defined(CH_USE_WORKQUEUES) || defined(__DOXYGEN__)
+#define CH_USE_WORKQUEUES               FALSE
+#endif
+
 /**
  * @brief   I/O Queues APIs.
  * @details If enabled then the I/O queues APIs are included in the kernel.
@@ -288,6 +467,19 @@
 #define CH_USE_QUEUES                   TRUE
 #endif
 
+/**
+ * @brief   Lock-free I/O rings APIs.
+ * @details If enabled then the single producer, single consumer byte rings
+ *          are included in the kernel. The rings are lock-free variants of
+ *          the I/O queues supporting bulk transfers.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_QUEUES.
+ */
+#if !defined(CH_USE_QUEUES_RINGS) || defined(__DOXYGEN__)
+#define CH_USE_QUEUES_RINGS             FALSE
+#endif
+
 /**
  * @brief   Core Memory Manager APIs.
  * @details If enabled then the core memory manager APIs are included
@@ -299,6 +491,19 @@
 #define CH_USE_MEMCORE                  TRUE
 #endif
 
+/**
+ * @brief   Core Memory Manager regions.
+ * @details If enabled the core memory manager can handle additional memory
+ *          regions with attributes, aligned and placement-hinted allocations
+ *          are also available.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MEMCORE.
+ */
+#if !defined(CH_USE_MEMCORE_REGIONS) || defined(__DOXYGEN__)
+#define CH_USE_MEMCORE_REGIONS          FALSE
+#endif
+
 /**
  * @brief   Heap Allocator APIs.
  * @details If enabled then the memory heap allocator APIs are included
@@ -327,6 +532,34 @@
 #define CH_USE_MALLOC_HEAP              FALSE
 #endif
 
+/**
+ * @brief   TLSF heap allocator.
+ * @details If enabled the heap allocator uses a two-level segregated fit
+ *          algorithm with constant time allocation and release instead of
+ *          the first-fit one. The heap APIs are unchanged.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_HEAP.
+ * @note    Mutually exclusive with @p CH_USE_MALLOC_HEAP.
+ */
+#if !defined(CH_USE_HEAP_TLSF) || defined(__DOXYGEN__)
+#define CH_USE_HEAP_TLSF                FALSE
+#endif
+
+/**
+ * @brief   Per-thread heap caches.
+ * @details If enabled the threads can attach a @p HeapCache that serves
+ *          the small allocations from per-thread magazines of released
+ *          blocks without locking the heap.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_HEAP.
+ * @note    Not compatible with @p CH_USE_MALLOC_HEAP.
+ */
+#if !defined(CH_USE_HEAP_CACHE) || defined(__DOXYGEN__)
+#define CH_USE_HEAP_CACHE               FALSE
+#endif
+
 /**
  * @brief   Memory Pools Allocator APIs.
  * @details If enabled then the memory pools allocator APIs are included
@@ -338,6 +571,21 @@
 #define CH_USE_MEMPOOLS                 TRUE
 #endif
 
+/**
+ * @brief   Lock-free Memory Pools APIs.
+ * @details If enabled then the lock-free memory pools APIs are included
+ *          in the kernel, the objects are allocated and released without
+ *          entering the kernel lock.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires @p CH_USE_MEMPOOLS.
+ * @note    Requires a double word compare-and-swap instruction, on x86-64
+ *          the code must be compiled with @p -mcx16.
+ */
+#if !defined(CH_USE_MEMPOOLS_LOCKFREE) || defined(__DOXYGEN__)
+#define CH_USE_MEMPOOLS_LOCKFREE        FALSE
+#endif
+
 /**
  * @brief   Dynamic Threads APIs.
  * @details If enabled then the dynamic threads creation APIs are included
@@ -397,9 +645,13 @@
 /**
  * @brief   Debug option, trace buffer.
  * @details If enabled then the context switch circular trace buffer is
- *          activated.
+ *          activated. The buffer also records the ready list insertions,
+ *          the ISRs enter and leave, the virtual timers expirations and the
+ *          semaphores, mutexes and mailboxes operations, the records can be
+ *          exported using @p chDbgTraceStart() and @p chDbgTraceDrain().
  *
  * @note    The default is @p FALSE.
+ * @note    The trace buffer size is specified by @p CH_TRACE_BUFFER_SIZE.
  */
 #if !defined(CH_DBG_ENABLE_TRACE) || defined(__DOXYGEN__)
 #define CH_DBG_ENABLE_TRACE             FALSE
@@ -423,7 +675,8 @@
  * @brief   Debug option, stacks initialization.
  * @details If enabled then the threads working area is filled with a byte
  *          value when a thread is created. This can be useful for the
- *          runtime measurement of the used stack.
+ *          runtime measurement of the used stack, see
+ *          @p chThdGetStackUnused().
  *
  * @note    The default is @p FALSE.
  */
@@ -444,6 +697,21 @@
 #define CH_DBG_THREADS_PROFILING        TRUE
 #endif
 
+/**
+ * @brief   Debug option, threads accounting.
+ * @details If enabled then the time consumed by each thread and by the ISRs
+ *          is measured using the port realtime counter at each context
+ *          switch and ISR enter and leave, the load of each thread is
+ *          also computed over a rolling window.
+ *
+ * @note    The default is @p FALSE.
+ * @note    Requires a port realtime counter and @p CH_USE_REGISTRY.
+ * @note    The window length is specified by @p CH_ACCOUNTING_WINDOW.
+ */
+#if !defined(CH_DBG_THREADS_ACCOUNTING) || defined(__DOXYGEN__)
+#define CH_DBG_THREADS_ACCOUNTING       FALSE
+#endif
+
 /** @} */
 
 /*===========================================================================*/
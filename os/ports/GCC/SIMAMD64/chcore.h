@@ -0,0 +1,308 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006,2007,2008,2009,2010,
+                 2011,2012,2013 Giovanni Di Sirio.
+
+    This file is part of ChibiOS/RT.
+
+    ChibiOS/RT is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    ChibiOS/RT is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+                                      ---
+
+    A special exception to the GPL can be applied should you wish to distribute
+    a combined work that includes ChibiOS/RT, without being obliged to provide
+    the source code for any proprietary components. See the file exception.txt
+    for full details of how and when the exception can be applied.
+*/
+
+/**
+ * @addtogroup SIMAMD64_CORE
+ * @{
+ */
+
+#ifndef _CHCORE_H_
+#define _CHCORE_H_
+
+#if CH_DBG_ENABLE_STACK_CHECK
+#error "option CH_DBG_ENABLE_STACK_CHECK not supported by this port"
+#endif
+
+/**
+ * Macro defining the a simulated architecture into x86-64.
+ */
+#define CH_ARCHITECTURE_SIMAMD64
+
+/**
+ * Name of the implemented architecture.
+ */
+#define CH_ARCHITECTURE_NAME            "Simulator"
+
+/**
+ * @brief   Name of the architecture variant (optional).
+ */
+#define CH_CORE_VARIANT_NAME            "x86-64 (SSE)"
+
+/**
+ * @brief   Name of the compiler supported by this port.
+ */
+#define CH_COMPILER_NAME                "GCC " __VERSION__
+
+/**
+ * @brief   Port-specific information string.
+ */
+#define CH_PORT_INFO                    "No preemption"
+
+/**
+ * 16 bytes stack alignment.
+ */
+typedef struct {
+  uint8_t a[16];
+} stkalign_t __attribute__((aligned(16)));
+
+/**
+ * Generic x86-64 register.
+ */
+typedef void *regx86;
+
+/**
+ * Interrupt saved context.
+ * This structure represents the stack frame saved during a preemption-capable
+ * interrupt handler.
+ */
+struct extctx {
+};
+
+/**
+ * System saved context.
+ * @note    Only the System V ABI callee-saved state is preserved: the
+ *          general purpose registers plus the SSE control/status register
+ *          and the x87 control word. The XMM registers are caller-saved
+ *          and are never live across a @p port_switch() call.
+ */
+struct intctx {
+  uint32_t  mxcsr;
+  uint16_t  fpucw;
+  uint16_t  _pad;
+  regx86    r15;
+  regx86    r14;
+  regx86    r13;
+  regx86    r12;
+  regx86    rbx;
+  regx86    rbp;
+  regx86    rip;
+};
+
+/**
+ * Platform dependent part of the @p Thread structure.
+ * This structure usually contains just the saved stack pointer defined as a
+ * pointer to a @p intctx structure.
+ */
+struct context {
+  struct intctx volatile *rsp;
+};
+
+/**
+ * Saved stack pointer of a thread not currently running, used by debug
+ * and monitoring code.
+ */
+#define port_thread_sp(tp) ((void *)(tp)->p_ctx.rsp)
+
+/**
+ * Platform dependent part of the @p chThdCreateI() API.
+ * This code usually setup the context switching frame represented by a
+ * @p intctx structure.
+ * @note    The frame is placed so that the stack pointer is 16 bytes aligned
+ *          when @p _port_thread_trampoline is entered, the work function
+ *          and its parameter travel in @p r12 and @p r13.
+ */
+#define SETUP_CONTEXT(workspace, wsize, pf, arg) {                          \
+  uint8_t *rsp = (uint8_t *)workspace + wsize;                              \
+  rsp = (uint8_t *)((uintptr_t)rsp & ~(uintptr_t)15) - 16;                  \
+  rsp -= sizeof(struct intctx);                                             \
+  ((struct intctx *)rsp)->mxcsr = 0x1F80;                                   \
+  ((struct intctx *)rsp)->fpucw = 0x037F;                                   \
+  ((struct intctx *)rsp)->_pad  = 0;                                        \
+  ((struct intctx *)rsp)->r15   = 0;                                        \
+  ((struct intctx *)rsp)->r14   = 0;                                        \
+  ((struct intctx *)rsp)->r13   = (void *)(arg);                            \
+  ((struct intctx *)rsp)->r12   = (void *)(pf);                             \
+  ((struct intctx *)rsp)->rbx   = 0;                                        \
+  ((struct intctx *)rsp)->rbp   = 0;                                        \
+  ((struct intctx *)rsp)->rip   = (void *)_port_thread_trampoline;          \
+  tp->p_ctx.rsp = (struct intctx *)rsp;                                     \
+}
+
+/**
+ * Stack size for the system idle thread.
+ */
+#ifndef PORT_IDLE_THREAD_STACK_SIZE
+#define PORT_IDLE_THREAD_STACK_SIZE     256
+#endif
+
+/**
+ * Per-thread stack overhead for interrupts servicing, it is used in the
+ * calculation of the correct working area size.
+ * It requires stack space because the simulated "interrupt handlers" can
+ * invoke host library functions inside so it better have a lot of space.
+ */
+#ifndef PORT_INT_REQUIRED_STACK
+#define PORT_INT_REQUIRED_STACK         32768
+#endif
+
+/**
+ * Enforces a correct alignment for a stack area size value.
+ */
+#define STACK_ALIGN(n) ((((n) - 1) | (sizeof(stkalign_t) - 1)) + 1)
+
+ /**
+  * Computes the thread working area global size.
+  */
+#define THD_WA_SIZE(n) STACK_ALIGN(sizeof(Thread) +                     \
+                                   sizeof(void *) * 4 +                 \
+                                   sizeof(struct intctx) +              \
+                                   sizeof(struct extctx) +              \
+                                   (n) + (PORT_INT_REQUIRED_STACK))
+
+/**
+ * Macro used to allocate a thread working area aligned as both position and
+ * size.
+ */
+#define WORKING_AREA(s, n) stkalign_t s[THD_WA_SIZE(n) / sizeof(stkalign_t)]
+
+/**
+ * IRQ prologue code, inserted at the start of all IRQ handlers enabled to
+ * invoke system APIs.
+ */
+#define PORT_IRQ_PROLOGUE()
+
+/**
+ * IRQ epilogue code, inserted at the end of all IRQ handlers enabled to
+ * invoke system APIs.
+ */
+#define PORT_IRQ_EPILOGUE()
+
+/**
+ * IRQ handler function declaration.
+ */
+#define PORT_IRQ_HANDLER(id) void id(void)
+
+/**
+ * Simulator initialization.
+ */
+#define port_init()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_lock() asm volatile("nop")
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_unlock() asm volatile("nop")
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_lock_from_isr()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_unlock_from_isr()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_disable()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_suspend()
+
+/**
+ * Does nothing in this simulator.
+ */
+#define port_enable()
+
+/**
+ * In the simulator this serves the simulated interrupt sources, the host
+ * thread can block until one of them becomes ready.
+ */
+#define port_wait_for_interrupt() WaitIntSources()
+
+/**
+ * The simulator supports the tick-less mode, the alarm is implemented in
+ * the HAL using the host timers.
+ */
+#define PORT_SUPPORTS_TICKLESS          TRUE
+
+/**
+ * The simulator supports a realtime counter, the counter is implemented in
+ * the HAL using the host timers.
+ */
+#define PORT_SUPPORTS_RT                TRUE
+
+/**
+ * The simulator supports the atomic compare-and-swap operations when the
+ * compiler provides the 128 bits GCC builtins (-mcx16).
+ */
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define PORT_SUPPORTS_ATOMIC_CAS        TRUE
+#else
+#define PORT_SUPPORTS_ATOMIC_CAS        FALSE
+#endif
+
+/**
+ * Double word type, the size of a pointer and a tag.
+ */
+typedef unsigned __int128 port_dword_t;
+
+/**
+ * Atomic word compare-and-swap, returns @p TRUE if the word pointed by
+ * @p p was equal to @p o and has been replaced by @p n.
+ */
+#define port_atomic_cas(p, o, n) __sync_bool_compare_and_swap(p, o, n)
+
+/**
+ * Atomic double word compare-and-swap on a @p port_dword_t, returns
+ * @p TRUE if the double word has been updated.
+ */
+#define port_atomic_cas2(p, o, n) __sync_bool_compare_and_swap(p, o, n)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void port_switch(Thread *ntp, Thread *otp);
+  void port_halt(void);
+  void _port_thread_trampoline(void);
+  __attribute__((noreturn)) void _port_thread_start(msg_t (*pf)(void *),
+                                                    void *p);
+  void ChkIntSources(void);
+  void WaitIntSources(void);
+#if CH_TIMEDELTA > 0
+  systime_t port_timer_get_time(void);
+  void port_timer_start_alarm(systime_t time);
+  void port_timer_stop_alarm(void);
+  void port_timer_set_alarm(systime_t time);
+#endif
+  uint32_t port_rt_get_counter_value(void);
+  uint32_t port_rt_get_counter_frequency(void);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHCORE_H_ */
+
+/** @} */
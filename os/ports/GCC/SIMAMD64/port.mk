@@ -0,0 +1,6 @@
+# List of the ChibiOS/RT SIMAMD64 port files.
+PORTSRC = ${CHIBIOS}/os/ports/GCC/SIMAMD64/chcore.c
+
+PORTASM = 
+
+PORTINC = ${CHIBIOS}/os/ports/GCC/SIMAMD64
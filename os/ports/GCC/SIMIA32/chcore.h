@@ -103,6 +103,12 @@ struct context {
   struct intctx volatile *esp;
 };
 
+/**
+ * Saved stack pointer of a thread not currently running, used by debug
+ * and monitoring code.
+ */
+#define port_thread_sp(tp) ((void *)(tp)->p_ctx.esp)
+
 #define APUSH(p, a) (p) -= sizeof(void *), *(void **)(p) = (void*)(a)
 
 /* Darwin requires the stack to be aligned to a 16-byte boundary at
@@ -228,10 +234,49 @@ struct context {
 #define port_enable()
 
 /**
- * In the simulator this does a polling pass on the simulated interrupt
- * sources.
+ * In the simulator this serves the simulated interrupt sources, the host
+ * thread can block until one of them becomes ready.
+ */
+#define port_wait_for_interrupt() WaitIntSources()
+
+/**
+ * The simulator supports the tick-less mode, the alarm is implemented in
+ * the HAL using the host timers.
  */
-#define port_wait_for_interrupt() ChkIntSources()
+#define PORT_SUPPORTS_TICKLESS          TRUE
+
+/**
+ * The simulator supports a realtime counter, the counter is implemented in
+ * the HAL using the host timers.
+ */
+#define PORT_SUPPORTS_RT                TRUE
+
+/**
+ * The simulator supports the atomic compare-and-swap operations when the
+ * compiler provides the 64 bits GCC builtins.
+ */
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+#define PORT_SUPPORTS_ATOMIC_CAS        TRUE
+#else
+#define PORT_SUPPORTS_ATOMIC_CAS        FALSE
+#endif
+
+/**
+ * Double word type, the size of a pointer and a tag.
+ */
+typedef uint64_t port_dword_t;
+
+/**
+ * Atomic word compare-and-swap, returns @p TRUE if the word pointed by
+ * @p p was equal to @p o and has been replaced by @p n.
+ */
+#define port_atomic_cas(p, o, n) __sync_bool_compare_and_swap(p, o, n)
+
+/**
+ * Atomic double word compare-and-swap on a @p port_dword_t, returns
+ * @p TRUE if the double word has been updated.
+ */
+#define port_atomic_cas2(p, o, n) __sync_bool_compare_and_swap(p, o, n)
 
 #ifdef __cplusplus
 extern "C" {
@@ -241,6 +286,15 @@ extern "C" {
   __attribute__((cdecl, noreturn)) void _port_thread_start(msg_t (*pf)(void *),
                                                            void *p);
   void ChkIntSources(void);
+  void WaitIntSources(void);
+#if CH_TIMEDELTA > 0
+  systime_t port_timer_get_time(void);
+  void port_timer_start_alarm(systime_t time);
+  void port_timer_stop_alarm(void);
+  void port_timer_set_alarm(systime_t time);
+#endif
+  uint32_t port_rt_get_counter_value(void);
+  uint32_t port_rt_get_counter_frequency(void);
 #ifdef __cplusplus
 }
 #endif
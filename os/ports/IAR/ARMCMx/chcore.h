@@ -172,8 +172,11 @@ struct intctx {};
 
 #endif /* defined(__DOXYGEN__) */
 
+#if !CH_USE_EDF || defined(__DOXYGEN__)
 /**
  * @brief   Excludes the default @p chSchIsPreemptionRequired()implementation.
+ * @note    The default implementation is required by the EDF scheduling
+ *          class.
  */
 #define PORT_OPTIMIZED_ISPREEMPTIONREQUIRED
 
@@ -188,6 +191,7 @@ struct intctx {};
 #define chSchIsPreemptionRequired()                                         \
   (firstprio(&rlist.r_queue) > currp->p_prio)
 #endif /* CH_TIME_QUANTUM == 0 */
+#endif /* !CH_USE_EDF */
 
 #endif /* _FROM_ASM_ */
 
@@ -589,6 +589,46 @@ namespace chibios_rt {
   }
 #endif /* CH_USE_CONDVARS_TIMEOUT */
 #endif /* CH_USE_CONDVARS */
+
+#if CH_USE_RWLOCKS
+  /*------------------------------------------------------------------------*
+   * chibios_rt::RWLock                                                     *
+   *------------------------------------------------------------------------*/
+  RWLock::RWLock(void) {
+
+    chRWLockInit(&rwlock);
+  }
+
+  void RWLock::readLock(void) {
+
+    chRWLockReadLock(&rwlock);
+  }
+
+  msg_t RWLock::readLockTimeout(systime_t time) {
+
+    return chRWLockReadLockTimeout(&rwlock, time);
+  }
+
+  void RWLock::readUnlock(void) {
+
+    chRWLockReadUnlock(&rwlock);
+  }
+
+  void RWLock::writeLock(void) {
+
+    chRWLockWriteLock(&rwlock);
+  }
+
+  msg_t RWLock::writeLockTimeout(systime_t time) {
+
+    return chRWLockWriteLockTimeout(&rwlock, time);
+  }
+
+  void RWLock::writeUnlock(void) {
+
+    chRWLockWriteUnlock(&rwlock);
+  }
+#endif /* CH_USE_RWLOCKS */
 #endif /* CH_USE_MUTEXES */
 
 #if CH_USE_EVENTS
@@ -1329,6 +1329,99 @@ namespace chibios_rt {
 #endif /* CH_USE_CONDVARS_TIMEOUT */
   };
 #endif /* CH_USE_CONDVARS */
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+  /*------------------------------------------------------------------------*
+   * chibios_rt::RWLock                                                     *
+   *------------------------------------------------------------------------*/
+  /**
+   * @brief   Class encapsulating a readers-writer lock.
+   */
+  class RWLock {
+  public:
+    /**
+     * @brief   Embedded @p ::RWLock structure.
+     */
+    ::RWLock rwlock;
+
+    /**
+     * @brief   RWLock object constructor.
+     * @details The embedded @p ::RWLock structure is initialized.
+     *
+     * @init
+     */
+    RWLock(void);
+
+    /**
+     * @brief   Acquires the lock in shared mode.
+     *
+     * @api
+     */
+    void readLock(void);
+
+    /**
+     * @brief   Acquires the lock in shared mode with timeout specification.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if the lock has been acquired.
+     * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+     *                      specified timeout.
+     *
+     * @api
+     */
+    msg_t readLockTimeout(systime_t time);
+
+    /**
+     * @brief   Releases the lock acquired in shared mode.
+     *
+     * @api
+     */
+    void readUnlock(void);
+
+    /**
+     * @brief   Acquires the lock in exclusive mode.
+     * @post    The lock is inserted in the per-thread stack of owned
+     *          mutexes.
+     *
+     * @api
+     */
+    void writeLock(void);
+
+    /**
+     * @brief   Acquires the lock in exclusive mode with timeout
+     *          specification.
+     * @post    The lock is inserted in the per-thread stack of owned
+     *          mutexes.
+     *
+     * @param[in] time      the number of ticks before the operation timeouts,
+     *                      the following special values are allowed:
+     *                      - @a TIME_IMMEDIATE immediate timeout.
+     *                      - @a TIME_INFINITE no timeout.
+     *                      .
+     * @return              The operation status.
+     * @retval RDY_OK       if the lock has been acquired.
+     * @retval RDY_TIMEOUT  if the lock has not been acquired within the
+     *                      specified timeout.
+     *
+     * @api
+     */
+    msg_t writeLockTimeout(systime_t time);
+
+    /**
+     * @brief   Releases the lock acquired in exclusive mode.
+     * @pre     The lock must be the last mutex locked by the invoking
+     *          thread.
+     *
+     * @api
+     */
+    void writeUnlock(void);
+  };
+#endif /* CH_USE_RWLOCKS */
 #endif /* CH_USE_MUTEXES */
 
 #if CH_USE_EVENTS || defined(__DOXYGEN__)
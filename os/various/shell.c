@@ -106,12 +106,85 @@ static void cmd_systime(BaseSequentialStream *chp, int argc, char *argv[]) {
   chprintf(chp, "%lu\r\n", (unsigned long)chTimeNow());
 }
 
+#if CH_DBG_THREADS_ACCOUNTING || defined(__DOXYGEN__)
+static void cmd_load(BaseSequentialStream *chp, int argc, char *argv[]) {
+  static const char *states[] = {THD_STATE_NAMES};
+  uint32_t f = chDbgGetRunTimeFrequency();
+  uint64_t rt;
+  uint16_t load;
+  Thread *tp;
+
+  (void)argv;
+  if (argc > 0) {
+    usage(chp, "load");
+    return;
+  }
+  chprintf(chp, "    addr prio     state     runtime(s)    load name\r\n");
+  tp = chRegFirstThread();
+  do {
+    const char *name = chRegGetThreadName(tp);
+
+    rt = chRegGetThreadRunTime(tp);
+    load = chRegGetThreadLoad(tp);
+    chprintf(chp, "%.8lx %4lu %9s %7lu.%06lu %3u.%02u%% %s\r\n",
+             (unsigned long)tp, (unsigned long)tp->p_prio,
+             states[tp->p_state],
+             (unsigned long)(rt / f),
+             (unsigned long)(((rt % f) * 1000000) / f),
+             load / 100, load % 100, name != NULL ? name : "");
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+  rt = chDbgGetIsrRunTime();
+  load = chDbgGetIsrLoad();
+  chprintf(chp, "%24s%7lu.%06lu %3u.%02u%% ISRs (%lu)\r\n", "",
+           (unsigned long)(rt / f),
+           (unsigned long)(((rt % f) * 1000000) / f),
+           load / 100, load % 100,
+           (unsigned long)chDbgGetIsrCount());
+}
+#endif /* CH_DBG_THREADS_ACCOUNTING */
+
+#if (CH_USE_REGISTRY && CH_DBG_FILL_THREADS) || defined(__DOXYGEN__)
+static void cmd_stacks(BaseSequentialStream *chp, int argc, char *argv[]) {
+  Thread *tp;
+
+  (void)argv;
+  if (argc > 0) {
+    usage(chp, "stacks");
+    return;
+  }
+  chprintf(chp, "    addr   size   peak   free name\r\n");
+  tp = chRegFirstThread();
+  do {
+    const char *name = chRegGetThreadName(tp);
+    size_t size = chThdGetStackSize(tp);
+    size_t unused = chThdGetStackUnused(tp);
+
+    if (size > 0)
+      chprintf(chp, "%.8lx %6lu %6lu %6lu %s\r\n",
+               (unsigned long)tp, (unsigned long)size,
+               (unsigned long)(size - unused), (unsigned long)unused,
+               name != NULL ? name : "");
+    else
+      chprintf(chp, "%.8lx %6s %6s %6s %s\r\n",
+               (unsigned long)tp, "-", "-", "-", name != NULL ? name : "");
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+}
+#endif /* CH_USE_REGISTRY && CH_DBG_FILL_THREADS */
+
 /**
  * @brief   Array of the default commands.
  */
 static ShellCommand local_commands[] = {
   {"info", cmd_info},
   {"systime", cmd_systime},
+#if CH_DBG_THREADS_ACCOUNTING
+  {"load", cmd_load},
+#endif
+#if CH_USE_REGISTRY && CH_DBG_FILL_THREADS
+  {"stacks", cmd_stacks},
+#endif
   {NULL, NULL}
 };
 
@@ -36,6 +36,8 @@
 #include "testpools.h"
 #include "testdyn.h"
 #include "testqueues.h"
+#include "testedf.h"
+#include "testwq.h"
 #include "testbmk.h"
 
 /*
@@ -52,6 +54,8 @@ static ROMCONST struct testcase * ROMCONST *patterns[] = {
   patternpools,
   patterndyn,
   patternqueues,
+  patternedf,
+  patternwq,
   patternbmk,
   NULL
 };
@@ -201,6 +205,75 @@ void test_terminate_threads(void) {
       chThdTerminate(threads[i]);
 }
 
+#if TEST_STACK_REPORT || defined(__DOXYGEN__)
+/*
+ * Stack usage report.
+ */
+
+/**
+ * @brief   Highest stack usage of the test-spawned threads.
+ */
+static size_t stack_peak;
+
+/**
+ * @brief   Returns the suggested @p THD_WA_SIZE() argument for a stack peak.
+ * @details A @p TEST_STACK_MARGIN percent margin is added to the peak, the
+ *          port overhead already accounted by @p THD_WA_SIZE() is removed.
+ */
+static size_t stack_suggest(size_t peak) {
+  size_t overhead = THD_WA_SIZE(0) - sizeof(Thread);
+  size_t n = peak + (peak * TEST_STACK_MARGIN + 99) / 100;
+
+  n = MEM_ALIGN_NEXT(n);
+  return n > overhead ? n - overhead : 0;
+}
+
+static void stack_update(Thread *tp) {
+  size_t size = chThdGetStackSize(tp);
+
+  if ((size > 0) && (size - chThdGetStackUnused(tp) > stack_peak))
+    stack_peak = size - chThdGetStackUnused(tp);
+}
+
+static void stack_report(void) {
+  Thread *tp;
+
+  test_println("*** Stack usage:");
+  test_print("--- Test threads: peak ");
+  test_printn(stack_peak);
+  test_print(" of ");
+  test_printn(WA_SIZE - sizeof(Thread));
+  test_print(" bytes, suggested THD_WA_SIZE(");
+  test_printn(stack_suggest(stack_peak));
+  test_println(")");
+#if CH_USE_REGISTRY
+  tp = chRegFirstThread();
+  do {
+    size_t size = chThdGetStackSize(tp);
+
+    if (size > 0) {
+      size_t peak = size - chThdGetStackUnused(tp);
+      const char *name = chRegGetThreadName(tp);
+
+      test_print("--- ");
+      test_print(name != NULL ? name : "noname");
+      test_print(": peak ");
+      test_printn(peak);
+      test_print(" of ");
+      test_printn(size);
+      test_print(" bytes, suggested THD_WA_SIZE(");
+      test_printn(stack_suggest(peak));
+      test_println(")");
+    }
+    tp = chRegNextThread(tp);
+  } while (tp != NULL);
+#else
+  (void)tp;
+#endif
+  test_println("");
+}
+#endif /* TEST_STACK_REPORT */
+
 /**
  * @brief   Waits for the completion of all the test-spawned threads.
  */
@@ -210,6 +283,13 @@ void test_wait_threads(void) {
   for (i = 0; i < MAX_THREADS; i++)
     if (threads[i] != NULL) {
       chThdWait(threads[i]);
+#if TEST_STACK_REPORT
+      /* Only the threads in the static working areas can be inspected
+         after termination.*/
+      if (((uint8_t *)threads[i] >= test.buffer) &&
+          ((uint8_t *)threads[i] < test.buffer + sizeof test.buffer))
+        stack_update(threads[i]);
+#endif
       threads[i] = NULL;
     }
 }
@@ -378,6 +458,9 @@ msg_t TestThread(void *p) {
   }
   print_line();
   test_println("");
+#if TEST_STACK_REPORT
+  stack_report();
+#endif
   test_print("Final result: ");
   if (global_fail)
     test_println("FAILURE");
@@ -39,6 +39,26 @@
 #define TEST_NO_BENCHMARKS      FALSE
 #endif
 
+/**
+ * @brief   If @p TRUE then a stack usage report is printed at the end of
+ *          the test suite with the suggested working area sizes.
+ * @note    Requires @p CH_DBG_FILL_THREADS.
+ */
+#if !defined(TEST_STACK_REPORT) || defined(__DOXYGEN__)
+#define TEST_STACK_REPORT       FALSE
+#endif
+
+/**
+ * @brief   Safety margin added to the measured stack peaks, in percent.
+ */
+#if !defined(TEST_STACK_MARGIN) || defined(__DOXYGEN__)
+#define TEST_STACK_MARGIN       25
+#endif
+
+#if TEST_STACK_REPORT && !CH_DBG_FILL_THREADS
+#error "TEST_STACK_REPORT requires CH_DBG_FILL_THREADS"
+#endif
+
 #define MAX_THREADS             5
 #define MAX_TOKENS              16
 
@@ -46,7 +66,7 @@
 #define THREADS_STACK_SIZE      48
 #elif defined(CH_ARCHITECTURE_STM8)
 #define THREADS_STACK_SIZE      64
-#elif defined(CH_ARCHITECTURE_SIMIA32)
+#elif defined(CH_ARCHITECTURE_SIMIA32) || defined(CH_ARCHITECTURE_SIMAMD64)
 #define THREADS_STACK_SIZE      512
 #else
 #define THREADS_STACK_SIZE      128
@@ -10,6 +10,8 @@ TESTSRC = ${CHIBIOS}/test/test.c \
           ${CHIBIOS}/test/testpools.c \
           ${CHIBIOS}/test/testdyn.c \
           ${CHIBIOS}/test/testqueues.c \
+          ${CHIBIOS}/test/testedf.c \
+          ${CHIBIOS}/test/testwq.c \
           ${CHIBIOS}/test/testbmk.c
 
 # Required include directories
@@ -15,6 +15,7 @@
 */
 
 #include "ch.h"
+#include "hal.h"
 #include "test.h"
 
 /**
@@ -49,6 +50,18 @@
  * - @subpage test_benchmarks_011
  * - @subpage test_benchmarks_012
  * - @subpage test_benchmarks_013
+ * - @subpage test_benchmarks_014
+ * - @subpage test_benchmarks_015
+ * - @subpage test_benchmarks_016
+ * - @subpage test_benchmarks_017
+ * - @subpage test_benchmarks_018
+ * - @subpage test_benchmarks_019
+ * - @subpage test_benchmarks_020
+ * - @subpage test_benchmarks_021
+ * - @subpage test_benchmarks_022
+ * - @subpage test_benchmarks_023
+ * - @subpage test_benchmarks_024
+ * - @subpage test_benchmarks_025
  * .
  * @file testbmk.c Kernel Benchmarks
  * @brief Kernel Benchmarks source file
@@ -691,6 +704,914 @@ ROMCONST struct testcase testbmk13 = {
   bmk13_execute
 };
 
+/**
+ * @page test_benchmarks_014 Ready list scalability
+ *
+ * <h2>Description</h2>
+ * The ready list is crowded with a growing number of threads having
+ * priorities between the tester thread and the lowest user priority, then a
+ * thread at the lowest user priority is made ready and removed from the ready
+ * list into a continuous loop, the thread has to be inserted behind all the
+ * crowding threads.<br>
+ * The crowding threads are never executed because the tester thread does not
+ * sleep while they are in the ready list, their descriptors are taken from
+ * the test buffers.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations with 1, 4, 16 and 64 crowding threads, a
+ * constant score means a constant time ready list insertion.
+ */
+
+static void bmk14_execute(void) {
+  Thread *ftp = (Thread *)test.buffer;
+  tprio_t prio = chThdGetPriority();
+  unsigned i, nthd;
+
+  for (nthd = 1; nthd <= 64; nthd <<= 2) {
+    Thread *tp = &ftp[nthd];
+    uint32_t n = 0;
+
+    if (nthd + 1 > sizeof(test.buffer) / sizeof(Thread))
+      break;
+    test_wait_tick();
+    chSysLock();
+    for (i = 0; i < nthd; i++) {
+      ftp[i].p_state = THD_STATE_SUSPENDED;
+      ftp[i].p_prio = prio - 1 - (i % (prio - LOWPRIO - 1));
+      chSchReadyI(&ftp[i]);
+    }
+    chSysUnlock();
+    tp->p_state = THD_STATE_SUSPENDED;
+    tp->p_prio = LOWPRIO;
+    test_start_timer(1000);
+    do {
+      chSysLock();
+      chSchRemoveI(chSchReadyI(tp))->p_state = THD_STATE_SUSPENDED;
+      chSchRemoveI(chSchReadyI(tp))->p_state = THD_STATE_SUSPENDED;
+      chSchRemoveI(chSchReadyI(tp))->p_state = THD_STATE_SUSPENDED;
+      chSchRemoveI(chSchReadyI(tp))->p_state = THD_STATE_SUSPENDED;
+      chSysUnlock();
+      n += 4;
+#if defined(SIMULATOR)
+      ChkIntSources();
+#endif
+    } while (!test_timer_done);
+    chSysLock();
+    for (i = 0; i < nthd; i++)
+      chSchRemoveI(&ftp[i]);
+    chSysUnlock();
+    test_print("--- Score : ");
+    test_printn(n);
+    test_print(" ready+remove/S, ");
+    test_printn(nthd);
+    test_println(" ready threads");
+  }
+}
+
+ROMCONST struct testcase testbmk14 = {
+  "Benchmark, ready list scalability",
+  NULL,
+  NULL,
+  bmk14_execute
+};
+
+/**
+ * @page test_benchmarks_015 Virtual timers scalability
+ *
+ * <h2>Description</h2>
+ * A growing number of virtual timers is armed with deadlines spread beyond
+ * the benchmark duration, then one timer at time is reset and armed again
+ * with a different deadline into a continuous loop.<br>
+ * The timers descriptors are taken from the test buffers.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations with 16, 64 and 256 armed timers. If the
+ * HAL implements the realtime counters then the longest critical section
+ * measured around a reset and set sequence is also reported.
+ */
+
+static systime_t bmk15_delay(uint32_t n) {
+
+  return S2ST(2) + (systime_t)((n * 7919U) & 4095U);
+}
+
+static void bmk15_execute(void) {
+  VirtualTimer *vtp = (VirtualTimer *)test.buffer;
+  unsigned i, ntimers;
+
+  for (ntimers = 16; ntimers <= 256; ntimers <<= 2) {
+    uint32_t n = 0;
+#if HAL_IMPLEMENTS_COUNTERS
+    halrtcnt_t start, worst = 0;
+#endif
+
+    if (ntimers > sizeof(test.buffer) / sizeof(VirtualTimer))
+      break;
+    test_wait_tick();
+    chSysLock();
+    for (i = 0; i < ntimers; i++)
+      chVTSetI(&vtp[i], bmk15_delay(i), tmo, NULL);
+    chSysUnlock();
+    test_start_timer(1000);
+    do {
+      VirtualTimer *p = &vtp[n % ntimers];
+
+      chSysLock();
+#if HAL_IMPLEMENTS_COUNTERS
+      start = halGetCounterValue();
+#endif
+      chVTResetI(p);
+      chVTSetI(p, bmk15_delay(n), tmo, NULL);
+#if HAL_IMPLEMENTS_COUNTERS
+      start = halGetCounterValue() - start;
+      if (start > worst)
+        worst = start;
+#endif
+      chSysUnlock();
+      n++;
+#if defined(SIMULATOR)
+      ChkIntSources();
+#endif
+    } while (!test_timer_done);
+    chSysLock();
+    for (i = 0; i < ntimers; i++)
+      chVTResetI(&vtp[i]);
+    chSysUnlock();
+    test_print("--- Score : ");
+    test_printn(n);
+    test_print(" reset+set/S, ");
+    test_printn(ntimers);
+    test_println(" timers");
+#if HAL_IMPLEMENTS_COUNTERS
+    test_print("--- Worst : ");
+    test_printn((uint32_t)(((uint64_t)worst * 1000000000ULL) /
+                           halGetCounterFrequency()));
+    test_println(" nS critical section");
+#endif
+  }
+}
+
+ROMCONST struct testcase testbmk15 = {
+  "Benchmark, virtual timers scalability",
+  NULL,
+  NULL,
+  bmk15_execute
+};
+
+#if HAL_IMPLEMENTS_COUNTERS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_016 Virtual timers burst
+ *
+ * <h2>Description</h2>
+ * A growing number of virtual timers is armed in order to expire on the
+ * same system tick, meanwhile the tester thread, at the highest priority,
+ * continuously samples the realtime counter, the longest interval between
+ * two samples is the longest time spent into the tick interrupt.<br>
+ * The timers descriptors are taken from the test buffers.<br>
+ * Each callback executes a short busy loop emulating some useful work.<br>
+ * The longest interval is reported with 16, 64 and 256 expiring timers, if
+ * the virtual timers callbacks are deferred to the timer service thread
+ * then the interval should not depend on the number of timers.
+ */
+
+static volatile unsigned bmk16_cnt;
+
+static void bmk16_cb(void *p) {
+  volatile unsigned i;
+
+  (void)p;
+  /* Emulates some work done by the callback.*/
+  for (i = 0; i < 100; i++)
+    ;
+  chSysLockFromIsr();
+  bmk16_cnt++;
+  chSysUnlockFromIsr();
+}
+
+static void bmk16_execute(void) {
+  VirtualTimer *vtp = (VirtualTimer *)test.buffer;
+  unsigned i, ntimers;
+
+  for (ntimers = 16; ntimers <= 256; ntimers <<= 2) {
+    halrtcnt_t last, now, worst = 0;
+    systime_t time;
+    tprio_t prio;
+
+    if (ntimers > sizeof(test.buffer) / sizeof(VirtualTimer))
+      break;
+    bmk16_cnt = 0;
+    prio = chThdSetPriority(HIGHPRIO);
+    test_wait_tick();
+    chSysLock();
+    for (i = 0; i < ntimers; i++)
+      chVTSetI(&vtp[i], 2, bmk16_cb, NULL);
+    time = chTimeNow();
+    chSysUnlock();
+    last = halGetCounterValue();
+    while (chTimeIsWithin(time, time + 4)) {
+#if defined(SIMULATOR)
+      ChkIntSources();
+#endif
+      now = halGetCounterValue();
+      if (now - last > worst)
+        worst = now - last;
+      last = now;
+    }
+    chThdSetPriority(prio);
+    for (i = 0; (i < 100) && (bmk16_cnt < ntimers); i++)
+      test_wait_tick();
+    test_assert(1, bmk16_cnt == ntimers, "callbacks not invoked");
+    test_print("--- Worst : ");
+    test_printn((uint32_t)(((uint64_t)worst * 1000000000ULL) /
+                           halGetCounterFrequency()));
+    test_print(" nS tick interrupt, ");
+    test_printn(ntimers);
+    test_println(" timers");
+  }
+}
+
+ROMCONST struct testcase testbmk16 = {
+  "Benchmark, virtual timers burst",
+  NULL,
+  NULL,
+  bmk16_execute
+};
+#endif /* HAL_IMPLEMENTS_COUNTERS */
+
+#if (CH_USE_MUTEXES && CH_USE_SEMAPHORES) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_017 Mutexes contended lock/unlock performance
+ *
+ * <h2>Description</h2>
+ * The tester thread locks a mutex, wakes up an higher priority thread that
+ * locks and unlocks the same mutex then unlocks the mutex. The sequence is
+ * performed using a priority inheritance mutex and, if enabled, a priority
+ * ceiling mutex.<br>
+ * With priority inheritance the awakened thread preempts the owner, boosts
+ * it and sleeps on the mutex. With priority ceiling the owner runs at the
+ * ceiling priority and the awakened thread gets the mutex after the unlock
+ * without contention.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static msg_t bmk17_thread(void *p) {
+
+  while (TRUE) {
+    chSemWait(&sem1);
+    if (chThdShouldTerminate())
+      break;
+    chMtxLock((Mutex *)p);
+    chMtxUnlock();
+  }
+  return 0;
+}
+
+static uint32_t bmk17_loop(Mutex *mp) {
+  uint32_t n = 0;
+
+  chSemInit(&sem1, 0);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 bmk17_thread, mp);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chMtxLock(mp);
+    chSemSignal(&sem1);
+    chMtxUnlock();
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chThdTerminate(threads[0]);
+  chSemSignal(&sem1);
+  test_wait_threads();
+  return n;
+}
+
+static void bmk17_execute(void) {
+  uint32_t n;
+
+  chMtxInit(&mtx1);
+  n = bmk17_loop(&mtx1);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" lock+unlock/S (inheritance)");
+#if CH_USE_MUTEXES_CEILING
+  chMtxInitCeiling(&mtx1, chThdGetPriority()+1);
+  n = bmk17_loop(&mtx1);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" lock+unlock/S (ceiling)");
+#endif
+}
+
+ROMCONST struct testcase testbmk17 = {
+  "Benchmark, mutexes contended lock/unlock",
+  NULL,
+  NULL,
+  bmk17_execute
+};
+#endif /* CH_USE_MUTEXES && CH_USE_SEMAPHORES */
+
+#if (CH_USE_ADAPTIVE_WAIT && CH_USE_SEMAPHORES) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_018 Semaphores adaptive wait performance
+ *
+ * <h2>Description</h2>
+ * A thread with the same priority of the tester thread signals a semaphore
+ * and yields in a continuous loop, the tester thread waits on the semaphore.
+ * The sequence is performed with the adaptive wait disabled, the tester
+ * sleeps on the semaphore, and enabled, the tester yields to the signaling
+ * thread without sleeping.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static msg_t bmk18_thread(void *p) {
+
+  (void)p;
+  while (!chThdShouldTerminate()) {
+    chSemSignal(&sem1);
+    chThdYield();
+  }
+  return 0;
+}
+
+static uint32_t bmk18_loop(cnt_t limit) {
+  uint32_t n = 0;
+
+  chSemInit(&sem1, 0);
+  chSemSetAdaptive(&sem1, limit);
+  test_wait_tick();
+  test_start_timer(1000);
+  /* The signaling thread is started last because it never sleeps.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority(),
+                                 bmk18_thread, NULL);
+  do {
+    chSemWait(&sem1);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chThdTerminate(threads[0]);
+  test_wait_threads();
+  return n;
+}
+
+static void bmk18_execute(void) {
+  uint32_t n;
+
+  n = bmk18_loop(0);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" waits/S (blocking)");
+  n = bmk18_loop(16);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" waits/S (adaptive)");
+  test_print("--- Hits  : ");
+  test_printn(chSemGetAdaptiveHits(&sem1));
+  test_print(" misses ");
+  test_printn(chSemGetAdaptiveMisses(&sem1));
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk18 = {
+  "Benchmark, semaphores adaptive wait",
+  NULL,
+  NULL,
+  bmk18_execute
+};
+#endif /* CH_USE_ADAPTIVE_WAIT && CH_USE_SEMAPHORES */
+
+#if CH_USE_QUEUES_RINGS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_019 I/O Rings throughput
+ *
+ * <h2>Description</h2>
+ * Four bytes are written and then read from an @p InputRing into a continuous
+ * loop, as in the I/O Queues benchmark, then the same sequence is repeated
+ * moving sixteen bytes using the bulk functions.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+static void bmk19_execute(void) {
+  uint32_t n;
+  static uint8_t ib[16], buf[16];
+  static InputRing ir;
+
+  chIRInit(&ir, ib, sizeof(ib), NULL, NULL);
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysLock();
+    chIRPutI(&ir, 0);
+    chIRPutI(&ir, 1);
+    chIRPutI(&ir, 2);
+    chIRPutI(&ir, 3);
+    chSysUnlock();
+    (void)chIRGet(&ir);
+    (void)chIRGet(&ir);
+    (void)chIRGet(&ir);
+    (void)chIRGet(&ir);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_printn(n * 4);
+  test_println(" bytes/S");
+
+  n = 0;
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysLock();
+    chIRWriteI(&ir, buf, sizeof(buf));
+    chSysUnlock();
+    (void)chIRReadTimeout(&ir, buf, sizeof(buf), TIME_INFINITE);
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  test_print("--- Score : ");
+  test_printn(n * sizeof(buf));
+  test_println(" bytes/S (bulk)");
+}
+
+ROMCONST struct testcase testbmk19 = {
+  "Benchmark, I/O Rings throughput",
+  NULL,
+  NULL,
+  bmk19_execute
+};
+#endif /* CH_USE_QUEUES_RINGS */
+
+#if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_020 Mailboxes batched throughput
+ *
+ * <h2>Description</h2>
+ * Sixteen messages are posted and then fetched from a mailbox into a
+ * continuous loop, one message at time and then using the batched
+ * functions.<br>
+ * The performance is calculated by measuring the number of iterations after
+ * a second of continuous operations.
+ */
+
+#define BMK20_BATCH 16
+
+static uint32_t bmk20_loop(bool_t batched) {
+  static msg_t mbb[BMK20_BATCH], msgs[BMK20_BATCH];
+  static Mailbox mb;
+  uint32_t n = 0;
+  unsigned i;
+
+  chMBInit(&mb, mbb, BMK20_BATCH);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    if (batched) {
+      (void)chMBPostN(&mb, msgs, BMK20_BATCH, TIME_INFINITE);
+      (void)chMBFetchN(&mb, msgs, BMK20_BATCH, TIME_INFINITE);
+    }
+    else {
+      for (i = 0; i < BMK20_BATCH; i++)
+        (void)chMBPost(&mb, msgs[i], TIME_INFINITE);
+      for (i = 0; i < BMK20_BATCH; i++)
+        (void)chMBFetch(&mb, &msgs[i], TIME_INFINITE);
+    }
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  return n * BMK20_BATCH;
+}
+
+static void bmk20_execute(void) {
+  uint32_t n;
+
+  n = bmk20_loop(FALSE);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" msgs/S");
+  n = bmk20_loop(TRUE);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" msgs/S (batched)");
+}
+
+ROMCONST struct testcase testbmk20 = {
+  "Benchmark, mailboxes batched throughput",
+  NULL,
+  NULL,
+  bmk20_execute
+};
+#endif /* CH_USE_MAILBOXES */
+
+#if (CH_USE_HEAP && !CH_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_021 Heap fragmentation
+ *
+ * <h2>Description</h2>
+ * A set of slots is randomly allocated and released from a local heap
+ * using random sizes into a continuous loop, the heap is kept near to its
+ * capacity so the free space is fragmented.<br>
+ * The test runs for @p BMK21_DURATION milliseconds so the fragmentation
+ * can build up, the performance is reported as the average number of
+ * operations per second, then the number of failed allocations, the peak
+ * number of fragments sampled during the run and the final fragments are
+ * reported. The heap must return to a single fragment after releasing all
+ * the slots.
+ */
+
+#define BMK21_SLOTS 256
+
+/**
+ * @brief   Heap fragmentation benchmark duration in milliseconds.
+ * @note    The default matches the other benchmarks, soak runs can
+ *          override it in order to let the fragmentation build up.
+ */
+#if !defined(BMK21_DURATION) || defined(__DOXYGEN__)
+#define BMK21_DURATION 1000
+#endif
+
+static void bmk21_execute(void) {
+  static MemoryHeap heap;
+  static void *slots[BMK21_SLOTS];
+  uint32_t n = 0, failed = 0, seed = 0x12345678;
+  size_t frags, peak = 0, freesize;
+  unsigned i;
+
+  chHeapInit(&heap, test.buffer, sizeof(union test_buffers));
+  for (i = 0; i < BMK21_SLOTS; i++)
+    slots[i] = NULL;
+  test_wait_tick();
+  test_start_timer(BMK21_DURATION);
+  do {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    i = seed % BMK21_SLOTS;
+    if (slots[i] != NULL) {
+      chHeapFree(slots[i]);
+      slots[i] = NULL;
+    }
+    else {
+      /* Random sizes, on average the live blocks fill three quarters of
+         the heap.*/
+      size_t size = (seed >> 8) % (sizeof(union test_buffers) * 3 /
+                                   BMK21_SLOTS);
+      if ((slots[i] = chHeapAlloc(&heap, size)) == NULL)
+        failed++;
+    }
+    /* Periodic sampling of the fragmentation.*/
+    if ((++n & 1023) == 0) {
+      frags = chHeapStatus(&heap, NULL);
+      if (frags > peak)
+        peak = frags;
+    }
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  frags = chHeapStatus(&heap, &freesize);
+  for (i = 0; i < BMK21_SLOTS; i++)
+    if (slots[i] != NULL)
+      chHeapFree(slots[i]);
+  test_print("--- Score : ");
+  test_printn((uint32_t)(((uint64_t)n * 1000) / BMK21_DURATION));
+  test_println(" ops/S");
+  test_print("--- Failed: ");
+  test_printn(failed);
+  test_print(" fragments ");
+  test_printn(frags);
+  test_print(" (peak ");
+  test_printn(peak);
+  test_print(") free ");
+  test_printn(freesize);
+  test_println(" bytes");
+  test_assert(1, chHeapStatus(&heap, NULL) == 1, "heap fragmented");
+}
+
+ROMCONST struct testcase testbmk21 = {
+  "Benchmark, heap fragmentation",
+  NULL,
+  NULL,
+  bmk21_execute
+};
+#endif /* CH_USE_HEAP && !CH_USE_MALLOC_HEAP */
+
+#if (CH_USE_HEAP && CH_USE_HEAP_CACHE) || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_022 Heap cache
+ *
+ * <h2>Description</h2>
+ * Four threads are created at equal priority, each thread allocates and
+ * releases two small blocks from the default heap and yields, the test is
+ * executed without and with a heap cache attached to each thread.<br>
+ * The performance is calculated by measuring the number of operations after
+ * a second of continuous operations, the cache hits and misses are reported.
+ */
+
+static uint32_t bmk22_ops;
+
+static msg_t thread22(void *p) {
+  void *p1, *p2;
+
+  if (p != NULL)
+    chHeapCacheAttach((HeapCache *)p);
+  do {
+    p1 = chHeapAlloc(NULL, 24);
+    p2 = chHeapAlloc(NULL, 100);
+    if (p1 != NULL)
+      chHeapFree(p1);
+    if (p2 != NULL)
+      chHeapFree(p2);
+    bmk22_ops += 4;
+    chThdYield();
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!chThdShouldTerminate());
+  chHeapCacheDetach();
+  return 0;
+}
+
+static void bmk22_loop(HeapCache *hcp) {
+  unsigned i;
+
+  bmk22_ops = 0;
+  test_wait_tick();
+  for (i = 0; i < 4; i++)
+    threads[i] = chThdCreateStatic(wa[i], WA_SIZE, chThdGetPriority()-1,
+                                   thread22,
+                                   hcp != NULL ? (void *)&hcp[i] : NULL);
+  chThdSleepSeconds(1);
+  test_terminate_threads();
+  test_wait_threads();
+  test_print("--- Score : ");
+  test_printn(bmk22_ops);
+  test_println(hcp != NULL ? " ops/S (cached)" : " ops/S");
+}
+
+static void bmk22_execute(void) {
+  static HeapCache caches[4];
+  uint32_t hits = 0, misses = 0;
+  unsigned i;
+
+  bmk22_loop(NULL);
+  for (i = 0; i < 4; i++)
+    chHeapCacheInit(&caches[i], NULL);
+  bmk22_loop(caches);
+  for (i = 0; i < 4; i++) {
+    hits += chHeapCacheGetHits(&caches[i]);
+    misses += chHeapCacheGetMisses(&caches[i]);
+  }
+  test_print("--- Hits  : ");
+  test_printn(hits);
+  test_print(" misses ");
+  test_printn(misses);
+  test_println("");
+}
+
+ROMCONST struct testcase testbmk22 = {
+  "Benchmark, heap cache",
+  NULL,
+  NULL,
+  bmk22_execute
+};
+#endif /* CH_USE_HEAP && CH_USE_HEAP_CACHE */
+
+#if CH_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_023 Asynchronous messages performance
+ *
+ * <h2>Description</h2>
+ * A message server thread is created with a lower priority than the client
+ * thread, the client posts batches of eight requests to a message port and
+ * waits for the last reply, the server completes each batch with a single
+ * reschedule. The messages throughput per second is measured and the result
+ * printed in the output log.
+ */
+
+#define BMK23_BATCH 8
+
+static msg_t thread23(void *p) {
+  MsgFuture *mfp, *batch;
+  msg_t msg = 1;
+
+  do {
+    batch = chMsgPortFetch((MsgPort *)p);
+    chSysLock();
+    while (batch != NULL) {
+      mfp = batch;
+      batch = chMsgFutureNext(mfp);
+      msg = chMsgFutureGetMsg(mfp);
+      chMsgCompleteI(mfp, msg);
+    }
+    chSchRescheduleS();
+    chSysUnlock();
+  } while (msg);
+  return 0;
+}
+
+static void bmk23_execute(void) {
+  static MsgPort port;
+  static MsgFuture futures[BMK23_BATCH];
+  uint32_t n = 0;
+  unsigned i;
+
+  chMsgPortInit(&port);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()-1,
+                                 thread23, &port);
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    for (i = 0; i < BMK23_BATCH; i++)
+      chMsgPost(&port, &futures[i], 1);
+    (void)chMsgFutureWait(&futures[BMK23_BATCH - 1]);
+    n += BMK23_BATCH;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chMsgPost(&port, &futures[0], 0);
+  test_wait_threads();
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" msgs/S");
+}
+
+ROMCONST struct testcase testbmk23 = {
+  "Benchmark, asynchronous messages",
+  NULL,
+  NULL,
+  bmk23_execute
+};
+#endif /* CH_USE_MESSAGES_ASYNC */
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_024 Readers-writer lock performance
+ *
+ * <h2>Description</h2>
+ * Four threads with a lower priority than the tester thread repeatedly
+ * acquire a readers-writer lock, yield while holding it and release it.
+ * A fixed fraction of the operations are performed as writer, the phases
+ * of the threads are shifted so the writes are spread. The sequence is
+ * repeated with 100/0, 90/10, 50/50 and 0/100 reads/writes mixes.<br>
+ * The performance is calculated by measuring the number of operations
+ * performed by all the threads after a second of continuous operations.
+ */
+
+#define BMK24_THREADS 4
+
+static RWLock rwl1;
+static uint32_t bmk24_ops[BMK24_THREADS];
+static unsigned bmk24_writes;
+
+static msg_t bmk24_thread(void *p) {
+  uint32_t *np = (uint32_t *)p;
+  unsigned i = (unsigned)(np - bmk24_ops) * 3;
+  uint32_t n = 0;
+
+  while (!chThdShouldTerminate()) {
+    if (i++ % 10 < bmk24_writes) {
+      chRWLockWriteLock(&rwl1);
+      chThdYield();
+      chRWLockWriteUnlock(&rwl1);
+    }
+    else {
+      chRWLockReadLock(&rwl1);
+      chThdYield();
+      chRWLockReadUnlock(&rwl1);
+    }
+    n++;
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  }
+  *np = n;
+  return 0;
+}
+
+static void bmk24_loop(unsigned writes) {
+  uint32_t n = 0;
+  unsigned i;
+
+  chRWLockInit(&rwl1);
+  bmk24_writes = writes;
+  test_wait_tick();
+  for (i = 0; i < BMK24_THREADS; i++)
+    threads[i] = chThdCreateStatic(wa[i], WA_SIZE, chThdGetPriority()-1,
+                                   bmk24_thread, &bmk24_ops[i]);
+  chThdSleepMilliseconds(1000);
+  for (i = 0; i < BMK24_THREADS; i++)
+    chThdTerminate(threads[i]);
+  test_wait_threads();
+  for (i = 0; i < BMK24_THREADS; i++)
+    n += bmk24_ops[i];
+  test_print("--- Score : ");
+  test_printn(n);
+  test_print(" ops/S (");
+  test_printn(100 - writes * 10);
+  test_print("/");
+  test_printn(writes * 10);
+  test_println(" reads/writes)");
+}
+
+static void bmk24_execute(void) {
+
+  bmk24_loop(0);
+  bmk24_loop(1);
+  bmk24_loop(5);
+  bmk24_loop(10);
+}
+
+ROMCONST struct testcase testbmk24 = {
+  "Benchmark, readers-writer lock",
+  NULL,
+  NULL,
+  bmk24_execute
+};
+#endif /* CH_USE_RWLOCKS */
+
+#if CH_USE_WORKQUEUES || defined(__DOXYGEN__)
+/**
+ * @page test_benchmarks_025 Work queues performance
+ *
+ * <h2>Description</h2>
+ * A work queue is served by a worker with higher priority than the tester
+ * thread, the tester enqueues work items from an emulated interrupt
+ * handler. The sequence is performed enqueuing a single item for each
+ * reschedule and enqueuing batches of eight items.<br>
+ * The performance is calculated by measuring the number of executed items
+ * after a second of continuous operations.
+ */
+
+#define BMK25_BATCH 8
+
+static void bmk25_work(void *p) {
+
+  (*(uint32_t *)p)++;
+}
+
+static uint32_t bmk25_loop(unsigned batch) {
+  static WorkQueue wq;
+  static WorkItem items[BMK25_BATCH];
+  uint32_t n = 0;
+  unsigned i;
+
+  chWQInit(&wq);
+  for (i = 0; i < BMK25_BATCH; i++)
+    chWIInit(&items[i], bmk25_work, &n);
+  threads[0] = chWQStart(&wq, wa[0], WA_SIZE, chThdGetPriority()+1,
+                         "bmkwq");
+  test_wait_tick();
+  test_start_timer(1000);
+  do {
+    chSysLock();
+    for (i = 0; i < batch; i++)
+      chWQEnqueueI(&wq, &items[i]);
+    chSchRescheduleS();
+    chSysUnlock();
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+  } while (!test_timer_done);
+  chWQStop(&wq);
+  test_wait_threads();
+  return n;
+}
+
+static void bmk25_execute(void) {
+  uint32_t n;
+
+  n = bmk25_loop(1);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" items/S (single)");
+  n = bmk25_loop(BMK25_BATCH);
+  test_print("--- Score : ");
+  test_printn(n);
+  test_println(" items/S (batch)");
+}
+
+ROMCONST struct testcase testbmk25 = {
+  "Benchmark, work queues",
+  NULL,
+  NULL,
+  bmk25_execute
+};
+#endif /* CH_USE_WORKQUEUES */
+
 /**
  * @brief   Test sequence for benchmarks.
  */
@@ -715,6 +1636,38 @@ ROMCONST struct testcase * ROMCONST patternbmk[] = {
   &testbmk12,
 #endif
   &testbmk13,
+  &testbmk14,
+  &testbmk15,
+#if HAL_IMPLEMENTS_COUNTERS || defined(__DOXYGEN__)
+  &testbmk16,
+#endif
+#if (CH_USE_MUTEXES && CH_USE_SEMAPHORES) || defined(__DOXYGEN__)
+  &testbmk17,
+#endif
+#if (CH_USE_ADAPTIVE_WAIT && CH_USE_SEMAPHORES) || defined(__DOXYGEN__)
+  &testbmk18,
+#endif
+#if CH_USE_QUEUES_RINGS || defined(__DOXYGEN__)
+  &testbmk19,
+#endif
+#if CH_USE_MAILBOXES || defined(__DOXYGEN__)
+  &testbmk20,
+#endif
+#if (CH_USE_HEAP && !CH_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
+  &testbmk21,
+#endif
+#if (CH_USE_HEAP && CH_USE_HEAP_CACHE) || defined(__DOXYGEN__)
+  &testbmk22,
+#endif
+#if CH_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+  &testbmk23,
+#endif
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+  &testbmk24,
+#endif
+#if CH_USE_WORKQUEUES || defined(__DOXYGEN__)
+  &testbmk25,
+#endif
 #endif
   NULL
 };
@@ -0,0 +1,246 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_edf EDF scheduling test
+ *
+ * File: @ref testedf.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref edf subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref edf code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_EDF
+ * - @p CH_USE_SEMAPHORES
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_edf_001
+ * - @subpage test_edf_002
+ * - @subpage test_edf_003
+ * - @subpage test_edf_004
+ * .
+ * @file testedf.c
+ * @brief EDF scheduling test source file
+ * @file testedf.h
+ * @brief EDF scheduling test header file
+ */
+
+#if (CH_USE_EDF && CH_USE_SEMAPHORES) || defined(__DOXYGEN__)
+
+static Semaphore sem1;
+
+static void edf_setup(void) {
+
+  chSemInit(&sem1, 0);
+}
+
+/**
+ * @page test_edf_001 Deadline ordering
+ *
+ * <h2>Description</h2>
+ * Three EDF threads with different relative deadlines and a fixed priority
+ * thread with priority lower than the EDF level are enqueued on a
+ * semaphore then awakened at once.<br>
+ * The test expects the EDF threads to run in deadline order regardless of
+ * the creation order, followed by the fixed priority thread.
+ */
+
+static msg_t thread1(void *p) {
+
+  chEdfEnter(MS2ST(100), MS2ST(*(char *)p == 'A' ? 30 :
+                               *(char *)p == 'B' ? 10 : 20));
+  chSemWait(&sem1);
+  test_emit_token(*(char *)p);
+  return 0;
+}
+
+static msg_t thread2(void *p) {
+
+  chSemWait(&sem1);
+  test_emit_token(*(char *)p);
+  return 0;
+}
+
+static void edf1_execute(void) {
+
+  tprio_t prio = chThdGetPriority();
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread1, "A");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+1, thread2, "D");
+  threads[2] = chThdCreateStatic(wa[2], WA_SIZE, prio+1, thread1, "B");
+  threads[3] = chThdCreateStatic(wa[3], WA_SIZE, prio+1, thread1, "C");
+  test_assert(1, threads[0]->p_prio == EDFPRIO, "not at EDF level");
+  chSemReset(&sem1, 0);
+  test_wait_threads();
+  test_assert_sequence(2, "BCAD");
+}
+
+ROMCONST struct testcase testedf1 = {
+  "EDF, deadline ordering",
+  edf_setup,
+  NULL,
+  edf1_execute
+};
+
+/**
+ * @page test_edf_002 Preemption
+ *
+ * <h2>Description</h2>
+ * An EDF thread wakes up an EDF thread with an earlier deadline and then an
+ * EDF thread wakes up an EDF thread with a later deadline.<br>
+ * The test expects the awakened thread to preempt the running thread only
+ * in the first case.
+ */
+
+static msg_t thread3(void *p) {
+
+  chEdfEnter(MS2ST(100), MS2ST(*(char *)p == 'B' || *(char *)p == 'C' ?
+                               10 : 50));
+  if ((*(char *)p == 'B') || (*(char *)p == 'D'))
+    chSemWait(&sem1);
+  else
+    chSemSignal(&sem1);
+  test_emit_token(*(char *)p);
+  return 0;
+}
+
+static void edf2_execute(void) {
+
+  tprio_t prio = chThdGetPriority();
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread3, "B");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+1, thread3, "A");
+  test_wait_threads();
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread3, "D");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+1, thread3, "C");
+  test_wait_threads();
+  test_assert_sequence(1, "BACD");
+}
+
+ROMCONST struct testcase testedf2 = {
+  "EDF, preemption",
+  edf_setup,
+  NULL,
+  edf2_execute
+};
+
+/**
+ * @page test_edf_003 Periodic jobs
+ *
+ * <h2>Description</h2>
+ * Two periodic EDF threads, with periods of 15 and 10 milliseconds and
+ * deadlines equal to their periods, execute three jobs each.<br>
+ * The test expects the jobs to be executed in deadline order without
+ * deadline misses.
+ */
+
+static msg_t thread4(void *p) {
+  unsigned i;
+
+  chEdfEnter(MS2ST(*(char *)p == 'A' ? 15 : 10),
+             MS2ST(*(char *)p == 'A' ? 15 : 10));
+  chSemWait(&sem1);
+  for (i = 0; i < 3; i++) {
+    test_emit_token(*(char *)p);
+    if (chEdfWaitNextPeriod())
+      test_emit_token('X');
+  }
+  if ((chEdfGetJobs(chThdSelf()) != 3) || (chEdfGetMisses(chThdSelf()) != 0))
+    test_emit_token('X');
+  return 0;
+}
+
+static void edf3_execute(void) {
+
+  tprio_t prio = chThdGetPriority();
+  test_wait_tick();
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread4, "A");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+1, thread4, "B");
+  chSemReset(&sem1, 0);
+  test_wait_threads();
+  test_assert_sequence(1, "BABABA");
+}
+
+ROMCONST struct testcase testedf3 = {
+  "EDF, periodic jobs",
+  edf_setup,
+  NULL,
+  edf3_execute
+};
+
+/**
+ * @page test_edf_004 Deadline miss
+ *
+ * <h2>Description</h2>
+ * An EDF thread with a 5 milliseconds deadline sleeps for 10 milliseconds
+ * during its first job then executes a second job without delays.<br>
+ * The test expects the miss to be counted while the first job is still
+ * running, the first job to be reported as missed and the second one as
+ * completed in time.
+ */
+
+static msg_t thread5(void *p) {
+
+  (void)p;
+  chEdfEnter(MS2ST(20), MS2ST(5));
+  chThdSleepMilliseconds(10);
+  if (chEdfGetMisses(chThdSelf()) == 1)
+    test_emit_token('A');
+  if (chEdfWaitNextPeriod())
+    test_emit_token('B');
+  if (!chEdfWaitNextPeriod())
+    test_emit_token('C');
+  if (chEdfGetMisses(chThdSelf()) == 1)
+    test_emit_token('D');
+  return 0;
+}
+
+static void edf4_execute(void) {
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread5, NULL);
+  test_wait_threads();
+  test_assert_sequence(1, "ABCD");
+}
+
+ROMCONST struct testcase testedf4 = {
+  "EDF, deadline miss",
+  NULL,
+  NULL,
+  edf4_execute
+};
+#endif /* CH_USE_EDF && CH_USE_SEMAPHORES */
+
+/**
+ * @brief   Test sequence for EDF scheduling.
+ */
+ROMCONST struct testcase * ROMCONST patternedf[] = {
+#if (CH_USE_EDF && CH_USE_SEMAPHORES) || defined(__DOXYGEN__)
+  &testedf1,
+  &testedf2,
+  &testedf3,
+  &testedf4,
+#endif
+  NULL
+};
@@ -37,6 +37,8 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_heap_001
+ * - @subpage test_heap_002
+ * - @subpage test_heap_003
  * .
  * @file testheap.c
  * @brief Heap test source file
@@ -146,14 +148,142 @@ ROMCONST struct testcase testheap1 = {
   heap1_execute
 };
 
+#if CH_USE_HEAP_CACHE || defined(__DOXYGEN__)
+/**
+ * @page test_heap_002 Heap cache test
+ *
+ * <h2>Description</h2>
+ * A heap cache is attached to the current thread, the released blocks are
+ * expected to be retained by the cache and reused by the following
+ * allocations of the same class. The magazines overflow is returned to the
+ * heap. The test expects to find the heap back to the initial status after
+ * the cache is detached.
+ */
+
+static void heap2_execute(void) {
+  static HeapCache hc;
+  void *p1, *p2, *pa[CH_HEAP_CACHE_DEPTH + 1];
+  size_t n, sz;
+  unsigned i;
+
+  (void)chHeapStatus(&test_heap, &sz);
+  chHeapCacheInit(&hc, &test_heap);
+  chHeapCacheAttach(&hc);
+
+  /* Miss then hit on the same block.*/
+  p1 = chHeapAlloc(&test_heap, SIZE);
+  test_assert(1, p1 != NULL, "allocation failed");
+  chHeapFree(p1);
+  (void)chHeapStatus(&test_heap, &n);
+  test_assert(2, n < sz, "block not cached");
+  p2 = chHeapAlloc(&test_heap, SIZE - 1);
+  test_assert(3, p2 == p1, "block not reused");
+  test_assert(4, (chHeapCacheGetHits(&hc) == 1) &&
+                 (chHeapCacheGetMisses(&hc) == 1), "wrong counters");
+  chHeapFree(p2);
+
+  /* Magazine overflow.*/
+  for (i = 0; i < CH_HEAP_CACHE_DEPTH + 1; i++)
+    pa[i] = chHeapAlloc(&test_heap, SIZE);
+  for (i = 0; i < CH_HEAP_CACHE_DEPTH + 1; i++)
+    chHeapFree(pa[i]);
+  test_assert(5, hc.hc_count[0] == CH_HEAP_CACHE_DEPTH, "wrong magazine");
+
+  /* Detach returns everything to the heap.*/
+  chHeapCacheDetach();
+  test_assert(6, chHeapStatus(&test_heap, &n) == 1, "heap fragmented");
+  test_assert(7, n == sz, "size changed");
+}
+
+ROMCONST struct testcase testheap2 = {
+  "Heap, cache",
+  heap1_setup,
+  NULL,
+  heap2_execute
+};
+#endif /* CH_USE_HEAP_CACHE */
+
 #endif /* CH_USE_HEAP.*/
 
+#if (CH_USE_MEMCORE && CH_USE_MEMCORE_REGIONS) || defined(__DOXYGEN__)
+/**
+ * @page test_heap_003 Core memory regions test
+ *
+ * <h2>Description</h2>
+ * A fast memory region is registered then aligned and placed allocations
+ * are performed.<br>
+ * The test expects the blocks to be aligned and allocated from the proper
+ * region, the placement hints fall back on the other regions while the
+ * required attributes do not. Registering again a region must not drop
+ * the regions registered after it.
+ */
+
+static stkalign_t fastbuf[128 / sizeof(stkalign_t)];
+static stkalign_t slowbuf[64 / sizeof(stkalign_t)];
+static MemoryRegion fastregion, slowregion;
+
+#define IN_FASTBUF(p) (((uint8_t *)(p) >= (uint8_t *)fastbuf) &&            \
+                       ((uint8_t *)(p) < (uint8_t *)fastbuf + sizeof fastbuf))
+
+static void heap3_execute(void) {
+  void *p;
+
+  chCoreRegisterRegion(&fastregion, "fast", fastbuf, sizeof fastbuf,
+                       MEM_ATTR_FAST);
+  test_assert(1, chCoreGetRegion("fast") == &fastregion, "region not found");
+  test_assert(2, chCoreGetRegion("core") == chCoreNextRegion(NULL),
+              "default region not found");
+  test_assert(3, chCoreGetRegion("fas") == NULL, "unexpected region");
+
+  /* Aligned allocation from the preferred region.*/
+  p = chCoreAllocPlaced(16, 64, 0, MEM_ATTR_FAST);
+  test_assert(4, IN_FASTBUF(p), "wrong region");
+  test_assert(5, ((size_t)p & 63) == 0, "not aligned");
+
+  /* Required attributes.*/
+  test_assert(6, chCoreAllocPlaced(16, 0, MEM_ATTR_RETAINED, 0) == NULL,
+              "no retained region");
+  p = chCoreAllocDMA(16);
+  test_assert(7, (p != NULL) && !IN_FASTBUF(p), "wrong region");
+  test_assert(8, ((size_t)p & (CH_MEMCORE_DMA_ALIGN - 1)) == 0,
+              "not aligned");
+
+  /* Fast region exhausted, the hint falls back on the default region.*/
+  p = chCoreAllocFast(sizeof fastbuf);
+  test_assert(9, (p != NULL) && !IN_FASTBUF(p), "wrong region");
+  while (((p = chCoreAllocFast(MEM_ALIGN_SIZE)) != NULL) && IN_FASTBUF(p))
+    ;
+  test_assert(10, chCoreRegionStatus(&fastregion) == 0, "not exhausted");
+
+  /* Registering again a region in the middle of the list.*/
+  chCoreRegisterRegion(&slowregion, "slow", slowbuf, sizeof slowbuf, 0);
+  chCoreRegisterRegion(&fastregion, "fast", fastbuf, sizeof fastbuf,
+                       MEM_ATTR_FAST);
+  test_assert(11, chCoreRegionStatus(&fastregion) == sizeof fastbuf,
+              "not reset");
+  test_assert(12, chCoreGetRegion("slow") == &slowregion, "region lost");
+}
+
+ROMCONST struct testcase testheap3 = {
+  "Heap, core memory regions",
+  NULL,
+  NULL,
+  heap3_execute
+};
+#endif /* CH_USE_MEMCORE && CH_USE_MEMCORE_REGIONS */
+
 /**
  * @brief   Test sequence for heap.
  */
 ROMCONST struct testcase * ROMCONST patternheap[] = {
 #if (CH_USE_HEAP && !CH_USE_MALLOC_HEAP) || defined(__DOXYGEN__)
   &testheap1,
+#if CH_USE_HEAP_CACHE || defined(__DOXYGEN__)
+  &testheap2,
+#endif
+#endif
+#if (CH_USE_MEMCORE && CH_USE_MEMCORE_REGIONS) || defined(__DOXYGEN__)
+  &testheap3,
 #endif
   NULL
 };
@@ -40,6 +40,7 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_mbox_001
+ * - @subpage test_mbox_002
  * .
  * @file testmbox.c
  * @brief Mailboxes test source file
@@ -226,6 +227,104 @@ ROMCONST struct testcase testmbox1 = {
   mbox1_execute
 };
 
+/**
+ * @page test_mbox_002 Batched post and fetch
+ *
+ * <h2>Description</h2>
+ * Messages are posted/fetched in batches from a mailbox, partial batches,
+ * timeouts and the buffer circularity are tested. A thread waiting for a
+ * batch of messages is then awakened once by a batched post.<br>
+ * The test expects to find a consistent mailbox status after each operation.
+ */
+
+static void mbox2_setup(void) {
+
+  chMBInit(&mb1, (msg_t *)test.wa.T0, MB_SIZE);
+}
+
+static msg_t thread2(void *p) {
+  msg_t msgs[MB_SIZE];
+  cnt_t i, n;
+
+  (void)p;
+  n = chMBFetchN(&mb1, msgs, MB_SIZE, TIME_INFINITE);
+  for (i = 0; i < n; i++)
+    test_emit_token(msgs[i]);
+  return 0;
+}
+
+static void mbox2_execute(void) {
+  static const msg_t in[MB_SIZE] = {'A', 'B', 'C', 'D', 'E'};
+  msg_t out[MB_SIZE * 2];
+  cnt_t i, n;
+
+  /*
+   * Testing partial batches.
+   */
+  n = chMBPostN(&mb1, in, 3, TIME_INFINITE);
+  test_assert(1, n == 3, "wrong posted count");
+  chSysLock();
+  n = chMBPostNI(&mb1, &in[3], MB_SIZE);
+  chSysUnlock();
+  test_assert(2, n == 2, "wrong posted count");
+  test_assert(3, chMBPostN(&mb1, in, 1, TIME_IMMEDIATE) == 0,
+              "wrong timeout return");
+  test_assert_lock(4, chMBGetUsedCountI(&mb1) == MB_SIZE, "not full");
+  n = chMBFetchN(&mb1, out, 2, TIME_INFINITE);
+  test_assert(5, n == 2, "wrong fetched count");
+  chSysLock();
+  n += chMBFetchNI(&mb1, &out[2], MB_SIZE * 2);
+  chSysUnlock();
+  test_assert(6, n == MB_SIZE, "wrong fetched count");
+  for (i = 0; i < n; i++)
+    test_emit_token(out[i]);
+  test_assert_sequence(7, "ABCDE");
+
+  /*
+   * Testing fetch timeout.
+   */
+  test_assert(8, chMBFetchN(&mb1, out, 1, TIME_IMMEDIATE) == 0,
+              "wrong timeout return");
+  test_assert_lock(9, chMBFetchNI(&mb1, out, 1) == 0, "not empty");
+
+  /*
+   * Testing buffer circularity.
+   */
+  chMBPostN(&mb1, in, 2, TIME_INFINITE);
+  chMBFetchN(&mb1, out, 2, TIME_INFINITE);
+  n = chMBPostN(&mb1, in, MB_SIZE, TIME_INFINITE);
+  test_assert(10, n == MB_SIZE, "wrong posted count");
+  n = chMBFetchN(&mb1, out, MB_SIZE * 2, TIME_INFINITE);
+  test_assert(11, n == MB_SIZE, "wrong fetched count");
+  for (i = 0; i < n; i++)
+    test_emit_token(out[i]);
+  test_assert_sequence(12, "ABCDE");
+
+  /*
+   * Testing the waiting thread.
+   */
+  threads[0] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriority() + 1,
+                                 thread2, NULL);
+  n = chMBPostN(&mb1, in, 3, TIME_INFINITE);
+  test_assert(13, n == 3, "wrong posted count");
+  test_wait_threads();
+  test_assert_sequence(14, "ABC");
+
+  /*
+   * Testing final conditions.
+   */
+  test_assert_lock(15, chMBGetFreeCountI(&mb1) == MB_SIZE, "not empty");
+  test_assert_lock(16, chMBGetUsedCountI(&mb1) == 0, "still full");
+  test_assert(17, mb1.mb_rdptr == mb1.mb_wrptr, "pointers not aligned");
+}
+
+ROMCONST struct testcase testmbox2 = {
+  "Mailboxes, batched post and fetch",
+  mbox2_setup,
+  NULL,
+  mbox2_execute
+};
+
 #endif /* CH_USE_MAILBOXES */
 
 /**
@@ -234,6 +333,7 @@ ROMCONST struct testcase testmbox1 = {
 ROMCONST struct testcase * ROMCONST patternmbox[] = {
 #if CH_USE_MAILBOXES || defined(__DOXYGEN__)
   &testmbox1,
+  &testmbox2,
 #endif
   NULL
 };
@@ -38,6 +38,7 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_msg_001
+ * - @subpage test_msg_002
  * .
  * @file testmsg.c
  * @brief Messages test source file
@@ -95,6 +96,93 @@ ROMCONST struct testcase testmsg1 = {
   msg1_execute
 };
 
+#if CH_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+/**
+ * @page test_msg_002 Asynchronous messages
+ *
+ * <h2>Description</h2>
+ * A server thread with lower priority is spawned, the tester posts three
+ * requests without blocking then waits for the last reply, the server
+ * fetches and completes the three requests as a single batch. The future
+ * polling and the immediate timeouts are also tested.<br>
+ * The test expects the requests to be processed in the correct sequence
+ * and the replies to be delivered to the proper futures.
+ */
+
+static MSGPORT_DECL(port1);
+
+static msg_t async_server(void *p) {
+  MsgPort *mpp = p;
+  MsgFuture *mfp, *batch;
+  bool_t done = FALSE;
+
+  do {
+    batch = chMsgPortFetch(mpp);
+    for (mfp = batch; mfp != NULL; mfp = chMsgFutureNext(mfp)) {
+      if (chMsgFutureGetMsg(mfp) == 0)
+        done = TRUE;
+      else
+        test_emit_token((char)chMsgFutureGetMsg(mfp));
+    }
+    test_emit_token('|');
+    /* Whole batch completed with a single reschedule.*/
+    chSysLock();
+    while (batch != NULL) {
+      mfp = batch;
+      batch = chMsgFutureNext(mfp);
+      chMsgCompleteI(mfp, chMsgFutureGetMsg(mfp) + 'a' - 'A');
+    }
+    chSchRescheduleS();
+    chSysUnlock();
+  } while (!done);
+  return 0;
+}
+
+static void msg2_setup(void) {
+
+  chMsgPortInit(&port1);
+}
+
+static void msg2_execute(void) {
+  MsgFuture f[3];
+
+  test_assert(1, chMsgPortFetchTimeout(&port1, TIME_IMMEDIATE) == NULL,
+              "not empty");
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority() - 1,
+                                 async_server, &port1);
+  chMsgPost(&port1, &f[0], 'A');
+  chMsgPost(&port1, &f[1], 'B');
+  chMsgPost(&port1, &f[2], 'C');
+  test_assert(2, !chMsgFutureIsDone(&f[0]), "already done");
+  test_assert(3, chMsgFutureWait(&f[2]) == 'c', "wrong reply");
+  test_assert(4, chMsgFutureIsDone(&f[0]) && chMsgFutureIsDone(&f[1]),
+              "not done");
+  test_assert(5, (chMsgFutureGetReply(&f[0]) == 'a') &&
+                 (chMsgFutureGetReply(&f[1]) == 'b'), "wrong reply");
+  test_assert_sequence(6, "ABC|");
+
+  /* Polling.*/
+  chMsgPost(&port1, &f[0], 'D');
+  test_assert(7, chMsgFutureWaitTimeout(&f[0], TIME_IMMEDIATE) == RDY_TIMEOUT,
+              "not timed out");
+  test_assert(8, chMsgFutureWait(&f[0]) == 'd', "wrong reply");
+  test_assert_sequence(9, "D|");
+
+  /* Server termination.*/
+  chMsgPost(&port1, &f[1], 0);
+  test_wait_threads();
+  test_assert(10, chMsgFutureIsDone(&f[1]), "not done");
+}
+
+ROMCONST struct testcase testmsg2 = {
+  "Messages, asynchronous ports",
+  msg2_setup,
+  NULL,
+  msg2_execute
+};
+#endif /* CH_USE_MESSAGES_ASYNC */
+
 #endif /* CH_USE_MESSAGES */
 
 /**
@@ -103,6 +191,9 @@ ROMCONST struct testcase testmsg1 = {
 ROMCONST struct testcase * ROMCONST patternmsg[] = {
 #if CH_USE_MESSAGES || defined(__DOXYGEN__)
   &testmsg1,
+#if CH_USE_MESSAGES_ASYNC || defined(__DOXYGEN__)
+  &testmsg2,
+#endif
 #endif
   NULL
 };
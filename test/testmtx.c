@@ -23,8 +23,8 @@
  * File: @ref testmtx.c
  *
  * <h2>Description</h2>
- * This module implements the test sequence for the @ref mutexes and
- * @ref condvars subsystems.<br>
+ * This module implements the test sequence for the @ref mutexes,
+ * @ref condvars and @ref rwlocks subsystems.<br>
  * Tests on those subsystems are particularly critical because the system-wide
  * implications of the Priority Inheritance mechanism.
  *
@@ -49,6 +49,9 @@
  * - @subpage test_mtx_006
  * - @subpage test_mtx_007
  * - @subpage test_mtx_008
+ * - @subpage test_mtx_009
+ * - @subpage test_mtx_010
+ * - @subpage test_mtx_011
  * .
  * @file testmtx.c
  * @brief Mutexes and CondVars test source file
@@ -70,6 +73,9 @@ static MUTEX_DECL(m2);
 #if CH_USE_CONDVARS || defined(__DOXYGEN__)
 static CONDVAR_DECL(c1);
 #endif
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+static RWLOCK_DECL(rw1);
+#endif
 
 /**
  * @page test_mtx_001 Priority enqueuing test
@@ -611,6 +617,249 @@ ROMCONST struct testcase testmtx8 = {
   mtx8_execute
 };
 #endif /* CH_USE_CONDVARS */
+
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+/**
+ * @page test_mtx_009 Priority ceiling test
+ *
+ * <h2>Description</h2>
+ * The tester thread locks two nested priority ceiling mutexes verifying that
+ * its priority is raised to the ceilings and restored on unlock. A thread
+ * with priority between the tester priority and the ceiling must not
+ * preempt the owner and, while the owner sleeps, must be queued on the mutex
+ * without boosting it, then it must acquire the mutex at the ceiling
+ * priority. A thread with priority above the ceiling must preempt the
+ * owner. Finally both the mutexes are locked again and released with
+ * @p chMtxUnlockAll(), the tester priority must be restored.
+ */
+
+static void mtx9_setup(void) {
+
+  chMtxInitCeiling(&m1, chThdGetPriority() + 2);
+  chMtxInitCeiling(&m2, chThdGetPriority() + 3);
+}
+
+static msg_t thread13(void *p) {
+
+  chMtxLock(&m1);
+  if (chThdGetPriority() == m1.m_ceiling)
+    test_emit_token(*(char *)p);
+  chMtxUnlock();
+  return 0;
+}
+
+static msg_t thread14(void *p) {
+
+  test_emit_token(*(char *)p);
+  return 0;
+}
+
+static void mtx9_execute(void) {
+
+  tprio_t prio = chThdGetPriority();
+  chMtxLock(&m1);
+  test_assert(1, chThdGetPriority() == prio + 2, "not raised to ceiling");
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread13, "B");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+3, thread14, "A");
+  test_assert_sequence(2, "A");
+  test_assert(3, chMtxTryLock(&m2), "not locked");
+  test_assert(4, chThdGetPriority() == prio + 3, "not raised to ceiling");
+  chMtxUnlock();
+  test_assert(5, chThdGetPriority() == prio + 2, "wrong priority level");
+  chThdSleepMilliseconds(10);
+  test_assert(6, notempty(&m1.m_queue), "not queued");
+  test_assert(7, chThdGetPriority() == prio + 2, "wrong priority level");
+  chMtxUnlock();
+  test_assert(8, chThdGetPriority() == prio, "wrong priority level");
+  test_wait_threads();
+  test_assert_sequence(9, "B");
+  chMtxLock(&m1);
+  chMtxLock(&m2);
+  test_assert(10, chThdGetPriority() == prio + 3, "not raised to ceiling");
+  chMtxUnlockAll();
+  test_assert(11, chThdGetPriority() == prio, "wrong priority level");
+}
+
+ROMCONST struct testcase testmtx9 = {
+  "Mutexes, priority ceiling",
+  mtx9_setup,
+  NULL,
+  mtx9_execute
+};
+#endif /* CH_USE_MUTEXES_CEILING */
+
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+/**
+ * @page test_mtx_010 Adaptive wait test
+ *
+ * <h2>Description</h2>
+ * A thread with the same priority of the tester locks a mutex and yields,
+ * the tester locking the mutex must yield back and acquire it without
+ * sleeping. Then the thread locks the mutex and sleeps, the tester has no
+ * thread to yield to and must sleep on the mutex.
+ */
+
+static void mtx10_setup(void) {
+
+  chMtxInit(&m1);
+  chMtxSetAdaptive(&m1, 4);
+}
+
+static msg_t thread15(void *p) {
+
+  chMtxLock(&m1);
+  if (p != NULL)
+    chThdSleepMilliseconds(10);
+  else
+    chThdYield();
+  chMtxUnlock();
+  return 0;
+}
+
+static void mtx10_execute(void) {
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority(),
+                                 thread15, NULL);
+  chThdYield();
+  test_assert(1, m1.m_owner == threads[0], "not owned");
+  chMtxLock(&m1);
+  chMtxUnlock();
+  test_assert(2, chMtxGetAdaptiveHits(&m1) == 1, "no hit");
+  test_assert(3, chMtxGetAdaptiveMisses(&m1) == 0, "unexpected miss");
+  test_wait_threads();
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority(),
+                                 thread15, "A");
+  chThdYield();
+  chMtxLock(&m1);
+  chMtxUnlock();
+  test_assert(4, chMtxGetAdaptiveHits(&m1) == 1, "unexpected hit");
+  test_assert(5, chMtxGetAdaptiveMisses(&m1) == 1, "no miss");
+  test_wait_threads();
+}
+
+ROMCONST struct testcase testmtx10 = {
+  "Mutexes, adaptive wait",
+  mtx10_setup,
+  NULL,
+  mtx10_execute
+};
+#endif /* CH_USE_ADAPTIVE_WAIT */
+
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+/**
+ * @page test_mtx_011 Readers-writer lock test
+ *
+ * <h2>Description</h2>
+ * The tester thread holds the lock as reader:
+ * - A reader with higher priority must be admitted.
+ * - A writer must become owner and wait for the tester, a reader with
+ *   higher priority arriving later must be queued behind the writer and
+ *   boost it. Releasing the tester read lock must run the writer and then
+ *   the reader.
+ * - A writer timing out while waiting for the tester must give up the
+ *   ownership and admit the reader queued behind it.
+ * .
+ * Then the tester holds the lock as writer, a reader timing out on the lock
+ * must restore the tester priority. Finally the lock held as writer is
+ * released by @p chMtxUnlockAll(), the queued readers must be admitted.
+ */
+
+static void mtx11_setup(void) {
+
+  chRWLockInit(&rw1);
+}
+
+static msg_t thread16(void *p) {
+
+  chRWLockReadLock(&rw1);
+  test_emit_token(*(char *)p);
+  chRWLockReadUnlock(&rw1);
+  return 0;
+}
+
+static msg_t thread17(void *p) {
+
+  if (chRWLockWriteLockTimeout(&rw1, MS2ST(10)) == RDY_OK) {
+    test_emit_token(*(char *)p);
+    chRWLockWriteUnlock(&rw1);
+  }
+  else
+    test_emit_token(*(char *)p + 1);
+  return 0;
+}
+
+static msg_t thread18(void *p) {
+
+  if (chRWLockReadLockTimeout(&rw1, MS2ST(10)) == RDY_TIMEOUT)
+    test_emit_token(*(char *)p);
+  else
+    chRWLockReadUnlock(&rw1);
+  return 0;
+}
+
+static void mtx11_execute(void) {
+
+  tprio_t prio = chThdGetPriority();
+
+  chRWLockReadLock(&rw1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread16, "A");
+  test_wait_threads();
+  test_assert_sequence(1, "A");
+  test_assert(2, chRWLockWriteLockTimeout(&rw1, TIME_IMMEDIATE) == RDY_TIMEOUT,
+              "not busy");
+
+  /* Writer preference and writer priority inheritance.*/
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread17, "B");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+2, thread16, "C");
+  test_assert(3, chRWLockGetWriterI(&rw1) == threads[0], "not owner");
+  test_assert(4, chRWLockGetReadersI(&rw1) == 1, "reader admitted");
+  test_assert(5, threads[0]->p_prio == prio+2, "writer not boosted");
+  chRWLockReadUnlock(&rw1);
+  test_wait_threads();
+  test_assert_sequence(6, "BC");
+  test_assert(7, chRWLockGetWriterI(&rw1) == NULL, "still owned");
+
+  /* Writer timeout while waiting for the readers.*/
+  chRWLockReadLock(&rw1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread17, "D");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+1, thread16, "F");
+  chThdSleepMilliseconds(50);
+  test_wait_threads();
+  test_assert_sequence(8, "EF");
+  test_assert(9, chRWLockGetWriterI(&rw1) == NULL, "still owned");
+  test_assert(10, chRWLockGetReadersI(&rw1) == 1, "wrong readers count");
+  chRWLockReadUnlock(&rw1);
+
+  /* Reader timeout while waiting for the writer.*/
+  chRWLockWriteLock(&rw1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread18, "G");
+  test_assert(11, chThdGetPriority() == prio+1, "writer not boosted");
+  chThdSleepMilliseconds(50);
+  test_assert_sequence(12, "G");
+  test_assert(13, chThdGetPriority() == prio, "wrong priority level");
+  chRWLockWriteUnlock(&rw1);
+  test_wait_threads();
+
+  /* Writer release by chMtxUnlockAll().*/
+  chRWLockWriteLock(&rw1);
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, prio+1, thread16, "I");
+  threads[1] = chThdCreateStatic(wa[1], WA_SIZE, prio+2, thread16, "H");
+  chMtxUnlockAll();
+  test_wait_threads();
+  test_assert_sequence(14, "HI");
+  test_assert(15, chRWLockGetWriterI(&rw1) == NULL, "still owned");
+  test_assert(16, chRWLockGetReadersI(&rw1) == 0, "wrong readers count");
+  test_assert(17, chThdGetPriority() == prio, "wrong priority level");
+}
+
+ROMCONST struct testcase testmtx11 = {
+  "Mutexes, readers-writer lock",
+  mtx11_setup,
+  NULL,
+  mtx11_execute
+};
+#endif /* CH_USE_RWLOCKS */
 #endif /* CH_USE_MUTEXES */
 
 /**
@@ -630,6 +879,15 @@ ROMCONST struct testcase * ROMCONST patternmtx[] = {
   &testmtx7,
   &testmtx8,
 #endif
+#if CH_USE_MUTEXES_CEILING || defined(__DOXYGEN__)
+  &testmtx9,
+#endif
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+  &testmtx10,
+#endif
+#if CH_USE_RWLOCKS || defined(__DOXYGEN__)
+  &testmtx11,
+#endif
 #endif
   NULL
 };
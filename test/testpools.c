@@ -37,6 +37,7 @@
  *
  * <h2>Test Cases</h2>
  * - @subpage test_pools_001
+ * - @subpage test_pools_002
  * .
  * @file testpools.c
  * @brief Memory Pools test source file
@@ -104,6 +105,172 @@ ROMCONST struct testcase testpools1 = {
   pools1_execute
 };
 
+#if CH_USE_MEMPOOLS_LOCKFREE || defined(__DOXYGEN__)
+/**
+ * @page test_pools_002 Lock-free pool stress test
+ *
+ * <h2>Description</h2>
+ * Four threads allocate two objects each from a lock-free pool, mark them,
+ * yield, check the marks and release them. At the same time a virtual timer
+ * callback allocates and releases objects from the ISR context. The pool is
+ * smaller than the demand so allocations also fail.<br>
+ * On the simulator the interrupts are served from the pool race window
+ * hook, between the read of the list head and the compare-and-swap, so the
+ * ISR and the threads preempted there change the head under the interrupted
+ * operation.<br>
+ * The test expects no object to be allocated twice, the compare-and-swap
+ * operations to be retried and to find all the objects back in the pool
+ * with consistent counters at the end.
+ */
+
+#define LFP_OBJECTS 6
+
+static LockFreePool lfp;
+static stkalign_t lfp_objects[LFP_OBJECTS][2];
+static VirtualTimer lfp_vt;
+static void *lfp_isr_obj;
+static bool_t lfp_corrupted;
+static bool_t lfp_stress;
+static bool_t lfp_in_isr;
+static uint32_t lfp_windows;
+static uint32_t lfp_allocs;
+static uint32_t lfp_frees;
+
+/*
+ * Lock-free pools race window hook, the simulated interrupts are served
+ * only from the threads, the hook is not re-entered from the callback.
+ */
+void test_lfpool_cas_hook(void) {
+
+  if (lfp_stress) {
+    lfp_windows++;
+#if defined(SIMULATOR)
+    if (!lfp_in_isr)
+      ChkIntSources();
+#endif
+  }
+}
+
+static void lfp_cb(void *p) {
+
+  (void)p;
+  chSysLockFromIsr();
+  lfp_in_isr = TRUE;
+  if (lfp_isr_obj != NULL) {
+    if (*(uintptr_t *)lfp_isr_obj != (uintptr_t)&lfp_vt)
+      lfp_corrupted = TRUE;
+    chLFPoolFree(&lfp, lfp_isr_obj);
+    lfp_frees++;
+  }
+  if ((lfp_isr_obj = chLFPoolAlloc(&lfp)) != NULL) {
+    *(uintptr_t *)lfp_isr_obj = (uintptr_t)&lfp_vt;
+    lfp_allocs++;
+  }
+  if ((chLFPoolGetUsed(&lfp) < 0) || (chLFPoolGetUsed(&lfp) > LFP_OBJECTS))
+    lfp_corrupted = TRUE;
+  lfp_in_isr = FALSE;
+  chVTSetI(&lfp_vt, 1, lfp_cb, NULL);
+  chSysUnlockFromIsr();
+}
+
+static msg_t lfp_thread(void *p) {
+  uintptr_t mark = (uintptr_t)chThdSelf();
+  void *p1, *p2;
+
+  (void)p;
+  do {
+    if ((p1 = chLFPoolAlloc(&lfp)) != NULL) {
+      *(uintptr_t *)p1 = mark;
+      lfp_allocs++;
+    }
+    if ((p2 = chLFPoolAlloc(&lfp)) != NULL) {
+      *(uintptr_t *)p2 = mark;
+      lfp_allocs++;
+    }
+    chThdYield();
+#if defined(SIMULATOR)
+    ChkIntSources();
+#endif
+    if (p1 != NULL) {
+      if (*(uintptr_t *)p1 != mark)
+        lfp_corrupted = TRUE;
+      chLFPoolFree(&lfp, p1);
+      lfp_frees++;
+    }
+    if (p2 != NULL) {
+      if (*(uintptr_t *)p2 != mark)
+        lfp_corrupted = TRUE;
+      chLFPoolFree(&lfp, p2);
+      lfp_frees++;
+    }
+  } while (!chThdShouldTerminate());
+  return 0;
+}
+
+static void pools2_setup(void) {
+
+  chLFPoolInit(&lfp, sizeof lfp_objects[0]);
+  lfp_isr_obj = NULL;
+  lfp_corrupted = FALSE;
+  lfp_in_isr = FALSE;
+  lfp_windows = 0;
+  lfp_allocs = 0;
+  lfp_frees = 0;
+}
+
+static void pools2_execute(void) {
+  unsigned i;
+
+  chLFPoolLoadArray(&lfp, lfp_objects, LFP_OBJECTS);
+  test_assert(1, chLFPoolGetUsed(&lfp) == 0, "wrong used count");
+
+  lfp_stress = TRUE;
+  chSysLock();
+  chVTSetI(&lfp_vt, 1, lfp_cb, NULL);
+  chSysUnlock();
+  for (i = 0; i < 4; i++)
+    threads[i] = chThdCreateStatic(wa[i], WA_SIZE, chThdGetPriority() - 1,
+                                   lfp_thread, NULL);
+  chThdSleepMilliseconds(250);
+  test_terminate_threads();
+  test_wait_threads();
+  chSysLock();
+  if (chVTIsArmedI(&lfp_vt))
+    chVTResetI(&lfp_vt);
+  chSysUnlock();
+  if (lfp_isr_obj != NULL) {
+    chLFPoolFree(&lfp, lfp_isr_obj);
+    lfp_frees++;
+  }
+  lfp_stress = FALSE;
+
+  test_assert(2, !lfp_corrupted, "pool corrupted");
+  test_assert(3, chLFPoolGetUsed(&lfp) == 0, "wrong used count");
+  test_assert(4, lfp_allocs == lfp_frees, "objects leaked");
+  test_assert(5, chLFPoolGetHighWater(&lfp) == LFP_OBJECTS,
+              "wrong high-water mark");
+  test_assert(6, chLFPoolGetFailures(&lfp) > 0, "no failures");
+#if defined(SIMULATOR)
+  /* Each successful operation performs one compare-and-swap on the head,
+     the extra windows are retries caused by the interrupts.*/
+  test_assert(7, lfp_windows > lfp_allocs + lfp_frees, "no retries");
+#endif
+
+  /* All the objects are back in the pool.*/
+  for (i = 0; i < LFP_OBJECTS; i++)
+    test_assert(8, chLFPoolAlloc(&lfp) != NULL, "list empty");
+  test_assert(9, chLFPoolAlloc(&lfp) == NULL, "list not empty");
+  test_assert(10, chLFPoolGetUsed(&lfp) == LFP_OBJECTS, "wrong used count");
+}
+
+ROMCONST struct testcase testpools2 = {
+  "Memory Pools, lock-free stress",
+  pools2_setup,
+  NULL,
+  pools2_execute
+};
+#endif /* CH_USE_MEMPOOLS_LOCKFREE */
+
 #endif /* CH_USE_MEMPOOLS */
 
 /*
@@ -112,6 +279,9 @@ ROMCONST struct testcase testpools1 = {
 ROMCONST struct testcase * ROMCONST patternpools[] = {
 #if CH_USE_MEMPOOLS || defined(__DOXYGEN__)
   &testpools1,
+#if CH_USE_MEMPOOLS_LOCKFREE || defined(__DOXYGEN__)
+  &testpools2,
+#endif
 #endif
   NULL
 };
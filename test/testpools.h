@@ -19,4 +19,12 @@
 
 extern ROMCONST struct testcase * ROMCONST patternpools[];
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+  void test_lfpool_cas_hook(void);
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _TESTPOOLS_H_ */
@@ -36,6 +36,7 @@
  * <h2>Preconditions</h2>
  * The module requires the following kernel options:
  * - @p CH_USE_QUEUES (and dependent options)
+ * - @p CH_USE_QUEUES_RINGS
  * .
  * In case some of the required options are not enabled then some or all tests
  * may be skipped.
@@ -43,6 +44,9 @@
  * <h2>Test Cases</h2>
  * - @subpage test_queues_001
  * - @subpage test_queues_002
+ * - @subpage test_queues_003
+ * - @subpage test_queues_004
+ * - @subpage test_queues_005
  * .
  * @file testqueues.c
  * @brief I/O Queues test source file
@@ -230,6 +234,323 @@ ROMCONST struct testcase testqueues2 = {
   NULL,
   queues2_execute
 };
+
+#if CH_USE_QUEUES_RINGS || defined(__DOXYGEN__)
+static void rnotify(ByteRing *rp) {
+  (void)rp;
+}
+
+static INPUTRING_DECL(iring, test.wa.T0, TEST_QUEUES_SIZE, rnotify, NULL);
+static OUTPUTRING_DECL(oring, test.wa.T1, TEST_QUEUES_SIZE, rnotify, NULL);
+
+/**
+ * @page test_queues_003 Input Rings functionality and APIs
+ *
+ * <h2>Description</h2>
+ * This test case tests sysnchronos and asynchronous operations on an
+ * @p InputRing object including bulk writes, wrap around and timeouts. The
+ * ring state must remain consistent through the whole test.
+ */
+
+static void queues3_setup(void) {
+
+  chIRInit(&iring, wa[0], TEST_QUEUES_SIZE, rnotify, NULL);
+}
+
+static msg_t thread3(void *p) {
+
+  (void)p;
+  chIRGetTimeout(&iring, MS2ST(200));
+  return 0;
+}
+
+static void queues3_execute(void) {
+  unsigned i;
+  size_t n;
+
+  /* Initial empty state */
+  test_assert_lock(1, chIRIsEmptyI(&iring), "not empty");
+
+  /* Ring filling */
+  chSysLock();
+  for (i = 0; i < TEST_QUEUES_SIZE; i++)
+    chIRPutI(&iring, 'A' + i);
+  chSysUnlock();
+  test_assert_lock(2, chIRIsFullI(&iring), "still has space");
+  test_assert_lock(3, chIRPutI(&iring, 0) == Q_FULL, "failed to report Q_FULL");
+
+  /* Ring emptying */
+  for (i = 0; i < TEST_QUEUES_SIZE; i++)
+    test_emit_token(chIRGet(&iring));
+  test_assert_lock(4, chIRIsEmptyI(&iring), "still full");
+  test_assert_sequence(5, "ABCD");
+
+  /* Bulk writes crossing the buffer end */
+  chSysLock();
+  chIRPutI(&iring, 0);
+  chSysUnlock();
+  (void)chIRGet(&iring);
+  chSysLock();
+  n = chIRWriteI(&iring, (const uint8_t *)"AB", 2);
+  chSysUnlock();
+  test_assert(6, n == 2, "wrong returned size");
+  chSysLock();
+  n = chIRWriteI(&iring, (const uint8_t *)"CDE", 3);
+  chSysUnlock();
+  test_assert(7, n == TEST_QUEUES_SIZE - 2, "wrong returned size");
+  test_assert_lock(8, chIRWriteI(&iring, (const uint8_t *)"E", 1) == 0,
+                   "not full");
+
+  /* Reading the whole thing */
+  n = chIRReadTimeout(&iring, wa[1], TEST_QUEUES_SIZE * 2, TIME_IMMEDIATE);
+  test_assert(9, n == TEST_QUEUES_SIZE, "wrong returned size");
+  for (i = 0; i < TEST_QUEUES_SIZE; i++)
+    test_emit_token(((uint8_t *)wa[1])[i]);
+  test_assert_sequence(10, "ABCD");
+  test_assert_lock(11, chIRIsEmptyI(&iring), "still full");
+
+  /* Partial reads */
+  chSysLock();
+  chIRWriteI(&iring, (const uint8_t *)"ABCD", TEST_QUEUES_SIZE);
+  chSysUnlock();
+  n = chIRReadTimeout(&iring, wa[1], TEST_QUEUES_SIZE / 2, TIME_IMMEDIATE);
+  test_assert(12, n == TEST_QUEUES_SIZE / 2, "wrong returned size");
+  n = chIRReadTimeout(&iring, wa[1], TEST_QUEUES_SIZE / 2, TIME_IMMEDIATE);
+  test_assert(13, n == TEST_QUEUES_SIZE / 2, "wrong returned size");
+  test_assert_lock(14, chIRIsEmptyI(&iring), "still full");
+
+  /* Testing reset */
+  chSysLock();
+  chIRPutI(&iring, 0);
+  chIRResetI(&iring);
+  chSysUnlock();
+  test_assert_lock(15, chIRGetFullI(&iring) == 0, "still full");
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread3, NULL);
+  test_assert_lock(16, chIRGetFullI(&iring) == 0, "not empty");
+  test_wait_threads();
+
+  /* Timeout */
+  test_assert(17, chIRGetTimeout(&iring, 10) == Q_TIMEOUT,
+              "wrong timeout return");
+}
+
+ROMCONST struct testcase testqueues3 = {
+  "Queues, input rings",
+  queues3_setup,
+  NULL,
+  queues3_execute
+};
+
+/**
+ * @page test_queues_004 Output Rings functionality and APIs
+ *
+ * <h2>Description</h2>
+ * This test case tests sysnchronos and asynchronous operations on an
+ * @p OutputRing object including bulk reads, wrap around and timeouts. The
+ * ring state must remain consistent through the whole test.
+ */
+
+static void queues4_setup(void) {
+
+  chORInit(&oring, wa[0], TEST_QUEUES_SIZE, rnotify, NULL);
+}
+
+static msg_t thread4(void *p) {
+
+  (void)p;
+  chORPutTimeout(&oring, 0, MS2ST(200));
+  return 0;
+}
+
+static void queues4_execute(void) {
+  unsigned i;
+  size_t n;
+  uint8_t buf[TEST_QUEUES_SIZE];
+
+  /* Initial empty state */
+  test_assert_lock(1, chORIsEmptyI(&oring), "not empty");
+
+  /* Ring filling */
+  for (i = 0; i < TEST_QUEUES_SIZE; i++)
+    chORPut(&oring, 'A' + i);
+  test_assert_lock(2, chORIsFullI(&oring), "still has space");
+
+  /* Ring emptying */
+  for (i = 0; i < TEST_QUEUES_SIZE; i++) {
+    char c;
+
+    chSysLock();
+    c = chORGetI(&oring);
+    chSysUnlock();
+    test_emit_token(c);
+  }
+  test_assert_lock(3, chORIsEmptyI(&oring), "still full");
+  test_assert_sequence(4, "ABCD");
+  test_assert_lock(5, chORGetI(&oring) == Q_EMPTY, "failed to report Q_EMPTY");
+
+  /* Writing the whole thing */
+  n = chORWriteTimeout(&oring, wa[1], TEST_QUEUES_SIZE * 2, TIME_IMMEDIATE);
+  test_assert(6, n == TEST_QUEUES_SIZE, "wrong returned size");
+  test_assert_lock(7, chORIsFullI(&oring), "not full");
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()+1,
+                                 thread4, NULL);
+  test_assert_lock(8, chORGetFullI(&oring) == TEST_QUEUES_SIZE, "not empty");
+  test_wait_threads();
+
+  /* Testing reset */
+  chSysLock();
+  chORResetI(&oring);
+  chSysUnlock();
+  test_assert_lock(9, chORGetFullI(&oring) == 0, "still full");
+
+  /* Bulk reads crossing the buffer end */
+  n = chORWriteTimeout(&oring, (const uint8_t *)"AB", 2, TIME_IMMEDIATE);
+  test_assert(10, n == 2, "wrong returned size");
+  test_assert_lock(11, chORReadI(&oring, buf, TEST_QUEUES_SIZE) == 2,
+                   "wrong returned size");
+  n = chORWriteTimeout(&oring, (const uint8_t *)"CDEF", TEST_QUEUES_SIZE,
+                       TIME_IMMEDIATE);
+  test_assert(12, n == TEST_QUEUES_SIZE, "wrong returned size");
+  test_assert_lock(13, chORReadI(&oring, buf, TEST_QUEUES_SIZE) ==
+                       TEST_QUEUES_SIZE, "wrong returned size");
+  for (i = 0; i < TEST_QUEUES_SIZE; i++)
+    test_emit_token(buf[i]);
+  test_assert_sequence(14, "CDEF");
+  test_assert_lock(15, chORReadI(&oring, buf, 1) == 0, "not empty");
+
+  /* Timeout */
+  chORWriteTimeout(&oring, wa[1], TEST_QUEUES_SIZE, TIME_IMMEDIATE);
+  test_assert(16, chORPutTimeout(&oring, 0, 10) == Q_TIMEOUT,
+              "wrong timeout return");
+}
+
+ROMCONST struct testcase testqueues4 = {
+  "Queues, output rings",
+  queues4_setup,
+  NULL,
+  queues4_execute
+};
+#endif /* CH_USE_QUEUES_RINGS */
+
+/**
+ * @page test_queues_005 Queues spans
+ *
+ * <h2>Description</h2>
+ * The span APIs are used on both sides of an @p InputQueue and of an
+ * @p OutputQueue, the data is written and read in place across the
+ * buffer end. The sequence of the extracted data and the queues state
+ * are checked.
+ */
+
+static void queues5_setup(void) {
+
+  chIQInit(&iq, wa[0], TEST_QUEUES_SIZE, notify, NULL);
+  chOQInit(&oq, wa[1], TEST_QUEUES_SIZE, notify, NULL);
+}
+
+static void emit_span(QueueSpan *sp) {
+  unsigned i, j;
+
+  for (i = 0; i < 2; i++)
+    for (j = 0; j < sp->qs_size[i]; j++)
+      test_emit_token(sp->qs_ptr[i][j]);
+}
+
+static void queues5_execute(void) {
+  QueueSpan s;
+  size_t n;
+
+  /* Input queue, writing in place.*/
+  chSysLock();
+  n = chIQGetWriteSpanI(&iq, &s);
+  chSysUnlock();
+  test_assert(1, (n == TEST_QUEUES_SIZE) &&
+                 (s.qs_size[0] == TEST_QUEUES_SIZE) && (s.qs_size[1] == 0),
+              "wrong span");
+  s.qs_ptr[0][0] = 'A';
+  s.qs_ptr[0][1] = 'B';
+  chSysLock();
+  chIQCommitWriteI(&iq, 2);
+  chSysUnlock();
+  test_assert_lock(2, chIQGetFullI(&iq) == 2, "wrong size");
+
+  /* Input queue, reading in place.*/
+  n = chIQGetReadSpanTimeout(&iq, &s, TIME_IMMEDIATE);
+  test_assert(3, (n == 2) && (s.qs_ptr[0][0] == 'A'), "wrong span");
+  chIQCommitRead(&iq, 1);
+
+  /* Input queue, writing across the buffer end.*/
+  chSysLock();
+  n = chIQGetWriteSpanI(&iq, &s);
+  chSysUnlock();
+  test_assert(4, (n == 3) && (s.qs_size[0] == 2) && (s.qs_size[1] == 1),
+              "wrong span");
+  s.qs_ptr[0][0] = 'C';
+  s.qs_ptr[0][1] = 'D';
+  s.qs_ptr[1][0] = 'E';
+  chSysLock();
+  chIQCommitWriteI(&iq, 3);
+  chSysUnlock();
+  test_assert_lock(5, chIQIsFullI(&iq), "not full");
+
+  /* Input queue, reading across the buffer end.*/
+  n = chIQGetReadSpanTimeout(&iq, &s, TIME_IMMEDIATE);
+  test_assert(6, n == TEST_QUEUES_SIZE, "wrong span");
+  emit_span(&s);
+  test_assert_sequence(7, "BCDE");
+  chIQCommitRead(&iq, n);
+  test_assert_lock(8, chIQIsEmptyI(&iq), "not empty");
+  test_assert(9, chIQGetReadSpanTimeout(&iq, &s, TIME_IMMEDIATE) == 0,
+              "wrong timeout return");
+
+  /* Output queue, writing in place.*/
+  n = chOQGetWriteSpanTimeout(&oq, &s, TIME_IMMEDIATE);
+  test_assert(10, n == TEST_QUEUES_SIZE, "wrong span");
+  s.qs_ptr[0][0] = 'A';
+  s.qs_ptr[0][1] = 'B';
+  s.qs_ptr[0][2] = 'C';
+  s.qs_ptr[0][3] = 'D';
+  chOQCommitWrite(&oq, n);
+  test_assert_lock(11, chOQIsFullI(&oq), "not full");
+  test_assert(12, chOQGetWriteSpanTimeout(&oq, &s, TIME_IMMEDIATE) == 0,
+              "wrong timeout return");
+
+  /* Output queue, reading in place.*/
+  chSysLock();
+  n = chOQGetReadSpanI(&oq, &s);
+  chOQCommitReadI(&oq, 2);
+  chSysUnlock();
+  test_assert(13, (n == TEST_QUEUES_SIZE) && (s.qs_ptr[0][0] == 'A'),
+              "wrong span");
+
+  /* Output queue, reading across the buffer end.*/
+  n = chOQGetWriteSpanTimeout(&oq, &s, TIME_IMMEDIATE);
+  test_assert(14, (n == 2) && (s.qs_size[1] == 0), "wrong span");
+  s.qs_ptr[0][0] = 'E';
+  s.qs_ptr[0][1] = 'F';
+  chOQCommitWrite(&oq, n);
+  chSysLock();
+  n = chOQGetReadSpanI(&oq, &s);
+  chSysUnlock();
+  test_assert(15, (n == TEST_QUEUES_SIZE) && (s.qs_size[1] == 2),
+              "wrong span");
+  emit_span(&s);
+  test_assert_sequence(16, "CDEF");
+
+  /* The commit is limited to the available data.*/
+  chSysLock();
+  chOQCommitReadI(&oq, TEST_QUEUES_SIZE * 2);
+  chSysUnlock();
+  test_assert_lock(17, chOQIsEmptyI(&oq), "not empty");
+}
+
+ROMCONST struct testcase testqueues5 = {
+  "Queues, spans",
+  queues5_setup,
+  NULL,
+  queues5_execute
+};
 #endif /* CH_USE_QUEUES */
 
 /**
@@ -239,6 +560,11 @@ ROMCONST struct testcase * ROMCONST patternqueues[] = {
 #if CH_USE_QUEUES || defined(__DOXYGEN__)
   &testqueues1,
   &testqueues2,
+#if CH_USE_QUEUES_RINGS || defined(__DOXYGEN__)
+  &testqueues3,
+  &testqueues4,
+#endif
+  &testqueues5,
 #endif
   NULL
 };
@@ -40,6 +40,7 @@
  * - @subpage test_sem_002
  * - @subpage test_sem_003
  * - @subpage test_sem_004
+ * - @subpage test_sem_005
  * .
  * @file testsem.c
  * @brief Semaphores test source file
@@ -284,6 +285,53 @@ ROMCONST struct testcase testsem4 = {
   NULL,
   sem4_execute
 };
+
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+/**
+ * @page test_sem_005 Adaptive wait
+ *
+ * <h2>Description</h2>
+ * A thread with the same priority of the tester signals a semaphore, the
+ * tester waiting on the semaphore must yield to the thread and take the
+ * semaphore without sleeping. Then the tester waits with timeout with no
+ * other thread able to signal, the wait must end sleeping.
+ */
+
+static void sem5_setup(void) {
+
+  chSemInit(&sem1, 0);
+  chSemSetAdaptive(&sem1, 4);
+}
+
+static msg_t thread5(void *p) {
+
+  chSemSignal((Semaphore *)p);
+  return 0;
+}
+
+static void sem5_execute(void) {
+
+  threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority(),
+                                 thread5, &sem1);
+  test_assert(1, chSemWait(&sem1) == RDY_OK, "wrong wake-up message");
+  test_assert(2, chSemGetAdaptiveHits(&sem1) == 1, "no hit");
+  test_assert(3, chSemGetAdaptiveMisses(&sem1) == 0, "unexpected miss");
+  test_wait_threads();
+
+  test_assert(4, chSemWaitTimeout(&sem1, MS2ST(10)) == RDY_TIMEOUT,
+              "wrong wake-up message");
+  test_assert(5, chSemGetAdaptiveHits(&sem1) == 1, "unexpected hit");
+  test_assert(6, chSemGetAdaptiveMisses(&sem1) == 1, "no miss");
+  test_assert(7, chSemGetCounterI(&sem1) == 0, "counter not zero");
+}
+
+ROMCONST struct testcase testsem5 = {
+  "Semaphores, adaptive wait",
+  sem5_setup,
+  NULL,
+  sem5_execute
+};
+#endif /* CH_USE_ADAPTIVE_WAIT */
 #endif /* CH_USE_SEMAPHORES */
 
 /**
@@ -297,6 +345,9 @@ ROMCONST struct testcase * ROMCONST patternsem[] = {
   &testsem3,
 #endif
   &testsem4,
+#if CH_USE_ADAPTIVE_WAIT || defined(__DOXYGEN__)
+  &testsem5,
+#endif
 #endif
   NULL
 };
@@ -40,6 +40,7 @@
  * - @subpage test_threads_002
  * - @subpage test_threads_003
  * - @subpage test_threads_004
+ * - @subpage test_threads_005
  * .
  * @file testthd.c
  * @brief Threads and Scheduler test source file
@@ -219,6 +220,62 @@ ROMCONST struct testcase testthd4 = {
   thd4_execute
 };
 
+#if CH_DBG_FILL_THREADS || defined(__DOXYGEN__)
+/**
+ * @page test_threads_005 Stack usage test
+ *
+ * <h2>Description</h2>
+ * Two threads with different stack frames are created, both threads yield
+ * once and terminate, then their stacks are scanned.<br>
+ * The test expects the stack size to match the working area and the
+ * thread with the bigger frame to leave less unused stack.
+ */
+
+static msg_t thread5a(void *p) {
+
+  (void)p;
+  chThdYield();
+  return 0;
+}
+
+static msg_t thread5b(void *p) {
+  volatile uint8_t buf[256];
+  unsigned i;
+
+  for (i = 0; i < sizeof buf; i++)
+    buf[i] = (uint8_t)i;
+  chThdYield();
+  return (msg_t)buf[(size_t)p];
+}
+
+static void thd5_execute(void) {
+  Thread *tpa, *tpb;
+  size_t unused_a, unused_b;
+
+  tpa = threads[0] = chThdCreateStatic(wa[0], WA_SIZE, chThdGetPriority()-1,
+                                       thread5a, NULL);
+  tpb = threads[1] = chThdCreateStatic(wa[1], WA_SIZE, chThdGetPriority()-1,
+                                       thread5b, NULL);
+  test_wait_threads();
+
+  /* The static working areas are still valid after termination.*/
+  test_assert(1, chThdGetStackSize(tpa) == WA_SIZE - sizeof(Thread),
+              "wrong stack size");
+  unused_a = chThdGetStackUnused(tpa);
+  unused_b = chThdGetStackUnused(tpb);
+  test_assert(2, (unused_a > 0) && (unused_a < WA_SIZE - sizeof(Thread)),
+              "stack not scanned");
+  test_assert(3, unused_b + 128 <= unused_a, "wrong stack usage");
+}
+
+ROMCONST struct testcase testthd5 = {
+  "Threads, stack usage",
+  NULL,
+  NULL,
+  thd5_execute
+};
+#endif /* CH_DBG_FILL_THREADS */
+
 /**
  * @brief   Test sequence for threads.
  */
@@ -227,5 +284,8 @@ ROMCONST struct testcase * ROMCONST patternthd[] = {
   &testthd2,
   &testthd3,
   &testthd4,
+#if CH_DBG_FILL_THREADS || defined(__DOXYGEN__)
+  &testthd5,
+#endif
   NULL
 };
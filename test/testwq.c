@@ -0,0 +1,197 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "ch.h"
+#include "test.h"
+
+/**
+ * @page test_wq Work queues test
+ *
+ * File: @ref testwq.c
+ *
+ * <h2>Description</h2>
+ * This module implements the test sequence for the @ref workqueues
+ * subsystem.
+ *
+ * <h2>Objective</h2>
+ * Objective of the test module is to cover 100% of the @ref workqueues
+ * code.
+ *
+ * <h2>Preconditions</h2>
+ * The module requires the following kernel options:
+ * - @p CH_USE_WORKQUEUES
+ * .
+ * In case some of the required options are not enabled then some or all tests
+ * may be skipped.
+ *
+ * <h2>Test Cases</h2>
+ * - @subpage test_wq_001
+ * - @subpage test_wq_002
+ * .
+ * @file testwq.c
+ * @brief Work queues test source file
+ * @file testwq.h
+ * @brief Work queues test header file
+ */
+
+#if CH_USE_WORKQUEUES || defined(__DOXYGEN__)
+
+static WORKQUEUE_DECL(wq1);
+static WORKQUEUE_DECL(wq2);
+static WorkItem wi1, wi2, wi3;
+
+static void wq_setup(void) {
+
+  chWQInit(&wq1);
+  chWQInit(&wq2);
+}
+
+static void work1(void *p) {
+
+  test_emit_token(*(char *)p);
+}
+
+/**
+ * @page test_wq_001 Priority tiers and duplicates suppression
+ *
+ * <h2>Description</h2>
+ * Two work queues are served by workers with different priorities, from an
+ * emulated interrupt handler two items are enqueued on the lower priority
+ * queue, one item on the higher priority queue, the first item is
+ * enqueued again and the higher priority item is enqueued on the lower
+ * priority queue.<br>
+ * The test expects the higher priority item to be executed first, the
+ * other items to be executed in FIFO order within a single batch and the
+ * duplicate requests to be suppressed and counted by the queue the items
+ * were pending on.
+ */
+
+static void wq1_execute(void) {
+  bool_t b1, b2;
+
+  threads[0] = chWQStart(&wq1, wa[0], WA_SIZE, chThdGetPriority()+1, "wq1");
+  threads[1] = chWQStart(&wq2, wa[1], WA_SIZE, chThdGetPriority()+2, "wq2");
+  chWIInit(&wi1, work1, "A");
+  chWIInit(&wi2, work1, "B");
+  chWIInit(&wi3, work1, "C");
+
+  chSysLock();
+  chWQEnqueueI(&wq1, &wi1);
+  chWQEnqueueI(&wq1, &wi2);
+  chWQEnqueueI(&wq2, &wi3);
+  b1 = chWQEnqueueI(&wq1, &wi1);
+  b2 = chWQEnqueueI(&wq1, &wi3);
+  chSchRescheduleS();
+  chSysUnlock();
+  test_assert(1, !b1 && !b2, "duplicate not suppressed");
+  test_assert_sequence(2, "CAB");
+  test_assert_lock(3, !chWIIsPendingI(&wi1), "still pending");
+  test_assert_lock(4, chWQGetStatsI(&wq1)->ws_executed == 2,
+                   "wrong executed count");
+  test_assert_lock(5, chWQGetStatsI(&wq1)->ws_dups == 1,
+                   "wrong duplicates count");
+  test_assert_lock(6, chWQGetStatsI(&wq2)->ws_dups == 1,
+                   "wrong duplicates count");
+  test_assert_lock(7, chWQGetStatsI(&wq1)->ws_batches == 1,
+                   "wrong batches count");
+  test_assert_lock(8, chWQGetStatsI(&wq1)->ws_maxbatch == 2,
+                   "wrong batch size");
+  test_assert_lock(9, chWQGetStatsI(&wq1)->ws_minlat <=
+                      chWQGetStatsI(&wq1)->ws_maxlat, "wrong latencies");
+#if CH_USE_REGISTRY
+  test_assert(10, chRegGetThreadName(threads[1]) == wq2.wq_name,
+              "wrong worker name");
+#endif
+
+  chWQStop(&wq1);
+  chWQStop(&wq2);
+  test_wait_threads();
+  test_assert(11, wq1.wq_worker == NULL, "worker not stopped");
+}
+
+ROMCONST struct testcase testwq1 = {
+  "Work queues, priority tiers and duplicates",
+  wq_setup,
+  NULL,
+  wq1_execute
+};
+
+/**
+ * @page test_wq_002 Items enqueued while running
+ *
+ * <h2>Description</h2>
+ * A work function enqueues its own item again until it has been executed
+ * three times, a queue stopped with pending items executes them before
+ * terminating the worker, then an item is enqueued on the stopped queue.<br>
+ * The test expects all the executions to be performed in a single batch,
+ * the pending items to be executed on stop and the stopped queue to
+ * reject the item without leaving it pending.
+ */
+
+static unsigned wq2_count;
+
+static void work2(void *p) {
+
+  test_emit_token(*(char *)p);
+  if (++wq2_count < 3)
+    chWQEnqueue(&wq1, &wi1);
+}
+
+static void wq2_execute(void) {
+
+  wq2_count = 0;
+  chWIInit(&wi1, work2, "A");
+  chWIInit(&wi2, work1, "B");
+  threads[0] = chWQStart(&wq1, wa[0], WA_SIZE, chThdGetPriority()+1, "wq1");
+  chWQEnqueue(&wq1, &wi1);
+  test_assert_sequence(1, "AAA");
+  test_assert_lock(2, chWQGetStatsI(&wq1)->ws_batches == 1,
+                   "wrong batches count");
+  test_assert_lock(3, chWQGetStatsI(&wq1)->ws_maxbatch == 3,
+                   "wrong batch size");
+
+  /* Stopping a queue with a pending item, the worker is made ready but
+     not rescheduled before the stop request.*/
+  chSysLock();
+  chWQEnqueueI(&wq1, &wi2);
+  chSysUnlock();
+  chWQStop(&wq1);
+  test_wait_threads();
+  test_assert_sequence(4, "B");
+
+  /* Enqueuing on the stopped queue.*/
+  test_assert(5, !chWQEnqueue(&wq1, &wi2), "not rejected");
+  test_assert_lock(6, !chWIIsPendingI(&wi2), "still pending");
+}
+
+ROMCONST struct testcase testwq2 = {
+  "Work queues, enqueue while running",
+  wq_setup,
+  NULL,
+  wq2_execute
+};
+#endif /* CH_USE_WORKQUEUES */
+
+/**
+ * @brief   Test sequence for work queues.
+ */
+ROMCONST struct testcase * ROMCONST patternwq[] = {
+#if CH_USE_WORKQUEUES || defined(__DOXYGEN__)
+  &testwq1,
+  &testwq2,
+#endif
+  NULL
+};
@@ -0,0 +1,348 @@
+/*
+    ChibiOS/RT - Copyright (C) 2006-2013 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/**
+ * @file    chtrace.c
+ * @brief   Host side decoder for the kernel trace stream.
+ * @details The decoder reads a capture produced by @p chDbgTraceStart() and
+ *          @p chDbgTraceDrain() and prints:
+ *          - The events timeline (option -t).
+ *          - Per-thread wakeup latency histograms, the latency is the time
+ *            between a thread being made ready and the thread being
+ *            switched in.
+ *          - The ISR durations histogram.
+ *          - The priority inversions, a thread has been switched in while
+ *            a thread with higher priority was waiting in the ready list.
+ *          .
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/*===========================================================================*/
+/* Stream format, see chdebug.h.                                             */
+/*===========================================================================*/
+
+#define TRACE_TYPE_SWITCH       1
+#define TRACE_TYPE_READY        2
+#define TRACE_TYPE_ISR_ENTER    3
+#define TRACE_TYPE_ISR_LEAVE    4
+#define TRACE_TYPE_VT_FIRE      5
+#define TRACE_TYPE_SEM_WAIT     6
+#define TRACE_TYPE_SEM_SIGNAL   7
+#define TRACE_TYPE_MTX_LOCK     8
+#define TRACE_TYPE_MTX_UNLOCK   9
+#define TRACE_TYPE_MTX_BOOST    10
+#define TRACE_TYPE_MB_POST      11
+#define TRACE_TYPE_MB_FETCH     12
+
+#define TRACE_STREAM_NAME       0x80
+#define TRACE_STREAM_LOST       0x81
+#define TRACE_STREAM_VERSION    1
+
+/*===========================================================================*/
+/* Decoder settings.                                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Maximum number of threads tracked.
+ */
+#define MAX_THREADS             256
+
+/**
+ * @brief   Number of histogram buckets, bucket @p n counts the values
+ *          between <tt>2^(n-1)</tt> and <tt>2^n</tt> microseconds.
+ */
+#define HIST_BUCKETS            24
+
+/**
+ * @brief   Maximum number of priority inversions printed.
+ */
+#define MAX_INVERSIONS_PRINTED  32
+
+/*===========================================================================*/
+/* Decoder data structures.                                                  */
+/*===========================================================================*/
+
+typedef struct {
+  unsigned long long    count;
+  double                min;
+  double                max;
+  double                sum;
+  unsigned long long    buckets[HIST_BUCKETS];
+} histogram_t;
+
+typedef struct {
+  uint64_t              id;
+  char                  name[256];
+  int                   ready;
+  double                ready_time;
+  unsigned              prio;
+  unsigned long long    inversions;
+  histogram_t           latency;
+} thread_t;
+
+static const char *type_names[] = {
+  "?", "SWITCH", "READY", "ISR_ENTER", "ISR_LEAVE", "VT_FIRE", "SEM_WAIT",
+  "SEM_SIGNAL", "MTX_LOCK", "MTX_UNLOCK", "MTX_BOOST", "MB_POST", "MB_FETCH"
+};
+
+static thread_t threads[MAX_THREADS];
+static unsigned nthreads;
+static histogram_t isr_hist;
+static unsigned long long lost_events;
+static unsigned long long inversions_printed;
+static int timeline;
+
+/*===========================================================================*/
+/* Decoder local functions.                                                  */
+/*===========================================================================*/
+
+static thread_t *get_thread(uint64_t id) {
+  unsigned i;
+
+  for (i = 0; i < nthreads; i++)
+    if (threads[i].id == id)
+      return &threads[i];
+  if (nthreads >= MAX_THREADS) {
+    fprintf(stderr, "chtrace: too many threads\n");
+    exit(1);
+  }
+  threads[nthreads].id = id;
+  snprintf(threads[nthreads].name, sizeof threads[nthreads].name,
+           "%#llx", (unsigned long long)id);
+  return &threads[nthreads++];
+}
+
+static void hist_add(histogram_t *hp, double us) {
+  unsigned b = 0;
+
+  if ((hp->count == 0) || (us < hp->min))
+    hp->min = us;
+  if ((hp->count == 0) || (us > hp->max))
+    hp->max = us;
+  hp->count++;
+  hp->sum += us;
+  while ((b < HIST_BUCKETS - 1) && (us >= (double)(1UL << b)))
+    b++;
+  hp->buckets[b]++;
+}
+
+static void hist_print(const char *title, const histogram_t *hp) {
+  unsigned b;
+
+  if (hp->count == 0)
+    return;
+  printf("%s: %llu samples, min %.3f us, avg %.3f us, max %.3f us\n",
+         title, hp->count, hp->min, hp->sum / (double)hp->count, hp->max);
+  for (b = 0; b < HIST_BUCKETS; b++) {
+    if (hp->buckets[b] == 0)
+      continue;
+    if (b == 0)
+      printf("  %10s < %-8lu us : %llu\n", "", 1UL, hp->buckets[b]);
+    else if (b == HIST_BUCKETS - 1)
+      printf("  %10lu <= %-8s us : %llu\n", 1UL << (b - 1), "",
+             hp->buckets[b]);
+    else
+      printf("  %10lu .. %-8lu us : %llu\n", 1UL << (b - 1), 1UL << b,
+             hp->buckets[b]);
+  }
+}
+
+static int get_byte(FILE *f, unsigned *bp) {
+  int c = fgetc(f);
+
+  if (c == EOF)
+    return -1;
+  *bp = (unsigned)c;
+  return 0;
+}
+
+static int get_varint(FILE *f, uint64_t *vp) {
+  unsigned shift = 0, b;
+  uint64_t v = 0;
+
+  do {
+    if ((get_byte(f, &b) < 0) || (shift > 63))
+      return -1;
+    v |= (uint64_t)(b & 0x7F) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  *vp = v;
+  return 0;
+}
+
+/*===========================================================================*/
+/* Decoder main.                                                             */
+/*===========================================================================*/
+
+int main(int argc, char *argv[]) {
+  FILE *f = stdin;
+  unsigned char hdr[10];
+  uint32_t freq;
+  uint64_t time = 0;
+  thread_t *running = NULL;
+  double isr_enter = 0.0;
+  unsigned isr_nesting = 0, i;
+  int argi;
+
+  for (argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "-t") == 0)
+      timeline = 1;
+    else if (argv[argi][0] == '-') {
+      fprintf(stderr, "usage: chtrace [-t] [capture]\n");
+      return 1;
+    }
+    else if ((f = fopen(argv[argi], "rb")) == NULL) {
+      perror(argv[argi]);
+      return 1;
+    }
+  }
+
+  if ((fread(hdr, 1, sizeof hdr, f) != sizeof hdr) ||
+      (memcmp(hdr, "CHTR", 4) != 0)) {
+    fprintf(stderr, "chtrace: not a trace capture\n");
+    return 1;
+  }
+  if (hdr[4] != TRACE_STREAM_VERSION) {
+    fprintf(stderr, "chtrace: unsupported format version %u\n", hdr[4]);
+    return 1;
+  }
+  freq = (uint32_t)hdr[6] | ((uint32_t)hdr[7] << 8) |
+         ((uint32_t)hdr[8] << 16) | ((uint32_t)hdr[9] << 24);
+  if (freq == 0) {
+    fprintf(stderr, "chtrace: invalid timestamps frequency\n");
+    return 1;
+  }
+
+  while (1) {
+    unsigned type, state, prio, len;
+    uint64_t dt, tpid, obj;
+    thread_t *tp;
+    double us;
+
+    if (get_byte(f, &type) < 0)
+      break;
+
+    if (type == TRACE_STREAM_NAME) {
+      if ((get_varint(f, &tpid) < 0) || (get_byte(f, &len) < 0))
+        goto truncated;
+      tp = get_thread(tpid);
+      if (fread(tp->name, 1, len, f) != len)
+        goto truncated;
+      tp->name[len] = '\0';
+      continue;
+    }
+
+    if (type == TRACE_STREAM_LOST) {
+      if (get_varint(f, &dt) < 0)
+        goto truncated;
+      lost_events += dt;
+      /* The state is no more reliable.*/
+      for (i = 0; i < nthreads; i++)
+        threads[i].ready = 0;
+      running = NULL;
+      isr_nesting = 0;
+      if (timeline)
+        printf("--- %llu events lost\n", (unsigned long long)dt);
+      continue;
+    }
+
+    if ((get_byte(f, &state) < 0) || (get_byte(f, &prio) < 0) ||
+        (get_varint(f, &dt) < 0) || (get_varint(f, &tpid) < 0) ||
+        (get_varint(f, &obj) < 0))
+      goto truncated;
+    time += dt;
+    us = (double)time * 1000000.0 / (double)freq;
+    tp = tpid != 0 ? get_thread(tpid) : NULL;
+
+    if (timeline)
+      printf("%14.3f us  %-10s  %-16s  prio %3u  state %2u  obj %#llx\n",
+             us, type < sizeof type_names / sizeof type_names[0] ?
+                 type_names[type] : "?",
+             tp != NULL ? tp->name : "-", prio, state,
+             (unsigned long long)obj);
+
+    switch (type) {
+    case TRACE_TYPE_SWITCH:
+      if (tp == NULL)
+        break;
+      /* Any thread with higher priority waiting in the ready list is a
+         priority inversion.*/
+      for (i = 0; i < nthreads; i++) {
+        thread_t *rtp = &threads[i];
+
+        if ((rtp != tp) && rtp->ready && (rtp->prio > prio)) {
+          rtp->inversions++;
+          if (inversions_printed++ < MAX_INVERSIONS_PRINTED)
+            printf("inversion at %.3f us: %s (prio %u) ready since %.3f us, "
+                   "%s (prio %u) switched in\n",
+                   us, rtp->name, rtp->prio, rtp->ready_time, tp->name, prio);
+        }
+      }
+      if (tp->ready) {
+        hist_add(&tp->latency, us - tp->ready_time);
+        tp->ready = 0;
+      }
+      tp->prio = prio;
+      running = tp;
+      break;
+    case TRACE_TYPE_READY:
+      /* A preempted thread is not waking up.*/
+      if ((tp == NULL) || (tp == running))
+        break;
+      tp->ready = 1;
+      tp->ready_time = us;
+      tp->prio = prio;
+      break;
+    case TRACE_TYPE_MTX_BOOST:
+      if (tp != NULL)
+        tp->prio = prio;
+      break;
+    case TRACE_TYPE_ISR_ENTER:
+      if (isr_nesting++ == 0)
+        isr_enter = us;
+      break;
+    case TRACE_TYPE_ISR_LEAVE:
+      if ((isr_nesting > 0) && (--isr_nesting == 0))
+        hist_add(&isr_hist, us - isr_enter);
+      break;
+    default:
+      break;
+    }
+  }
+
+  printf("\n");
+  for (i = 0; i < nthreads; i++) {
+    char title[300];
+
+    snprintf(title, sizeof title, "thread %s wakeup latency",
+             threads[i].name);
+    hist_print(title, &threads[i].latency);
+    if (threads[i].inversions > 0)
+      printf("  priority inversions: %llu\n", threads[i].inversions);
+  }
+  hist_print("ISR duration", &isr_hist);
+  if (lost_events > 0)
+    printf("lost events: %llu\n", lost_events);
+  return 0;
+
+truncated:
+  fprintf(stderr, "chtrace: truncated capture\n");
+  return 1;
+}